@@ -0,0 +1,298 @@
+#include <string.h>
+#include <endian.h>
+#include "asn1/ber/anonymizer.h"
+#include "asn1/ber/memory_reader.h"
+
+// Rotate left.
+static inline uint64_t rotl(uint64_t x, unsigned b)
+{
+  return (x << b) | (x >> (64 - b));
+}
+
+// SipHash round.
+static inline void sipround(uint64_t& v0,
+                            uint64_t& v1,
+                            uint64_t& v2,
+                            uint64_t& v3)
+{
+  v0 += v1;
+  v1 = rotl(v1, 13);
+  v1 ^= v0;
+  v0 = rotl(v0, 32);
+
+  v2 += v3;
+  v3 = rotl(v3, 16);
+  v3 ^= v2;
+
+  v0 += v3;
+  v3 = rotl(v3, 21);
+  v3 ^= v0;
+
+  v2 += v1;
+  v1 = rotl(v1, 17);
+  v1 ^= v2;
+  v2 = rotl(v2, 32);
+}
+
+// SipHash-2-4.
+static uint64_t siphash(uint64_t k0, uint64_t k1, const void* buf, size_t len)
+{
+  const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+  uint64_t v0 = k0 ^ 0x736f6d6570736575ull;
+  uint64_t v1 = k1 ^ 0x646f72616e646f6dull;
+  uint64_t v2 = k0 ^ 0x6c7967656e657261ull;
+  uint64_t v3 = k1 ^ 0x7465646279746573ull;
+
+  const uint8_t* end = b + (len & ~static_cast<size_t>(0x07));
+
+  for (; b < end; b += 8) {
+    uint64_t m;
+    memcpy(&m, b, sizeof(uint64_t));
+    m = le64toh(m);
+
+    v3 ^= m;
+
+    sipround(v0, v1, v2, v3);
+    sipround(v0, v1, v2, v3);
+
+    v0 ^= m;
+  }
+
+  // Last block: the remaining bytes and the length.
+  uint64_t m = static_cast<uint64_t>(len) << 56;
+
+  for (size_t i = 0; i < (len & 0x07); i++) {
+    m |= static_cast<uint64_t>(b[i]) << (i << 3);
+  }
+
+  v3 ^= m;
+
+  sipround(v0, v1, v2, v3);
+  sipround(v0, v1, v2, v3);
+
+  v0 ^= m;
+
+  v2 ^= 0xff;
+
+  sipround(v0, v1, v2, v3);
+  sipround(v0, v1, v2, v3);
+  sipround(v0, v1, v2, v3);
+  sipround(v0, v1, v2, v3);
+
+  return v0 ^ v1 ^ v2 ^ v3;
+}
+
+// Next pseudo-random number of the sequence 'state' (SplitMix64).
+static inline uint64_t next_random(uint64_t& state)
+{
+  uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+  return z ^ (z >> 31);
+}
+
+void asn1::ber::anonymizer::key(const void* buf, size_t len)
+{
+  _M_k0 = siphash(0, 0, buf, len);
+  _M_k1 = siphash(_M_k0, 0, buf, len);
+}
+
+bool asn1::ber::anonymizer::add(const char* s)
+{
+  if (_M_nrules == max_rules) {
+    return false;
+  }
+
+  // The action follows the last '='.
+  const char* eq;
+  if ((eq = strrchr(s, '=')) == nullptr) {
+    return false;
+  }
+
+  char p[1024];
+  size_t len = eq - s;
+  if (len >= sizeof(p)) {
+    return false;
+  }
+
+  memcpy(p, s, len);
+  p[len] = 0;
+
+  rule& r = _M_ruleset[_M_nrules];
+  if (!r.p.parse(p)) {
+    return false;
+  }
+
+  const char* a = eq + 1;
+
+  r.c = 0;
+
+  if (strcmp(a, "zero") == 0) {
+    r.a = action::Zero;
+  } else if (strncmp(a, "mask:", 5) == 0) {
+    r.a = action::Mask;
+
+    a += 5;
+
+    if ((a[0] != 0) && (a[1] == 0)) {
+      r.c = static_cast<uint8_t>(*a);
+    } else if ((a[0] == '0') && ((a[1] == 'x') || (a[1] == 'X'))) {
+      char* end;
+      unsigned long n = strtoul(a + 2, &end, 16);
+      if ((*end) || (end != a + 4) || (n > 0xff)) {
+        return false;
+      }
+
+      r.c = static_cast<uint8_t>(n);
+    } else {
+      return false;
+    }
+  } else if (strcmp(a, "hash") == 0) {
+    r.a = action::Hash;
+  } else if (strcmp(a, "digits") == 0) {
+    r.a = action::Digits;
+  } else if (strcmp(a, "tbcd") == 0) {
+    r.a = action::TBCD;
+  } else {
+    return false;
+  }
+
+  if ((r.a != action::Zero) && (r.a != action::Mask)) {
+    _M_hashes = true;
+  }
+
+  _M_nrules++;
+
+  return true;
+}
+
+bool asn1::ber::anonymizer::anonymize(uint8_t* buf, size_t len)
+{
+  _M_rules[0] = (_M_nrules < 64) ?
+                  (static_cast<uint64_t>(1) << _M_nrules) - 1 :
+                  ~static_cast<uint64_t>(0);
+
+  _M_active[0] = none;
+  _M_depth = 0;
+
+  memory_reader reader(buf, len);
+  return decoder::decode(reader, *this);
+}
+
+asn1::ber::tlv_action asn1::ber::anonymizer::tlv(tag_class tc,
+                                                 primitive_constructed pc,
+                                                 tag_number tn,
+                                                 const void* buf,
+                                                 uint64_t len,
+                                                 uint64_t headerlen)
+{
+  unsigned active = _M_active[_M_depth];
+  uint64_t rules = 0;
+
+  // If the value is not inside the value of a rule...
+  if (active == none) {
+    // Rules which match the tag.
+    for (uint64_t m = _M_rules[_M_depth]; m != 0; m &= m - 1) {
+      unsigned r = __builtin_ctzll(m);
+
+      const path_step& step = _M_ruleset[r].p[_M_depth];
+      if ((step.tc == tc) && (step.tn == tn)) {
+        // Is it the value of the rule?
+        if (_M_ruleset[r].p.size() == _M_depth + 1) {
+          // The first rule wins.
+          if (active == none) {
+            active = r;
+          }
+        } else {
+          rules |= static_cast<uint64_t>(1) << r;
+        }
+      }
+    }
+  }
+
+  if (pc == primitive_constructed::Primitive) {
+    if (active != none) {
+      overwrite(_M_ruleset[active],
+                const_cast<uint8_t*>(static_cast<const uint8_t*>(buf)) +
+                headerlen,
+                len - headerlen);
+
+      _M_values++;
+    }
+
+    return tlv_action::Skip;
+  }
+
+  // If no rule can match the values of the constructed value...
+  if ((active == none) && (rules == 0)) {
+    return tlv_action::Skip;
+  }
+
+  _M_next = rules;
+  _M_nextactive = active;
+
+  return tlv_action::Continue;
+}
+
+void asn1::ber::anonymizer::overwrite(const rule& r,
+                                      uint8_t* buf,
+                                      uint64_t len) const
+{
+  switch (r.a) {
+    case action::Zero:
+      memset(buf, 0, len);
+      return;
+    case action::Mask:
+      memset(buf, r.c, len);
+      return;
+    default:
+      break;
+  }
+
+  // The output is a function of the contents (and the key).
+  uint64_t state = hash(buf, len);
+
+  switch (r.a) {
+    case action::Hash:
+      for (uint64_t i = 0; i < len; i += 8) {
+        uint64_t rnd = next_random(state);
+        memcpy(buf + i, &rnd, (len - i < 8) ? len - i : 8);
+      }
+
+      break;
+    case action::Digits:
+      for (uint64_t i = 0; i < len; i++) {
+        if ((buf[i] >= '0') && (buf[i] <= '9')) {
+          buf[i] = '0' + (next_random(state) % 10);
+        }
+      }
+
+      break;
+    case action::TBCD:
+      for (uint64_t i = 0; i < len; i++) {
+        uint8_t lo = buf[i] & 0x0f;
+        uint8_t hi = buf[i] >> 4;
+
+        if (lo <= 9) {
+          lo = next_random(state) % 10;
+        }
+
+        if (hi <= 9) {
+          hi = next_random(state) % 10;
+        }
+
+        buf[i] = (hi << 4) | lo;
+      }
+
+      break;
+    default:
+      break;
+  }
+}
+
+uint64_t asn1::ber::anonymizer::hash(const void* buf, uint64_t len) const
+{
+  return siphash(_M_k0, _M_k1, buf, len);
+}
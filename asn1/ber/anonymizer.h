@@ -0,0 +1,256 @@
+#ifndef ASN1_BER_ANONYMIZER_H
+#define ASN1_BER_ANONYMIZER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/error.h"
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/path.h"
+
+namespace asn1 {
+  namespace ber {
+    // Overwrites the contents of the primitive values at the paths of some
+    // rules with values of the same length, in place: no length octet
+    // changes and nothing is re-encoded.
+    // Rule: <path>=<action>
+    //   - <path>: path of asn1::ber::path ("[APPLICATION 1]/[3]"). If the
+    //     value at the path is constructed (a constructed string), all the
+    //     primitive values nested in it are overwritten.
+    //   - <action>:
+    //       zero: fill with 0x00.
+    //       mask:<c>: fill with the character <c> (or the octet 0x<hh>).
+    //       hash: keyed hash of the contents (the same contents always give
+    //             the same output).
+    //       digits: like hash, but only the ASCII digits are replaced (by
+    //               digits).
+    //       tbcd: like hash, but only the nibbles 0 - 9 of the TBCD strings
+    //             are replaced (by digits, the fillers are kept).
+    // All the rules are evaluated in a single decoding pass. The record is
+    // decoded with the method tlv(): the subtrees which no rule can match are
+    // skipped and the contents of the primitive values are never decoded.
+    class anonymizer {
+      public:
+        // Maximum number of rules.
+        static const size_t max_rules = 64;
+
+        // Maximum depth of the values.
+        static const size_t max_depth = 64;
+
+        // Constructor.
+        anonymizer() = default;
+
+        // Destructor.
+        ~anonymizer() = default;
+
+        // Set the secret key of the hash actions.
+        void key(const void* buf, size_t len);
+
+        // Add rule.
+        // Returns false if the rule is not valid or there are too many rules.
+        bool add(const char* rule);
+
+        // Get number of rules.
+        size_t size() const
+        {
+          return _M_nrules;
+        }
+
+        // Have the rules hash actions?
+        bool hashes() const
+        {
+          return _M_hashes;
+        }
+
+        // Anonymize the record of 'len' bytes at 'buf'.
+        bool anonymize(uint8_t* buf, size_t len);
+
+        // Get number of values overwritten so far.
+        uint64_t values() const
+        {
+          return _M_values;
+        }
+
+        // Encoded value (called by the decoder).
+        tlv_action tlv(tag_class tc,
+                       primitive_constructed pc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t headerlen);
+
+        // Start constructed.
+        bool start_constructed(tag_class tc,
+                               tag_number tn,
+                               uint64_t valuelen,
+                               uint64_t totallen)
+        {
+          _M_depth++;
+
+          _M_rules[_M_depth] = _M_next;
+          _M_active[_M_depth] = _M_nextactive;
+
+          return true;
+        }
+
+        // End constructed.
+        bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+        {
+          _M_depth--;
+          return true;
+        }
+
+        // The primitive values are always skipped by tlv().
+
+        // Boolean.
+        bool boolean(const void* buf, uint64_t len, bool val)
+        {
+          return true;
+        }
+
+        // Integer.
+        bool integer(const void* buf, uint64_t len, int64_t val)
+        {
+          return true;
+        }
+
+        // Null.
+        bool null()
+        {
+          return true;
+        }
+
+        // Object identifier.
+        bool oid(const void* buf,
+                 uint64_t len,
+                 const uint64_t* oid,
+                 size_t ncomponents)
+        {
+          return true;
+        }
+
+        // Real.
+        bool real(const void* buf, uint64_t len, double val)
+        {
+          return true;
+        }
+
+        // Enumerated.
+        bool enumerated(const void* buf, uint64_t len, int64_t val)
+        {
+          return true;
+        }
+
+        // UTC time.
+        bool utc_time(const void* buf, uint64_t len, time_t val)
+        {
+          return true;
+        }
+
+        // Generalized time.
+        bool generalized_time(const void* buf,
+                              uint64_t len,
+                              const struct timeval& val)
+        {
+          return true;
+        }
+
+        // Primitive.
+        bool primitive(tag_class tc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t valueoff,
+                       uint64_t valuelen)
+        {
+          return true;
+        }
+
+        // Error.
+        void error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        enum class action : uint8_t {
+          Zero,
+          Mask,
+          Hash,
+          Digits,
+          TBCD
+        };
+
+        struct rule {
+          path p;
+
+          action a;
+
+          // Character of the action Mask.
+          uint8_t c;
+        };
+
+        // No rule is active.
+        static const unsigned none = max_rules;
+
+        rule _M_ruleset[max_rules];
+        size_t _M_nrules = 0;
+
+        bool _M_hashes = false;
+
+        // Key of the hash.
+        uint64_t _M_k0 = 0;
+        uint64_t _M_k1 = 0;
+
+        // Rules which can still match the values of each depth (bitmap) and
+        // rule whose value contains the values of each depth.
+        uint64_t _M_rules[max_depth + 2];
+        unsigned _M_active[max_depth + 2];
+        size_t _M_depth = 0;
+
+        // Rules / active rule of the constructed value being started.
+        uint64_t _M_next = 0;
+        unsigned _M_nextactive = none;
+
+        uint64_t _M_values = 0;
+
+        enum error _M_error = error::callback;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+
+        // Overwrite the contents with the action of the rule 'r'.
+        void overwrite(const rule& r, uint8_t* buf, uint64_t len) const;
+
+        // Keyed hash (SipHash-2-4).
+        uint64_t hash(const void* buf, uint64_t len) const;
+
+        // Disable copy constructor and assignment operator.
+        anonymizer(const anonymizer&) = delete;
+        anonymizer& operator=(const anonymizer&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_ANONYMIZER_H
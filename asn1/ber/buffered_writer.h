@@ -0,0 +1,302 @@
+#ifndef ASN1_BER_BUFFERED_WRITER_H
+#define ASN1_BER_BUFFERED_WRITER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+
+namespace asn1 {
+  namespace ber {
+    // Writer which accumulates the output in a buffer of 'N' bytes and
+    // writes it to a file descriptor with large write(2) calls.
+    // The numbers are formatted without printf() (no locale, no format
+    // parsing) and the hexadecimal digits and the indentation are copied
+    // from tables.
+    template<size_t N = 256 * 1024>
+    class buffered_writer {
+      public:
+        // Constructor.
+        buffered_writer(int fd = STDOUT_FILENO)
+          : _M_fd(fd)
+        {
+        }
+
+        // Destructor.
+        ~buffered_writer()
+        {
+          flush();
+        }
+
+        // Write buffered data to the file descriptor.
+        bool flush();
+
+        // Write.
+        bool write(const void* buf, size_t len);
+
+        // Write string.
+        bool write(const char* s)
+        {
+          return write(s, strlen(s));
+        }
+
+        // Write character.
+        bool put(char c)
+        {
+          if ((_M_used < N) || (flush())) {
+            _M_buf[_M_used++] = c;
+            return true;
+          }
+
+          return false;
+        }
+
+        // Write 'count' spaces.
+        bool spaces(size_t count);
+
+        // Write byte as two hexadecimal digits (lowercase).
+        bool hex(uint8_t b)
+        {
+          if ((_M_used + 2 <= N) || (flush())) {
+            const char* const digits = hex_digits() + (b * 2);
+
+            _M_buf[_M_used++] = digits[0];
+            _M_buf[_M_used++] = digits[1];
+
+            return true;
+          }
+
+          return false;
+        }
+
+        // Write unsigned integer (padded with zeros up to 'width' digits).
+        bool unsigned_integer(uint64_t n, size_t width = 0);
+
+        // Write signed integer.
+        bool integer(int64_t n)
+        {
+          if (n >= 0) {
+            return unsigned_integer(static_cast<uint64_t>(n));
+          } else {
+            return ((put('-')) &&
+                    (unsigned_integer(~static_cast<uint64_t>(n) + 1)));
+          }
+        }
+
+        // Reserve 'len' contiguous bytes ('len' <= N) and return a pointer
+        // to them (nullptr on error); the bytes have to be committed with
+        // commit().
+        char* reserve(size_t len)
+        {
+          if ((len <= N) && ((_M_used + len <= N) || (flush()))) {
+            return _M_buf + _M_used;
+          }
+
+          return nullptr;
+        }
+
+        // Commit 'len' bytes of the reserved space.
+        void commit(size_t len)
+        {
+          _M_used += len;
+        }
+
+        // Has there been an error writing?
+        bool error() const
+        {
+          return _M_error;
+        }
+
+      private:
+        // Maximum number of digits of an uint64_t.
+        static const size_t max_digits = 20;
+
+        char _M_buf[N];
+        size_t _M_used = 0;
+
+        int _M_fd;
+
+        bool _M_error = false;
+
+        // Get table of hexadecimal digits ("000102...ff").
+        static const char* hex_digits();
+
+        // Get table of decimal digits ("000102...99").
+        static const char* decimal_digits();
+
+        // Disable copy constructor and assignment operator.
+        buffered_writer(const buffered_writer&) = delete;
+        buffered_writer& operator=(const buffered_writer&) = delete;
+    };
+
+    template<size_t N>
+    bool buffered_writer<N>::flush()
+    {
+      if (!_M_error) {
+        size_t written = 0;
+
+        while (written < _M_used) {
+          ssize_t ret;
+          if ((ret = ::write(_M_fd,
+                             _M_buf + written,
+                             _M_used - written)) > 0) {
+            written += ret;
+          } else if ((ret < 0) && (errno == EINTR)) {
+            continue;
+          } else {
+            _M_error = true;
+            return false;
+          }
+        }
+
+        _M_used = 0;
+
+        return true;
+      }
+
+      return false;
+    }
+
+    template<size_t N>
+    bool buffered_writer<N>::write(const void* buf, size_t len)
+    {
+      // If the data fits in the buffer...
+      if (_M_used + len <= N) {
+        memcpy(_M_buf + _M_used, buf, len);
+        _M_used += len;
+
+        return true;
+      }
+
+      if (!flush()) {
+        return false;
+      }
+
+      if (len < N) {
+        memcpy(_M_buf, buf, len);
+        _M_used = len;
+
+        return true;
+      }
+
+      // Write directly.
+      const char* b = static_cast<const char*>(buf);
+
+      while (len > 0) {
+        ssize_t ret;
+        if ((ret = ::write(_M_fd, b, len)) > 0) {
+          b += ret;
+          len -= ret;
+        } else if ((ret < 0) && (errno == EINTR)) {
+          continue;
+        } else {
+          _M_error = true;
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    template<size_t N>
+    bool buffered_writer<N>::spaces(size_t count)
+    {
+      static const char blanks[] = "                                "
+                                   "                                ";
+
+      static const size_t number_blanks = sizeof(blanks) - 1;
+
+      while (count > number_blanks) {
+        if (!write(blanks, number_blanks)) {
+          return false;
+        }
+
+        count -= number_blanks;
+      }
+
+      return write(blanks, count);
+    }
+
+    template<size_t N>
+    bool buffered_writer<N>::unsigned_integer(uint64_t n, size_t width)
+    {
+      char digits[max_digits];
+      char* ptr = digits + max_digits;
+
+      // Two digits per iteration.
+      while (n >= 100) {
+        const char* const d = decimal_digits() + ((n % 100) * 2);
+        n /= 100;
+
+        *--ptr = d[1];
+        *--ptr = d[0];
+      }
+
+      if (n >= 10) {
+        const char* const d = decimal_digits() + (n * 2);
+
+        *--ptr = d[1];
+        *--ptr = d[0];
+      } else {
+        *--ptr = static_cast<char>('0' + n);
+      }
+
+      size_t len = (digits + max_digits) - ptr;
+
+      // Padding.
+      if ((width > len) && (!write("00000000000000000000",
+                                   (width - len <= max_digits) ?
+                                     width - len :
+                                     max_digits))) {
+        return false;
+      }
+
+      return write(ptr, len);
+    }
+
+    template<size_t N>
+    const char* buffered_writer<N>::hex_digits()
+    {
+      static const char digits[] =
+        "000102030405060708090a0b0c0d0e0f"
+        "101112131415161718191a1b1c1d1e1f"
+        "202122232425262728292a2b2c2d2e2f"
+        "303132333435363738393a3b3c3d3e3f"
+        "404142434445464748494a4b4c4d4e4f"
+        "505152535455565758595a5b5c5d5e5f"
+        "606162636465666768696a6b6c6d6e6f"
+        "707172737475767778797a7b7c7d7e7f"
+        "808182838485868788898a8b8c8d8e8f"
+        "909192939495969798999a9b9c9d9e9f"
+        "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+        "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+        "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+        "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+        "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+        "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+      return digits;
+    }
+
+    template<size_t N>
+    const char* buffered_writer<N>::decimal_digits()
+    {
+      static const char digits[] =
+        "00010203040506070809"
+        "10111213141516171819"
+        "20212223242526272829"
+        "30313233343536373839"
+        "40414243444546474849"
+        "50515253545556575859"
+        "60616263646566676869"
+        "70717273747576777879"
+        "80818283848586878889"
+        "90919293949596979899";
+
+      return digits;
+    }
+  }
+}
+
+#endif // ASN1_BER_BUFFERED_WRITER_H
@@ -0,0 +1,555 @@
+#include <string.h>
+#include "asn1/ber/canonicalizer.h"
+#include "asn1/ber/grow.h"
+
+#define UNIVERSAL(uc) static_cast<asn1::ber::tag_number>( \
+                        asn1::ber::universal_class::uc    \
+                      )
+
+// Is the value a constructed string which has to be flattened?
+static inline bool flattened(const asn1::ber::header& h)
+{
+  if (h.tc != asn1::ber::tag_class::Universal) {
+    return false;
+  }
+
+  switch (h.tn) {
+    case UNIVERSAL(Bitstring):
+    case UNIVERSAL(Octetstring):
+    case UNIVERSAL(ObjectDescriptor):
+    case UNIVERSAL(UTF8String):
+    case UNIVERSAL(NumericString):
+    case UNIVERSAL(PrintableString):
+    case UNIVERSAL(TeletexString):
+    case UNIVERSAL(VideotexString):
+    case UNIVERSAL(IA5String):
+    case UNIVERSAL(UTCTime):
+    case UNIVERSAL(GeneralizedTime):
+    case UNIVERSAL(GraphicString):
+    case UNIVERSAL(VisibleString):
+    case UNIVERSAL(GeneralString):
+    case UNIVERSAL(UniversalString):
+    case UNIVERSAL(CharacterString):
+    case UNIVERSAL(BMPString):
+      return true;
+    default:
+      return false;
+  }
+}
+
+asn1::ber::canonicalizer::canonicalizer(int fd,
+                                        size_t memory,
+                                        const char* tmpdir)
+  : _M_out(fd),
+    _M_tmpdir(tmpdir),
+    _M_memory(memory)
+{
+  _M_lengths.configure(memory, tmpdir);
+}
+
+asn1::ber::canonicalizer::~canonicalizer()
+{
+  for (size_t i = 0; i < max_depth; i++) {
+    free(_M_sets[i].offsets);
+  }
+
+  free(_M_components);
+}
+
+bool asn1::ber::canonicalizer::canonicalize(const void* buf,
+                                            size_t len,
+                                            uint64_t& tlvlen)
+{
+  const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+  _M_nsets = 0;
+
+  // Compute the lengths of the constructed values.
+  _M_lengths.clear();
+
+  if (!transcode(b, len, false, tlvlen)) {
+    return false;
+  }
+
+  if (!_M_lengths.data(_M_table)) {
+    return write_error();
+  }
+
+  return transcode(b, len, true, tlvlen);
+}
+
+bool asn1::ber::canonicalizer::flush()
+{
+  if (_M_out.flush()) {
+    return true;
+  }
+
+  return write_error();
+}
+
+uint64_t asn1::ber::canonicalizer::spilled() const
+{
+  uint64_t n = _M_lengths.spilled();
+
+  for (size_t i = 0; i < max_depth; i++) {
+    n += _M_sets[i].buffer.spilled();
+  }
+
+  return n;
+}
+
+bool asn1::ber::canonicalizer::transcode(const uint8_t* buf,
+                                         size_t len,
+                                         bool emit,
+                                         uint64_t& tlvlen)
+{
+  static const uint64_t zero = 0;
+
+  size_t depth = 0;
+  size_t off = 0;
+
+  // Index of the next constructed value in the table of lengths.
+  uint64_t index = 0;
+
+  do {
+    // End of the contents of the enclosing value.
+    size_t limit = len;
+
+    if (depth > 0) {
+      const frame& f = _M_frames[depth - 1];
+
+      bool end;
+      if (!f.indefinite) {
+        end = (off == f.end);
+      } else if ((end = ((f.end - off >= 2) &&
+                         (buf[off] == 0) &&
+                         (buf[off + 1] == 0)))) {
+        off += 2;
+      }
+
+      if (end) {
+        if (!end_constructed(depth, emit)) {
+          return false;
+        }
+
+        continue;
+      }
+
+      limit = f.end;
+
+      if ((emit) && (f.set) && (!add_component())) {
+        return false;
+      }
+    }
+
+    header h;
+    if (!decode_header(buf + off, limit - off, h)) {
+      return error(error::invalid_value, off, "invalid or incomplete header");
+    }
+
+    if ((h.tc == tag_class::Universal) && (h.tn == 0)) {
+      return error(error::unexpected_end_of_contents, off);
+    }
+
+    if ((!h.indefinite) && (h.valuelen > limit - off - h.len)) {
+      return error(error::invalid_length, off);
+    }
+
+    if (h.pc == primitive_constructed::Primitive) {
+      const uint8_t* const value = buf + off + h.len;
+
+      if (h.tc == tag_class::Universal) {
+        if (h.tn == UNIVERSAL(Boolean)) {
+          if (h.valuelen != 1) {
+            return error(error::invalid_value, off, "invalid boolean");
+          }
+        } else if (h.tn == UNIVERSAL(Bitstring)) {
+          if ((h.valuelen == 0) ||
+              (value[0] > 7) ||
+              ((h.valuelen == 1) && (value[0] != 0))) {
+            return error(error::invalid_value, off, "invalid bit string");
+          }
+        }
+      }
+
+      if (emit) {
+        if (!primitive(h, value)) {
+          return false;
+        }
+      } else if (depth > 0) {
+        _M_frames[depth - 1].length += tag_length(h.tn) +
+                                       length_length(h.valuelen) +
+                                       h.valuelen;
+      }
+
+      off += h.len + h.valuelen;
+    } else if (flattened(h)) {
+      // Constructed string: flatten it to a primitive value.
+      uint64_t length;
+      uint8_t unused;
+      size_t end;
+      if (!string(buf, off, limit, h, false, length, unused, end)) {
+        return false;
+      }
+
+      // BIT STRING: initial octet with the number of unused bits.
+      const uint64_t valuelen = (h.tn == UNIVERSAL(Bitstring)) ?
+                                  length + 1 :
+                                  length;
+
+      if (emit) {
+        if ((!write_header(h.tc,
+                           primitive_constructed::Primitive,
+                           h.tn,
+                           valuelen)) ||
+            ((valuelen > length) && (!write(&unused, 1))) ||
+            (!string(buf, off, limit, h, true, length, unused, end))) {
+          return false;
+        }
+      } else if (depth > 0) {
+        _M_frames[depth - 1].length += tag_length(h.tn) +
+                                       length_length(valuelen) +
+                                       valuelen;
+      }
+
+      off = end;
+    } else {
+      if (depth == max_depth) {
+        return error(error::max_depth_exceeded, off);
+      }
+
+      frame& f = _M_frames[depth++];
+
+      f.tc = h.tc;
+      f.tn = h.tn;
+      f.indefinite = h.indefinite;
+      f.end = h.indefinite ? limit : off + h.len + h.valuelen;
+      f.index = index++;
+      f.length = 0;
+      f.set = false;
+
+      if (emit) {
+        memcpy(&f.length, _M_table + (f.index * sizeof(uint64_t)),
+               sizeof(uint64_t));
+
+        if (!write_header(h.tc,
+                          primitive_constructed::Constructed,
+                          h.tn,
+                          f.length)) {
+          return false;
+        }
+
+        if ((h.tc == tag_class::Universal) && (h.tn == UNIVERSAL(Set))) {
+          if (!start_set()) {
+            return false;
+          }
+
+          f.set = true;
+        }
+      } else {
+        // The length is stored when the value ends.
+        if (!_M_lengths.write(&zero, sizeof(uint64_t))) {
+          return write_error();
+        }
+      }
+
+      off += h.len;
+    }
+  } while (depth > 0);
+
+  tlvlen = off;
+
+  return true;
+}
+
+bool asn1::ber::canonicalizer::end_constructed(size_t& depth, bool emit)
+{
+  const frame& f = _M_frames[--depth];
+
+  if (emit) {
+    return ((!f.set) || (end_set()));
+  }
+
+  if (!_M_lengths.overwrite(f.index * sizeof(uint64_t),
+                            &f.length,
+                            sizeof(uint64_t))) {
+    return write_error();
+  }
+
+  if (depth > 0) {
+    _M_frames[depth - 1].length += tag_length(f.tn) +
+                                   length_length(f.length) +
+                                   f.length;
+  }
+
+  return true;
+}
+
+bool asn1::ber::canonicalizer::string(const uint8_t* buf,
+                                      size_t off,
+                                      size_t limit,
+                                      const header& h,
+                                      bool emit,
+                                      uint64_t& length,
+                                      uint8_t& unused,
+                                      size_t& end)
+{
+  const bool bitstring = (h.tn == UNIVERSAL(Bitstring));
+
+  // The segments are BIT STRING values (BIT STRING) or OCTET STRING values
+  // (the type of the string is also accepted).
+  const tag_number segment = bitstring ?
+                               UNIVERSAL(Bitstring) :
+                               UNIVERSAL(Octetstring);
+
+  // Constructed values being walked.
+  struct {
+    bool indefinite;
+    size_t end;
+  } stack[max_depth];
+
+  size_t depth = 1;
+
+  stack[0].indefinite = h.indefinite;
+  stack[0].end = h.indefinite ? limit : off + h.len + h.valuelen;
+
+  off += h.len;
+
+  // Unused bits of the last segment.
+  uint8_t u = 0;
+
+  // Number of octets written.
+  uint64_t written = 0;
+
+  do {
+    const size_t e = stack[depth - 1].end;
+
+    bool done;
+    if (!stack[depth - 1].indefinite) {
+      done = (off == e);
+    } else if ((done = ((e - off >= 2) &&
+                        (buf[off] == 0) &&
+                        (buf[off + 1] == 0)))) {
+      off += 2;
+    }
+
+    if (done) {
+      depth--;
+      continue;
+    }
+
+    header s;
+    if (!decode_header(buf + off, e - off, s)) {
+      return error(error::invalid_value, off, "invalid or incomplete header");
+    }
+
+    if ((s.tc != tag_class::Universal) ||
+        ((s.tn != segment) && (s.tn != h.tn))) {
+      return error(error::invalid_value, off, "invalid string segment");
+    }
+
+    if (s.pc == primitive_constructed::Constructed) {
+      if (depth == max_depth) {
+        return error(error::max_depth_exceeded, off);
+      }
+
+      stack[depth].indefinite = s.indefinite;
+      stack[depth].end = s.indefinite ? e : off + s.len + s.valuelen;
+
+      depth++;
+
+      off += s.len;
+
+      continue;
+    }
+
+    if (s.valuelen > e - off - s.len) {
+      return error(error::invalid_length, off);
+    }
+
+    const uint8_t* value = buf + off + s.len;
+    uint64_t valuelen = s.valuelen;
+
+    if (bitstring) {
+      // Only the last segment can have unused bits.
+      if ((valuelen == 0) ||
+          (value[0] > 7) ||
+          ((valuelen == 1) && (value[0] != 0)) ||
+          (u != 0)) {
+        return error(error::invalid_value, off, "invalid bit string segment");
+      }
+
+      u = value[0];
+
+      value++;
+      valuelen--;
+    }
+
+    if (emit) {
+      // If the last octet has unused bits, zero them.
+      if ((unused != 0) && (valuelen > 0) && (written + valuelen == length)) {
+        const uint8_t last = value[valuelen - 1] & (0xff << unused);
+
+        if ((!write(value, valuelen - 1)) || (!write(&last, 1))) {
+          return false;
+        }
+      } else if (!write(value, valuelen)) {
+        return false;
+      }
+
+      written += valuelen;
+    } else {
+      written += valuelen;
+    }
+
+    off += s.len + s.valuelen;
+  } while (depth > 0);
+
+  if (!emit) {
+    length = written;
+    unused = u;
+  }
+
+  end = off;
+
+  return true;
+}
+
+bool asn1::ber::canonicalizer::primitive(const header& h,
+                                         const uint8_t* value)
+{
+  if (!write_header(h.tc, primitive_constructed::Primitive, h.tn, h.valuelen)) {
+    return false;
+  }
+
+  if (h.tc == tag_class::Universal) {
+    if (h.tn == UNIVERSAL(Boolean)) {
+      // TRUE is encoded as 0xff.
+      const uint8_t b = (value[0] != 0) ? 0xff : 0x00;
+      return write(&b, 1);
+    } else if ((h.tn == UNIVERSAL(Bitstring)) && (value[0] != 0)) {
+      // Zero the unused bits of the last octet.
+      const uint8_t last = value[h.valuelen - 1] & (0xff << value[0]);
+
+      return ((write(value, h.valuelen - 1)) && (write(&last, 1)));
+    }
+  }
+
+  return write(value, h.valuelen);
+}
+
+bool asn1::ber::canonicalizer::write_header(tag_class tc,
+                                            primitive_constructed pc,
+                                            tag_number tn,
+                                            uint64_t length)
+{
+  // Identifier octets (up to 11) + length octets (up to 9).
+  uint8_t buf[20];
+
+  size_t len = encode_tag_padded(tc, pc, tn, buf);
+  len += encode_length_padded(length, buf + len);
+
+  return write(buf, len);
+}
+
+bool asn1::ber::canonicalizer::write(const void* buf, size_t len)
+{
+  if (_M_nsets == 0) {
+    if (_M_out.write(buf, len)) {
+      return true;
+    }
+  } else if (_M_sets[_M_nsets - 1].buffer.write(buf, len)) {
+    return true;
+  }
+
+  return write_error();
+}
+
+bool asn1::ber::canonicalizer::start_set()
+{
+  set& s = _M_sets[_M_nsets++];
+
+  s.buffer.configure(_M_memory, _M_tmpdir);
+  s.buffer.clear();
+
+  s.noffsets = 0;
+
+  return true;
+}
+
+bool asn1::ber::canonicalizer::add_component()
+{
+  set& s = _M_sets[_M_nsets - 1];
+
+  if (grow(s.offsets, s.size, s.noffsets + 1)) {
+    s.offsets[s.noffsets++] = s.buffer.size();
+    return true;
+  }
+
+  return write_error();
+}
+
+bool asn1::ber::canonicalizer::end_set()
+{
+  // The components are written to the enclosing value.
+  set& s = _M_sets[--_M_nsets];
+
+  const uint8_t* data;
+  if ((!s.buffer.data(data)) ||
+      (!grow(_M_components, _M_sizecomponents, s.noffsets))) {
+    return write_error();
+  }
+
+  const uint64_t size = s.buffer.size();
+
+  for (size_t i = 0; i < s.noffsets; i++) {
+    _M_components[i].data = data + s.offsets[i];
+    _M_components[i].len = ((i + 1 < s.noffsets) ? s.offsets[i + 1] : size) -
+                           s.offsets[i];
+  }
+
+  // Sort the components by their encodings (the shorter one being padded
+  // with zeros).
+  if (s.noffsets > 1) {
+    qsort(_M_components,
+          s.noffsets,
+          sizeof(component),
+          [](const void* p1, const void* p2) -> int {
+            const component* c1 = static_cast<const component*>(p1);
+            const component* c2 = static_cast<const component*>(p2);
+
+            const uint64_t len = (c1->len < c2->len) ? c1->len : c2->len;
+
+            int ret;
+            if ((ret = memcmp(c1->data, c2->data, len)) != 0) {
+              return ret;
+            }
+
+            if (c1->len > len) {
+              for (uint64_t i = len; i < c1->len; i++) {
+                if (c1->data[i] != 0) {
+                  return 1;
+                }
+              }
+            } else {
+              for (uint64_t i = len; i < c2->len; i++) {
+                if (c2->data[i] != 0) {
+                  return -1;
+                }
+              }
+            }
+
+            return 0;
+          });
+  }
+
+  for (size_t i = 0; i < s.noffsets; i++) {
+    if (!write(_M_components[i].data, _M_components[i].len)) {
+      return false;
+    }
+  }
+
+  s.buffer.clear();
+
+  return true;
+}
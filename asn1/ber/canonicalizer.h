@@ -0,0 +1,207 @@
+#ifndef ASN1_BER_CANONICALIZER_H
+#define ASN1_BER_CANONICALIZER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/common.h"
+#include "asn1/ber/error.h"
+#include "asn1/ber/buffered_writer.h"
+#include "asn1/ber/spill_buffer.h"
+
+namespace asn1 {
+  namespace ber {
+    // Transcodes BER values to DER:
+    //   - The lengths are definite and encoded in the minimum number of
+    //     octets (no end-of-contents).
+    //   - The constructed BIT STRING, OCTET STRING and restricted character
+    //     string values are flattened to primitive values and the unused
+    //     bits of the BIT STRING values are zeroed.
+    //   - BOOLEAN TRUE is encoded as 0xff.
+    //   - The components of the SET (SET OF) values are sorted by their
+    //     encodings (X.690 11.6).
+    // Each value is transcoded in two passes over the input: the first one
+    // walks the headers and computes the lengths of the constructed values
+    // (kept in a table in pre-order) and the second one writes the output.
+    // Only the table and the contents of the SET values being sorted are
+    // buffered, in buffers which spill to temporary files when they exceed
+    // the memory limit.
+    class canonicalizer {
+      public:
+        // Maximum depth of the values.
+        static const size_t max_depth = 64;
+
+        // Constructor.
+        canonicalizer(int fd = STDOUT_FILENO,
+                      size_t memory = spill_buffer::default_memory,
+                      const char* tmpdir = nullptr);
+
+        // Destructor.
+        ~canonicalizer();
+
+        // Transcode the value at 'buf' (of at most 'len' bytes); 'tlvlen' is
+        // the length of the value in the input.
+        bool canonicalize(const void* buf, size_t len, uint64_t& tlvlen);
+
+        // Write buffered output to the file descriptor.
+        bool flush();
+
+        // Get number of bytes written to temporary files so far.
+        uint64_t spilled() const;
+
+        // Has there been an error writing the output or a temporary file (or
+        // allocating memory)?
+        bool io_error() const
+        {
+          return _M_ioerror;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        // Constructed value being transcoded.
+        struct frame {
+          tag_class tc;
+          tag_number tn;
+
+          bool indefinite;
+
+          // Offset of the end of the contents (definite length).
+          size_t end;
+
+          // Index in the table of lengths.
+          uint64_t index;
+
+          // Length of the contents (DER).
+          uint64_t length;
+
+          // SET value whose components are being sorted?
+          bool set;
+        };
+
+        // SET value whose components are being sorted.
+        struct set {
+          // Components (DER).
+          spill_buffer buffer;
+
+          // Offsets of the components in 'buffer'.
+          uint64_t* offsets = nullptr;
+          size_t noffsets = 0;
+          size_t size = 0;
+        };
+
+        // Component of a SET value.
+        struct component {
+          const uint8_t* data;
+          uint64_t len;
+        };
+
+        buffered_writer<256 * 1024> _M_out;
+
+        const char* _M_tmpdir;
+        size_t _M_memory;
+
+        frame _M_frames[max_depth];
+
+        // Lengths of the contents of the constructed values (pre-order).
+        spill_buffer _M_lengths;
+        const uint8_t* _M_table = nullptr;
+
+        set _M_sets[max_depth];
+        size_t _M_nsets = 0;
+
+        component* _M_components = nullptr;
+        size_t _M_sizecomponents = 0;
+
+        bool _M_ioerror = false;
+
+        enum error _M_error = error::invalid_value;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+
+        // Walk the value at 'buf': compute the lengths of the constructed
+        // values ('emit' = false) or write the value ('emit' = true).
+        bool transcode(const uint8_t* buf,
+                       size_t len,
+                       bool emit,
+                       uint64_t& tlvlen);
+
+        // Walk the segments of the constructed string whose header 'h' is at
+        // 'off': compute the length of the contents and the unused bits of
+        // the last segment (BIT STRING) or write the contents ('emit' =
+        // true, 'length' and 'unused' being the ones computed before).
+        bool string(const uint8_t* buf,
+                    size_t off,
+                    size_t limit,
+                    const header& h,
+                    bool emit,
+                    uint64_t& length,
+                    uint8_t& unused,
+                    size_t& end);
+
+        // End constructed value.
+        bool end_constructed(size_t& depth, bool emit);
+
+        // Write primitive value.
+        bool primitive(const header& h, const uint8_t* value);
+
+        // Write identifier and length octets.
+        bool write_header(tag_class tc,
+                          primitive_constructed pc,
+                          tag_number tn,
+                          uint64_t length);
+
+        // Write to the output or to the SET value being sorted.
+        bool write(const void* buf, size_t len);
+
+        // Start SET value.
+        bool start_set();
+
+        // Add component to the SET value being sorted.
+        bool add_component();
+
+        // Sort the components of the SET value and write them.
+        bool end_set();
+
+        // Set error.
+        bool error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+
+          return false;
+        }
+
+        // Set error writing.
+        bool write_error()
+        {
+          _M_ioerror = true;
+          return false;
+        }
+
+        // Disable copy constructor and assignment operator.
+        canonicalizer(const canonicalizer&) = delete;
+        canonicalizer& operator=(const canonicalizer&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_CANONICALIZER_H
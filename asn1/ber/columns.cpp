@@ -0,0 +1,507 @@
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <endian.h>
+#include "asn1/ber/columns.h"
+#include "asn1/ber/common.h"
+
+asn1::ber::column_data::~column_data()
+{
+  if (_M_values) {
+    free(_M_values);
+  }
+
+  if (_M_validity) {
+    free(_M_validity);
+  }
+
+  if (_M_data) {
+    free(_M_data);
+  }
+}
+
+bool asn1::ber::column_data::add(bool valid, int64_t value)
+{
+  if ((_M_records == _M_size) && (!grow())) {
+    return false;
+  }
+
+  // First value of a byte of the bitmap?
+  if ((_M_records % 8) == 0) {
+    _M_validity[_M_records / 8] = 0;
+  }
+
+  if (valid) {
+    _M_validity[_M_records / 8] |= static_cast<uint8_t>(1 << (_M_records % 8));
+  }
+
+  _M_values[_M_records++] = htole64(static_cast<uint64_t>(value));
+
+  return true;
+}
+
+bool asn1::ber::column_data::grow()
+{
+  size_t size = (_M_size > 0) ? _M_size * 2 : 1024;
+
+  uint64_t* values;
+  if ((values = static_cast<uint64_t*>(
+                  realloc(_M_values, size * sizeof(uint64_t))
+                )) == nullptr) {
+    return false;
+  }
+
+  _M_values = values;
+
+  uint8_t* validity;
+  if ((validity = static_cast<uint8_t*>(realloc(_M_validity, size / 8))) ==
+      nullptr) {
+    return false;
+  }
+
+  _M_validity = validity;
+
+  _M_size = size;
+
+  return true;
+}
+
+bool asn1::ber::column_data::append(const void* buf, size_t len)
+{
+  if (_M_datalen + len > _M_datasize) {
+    size_t size = (_M_datasize > 0) ? _M_datasize : 64 * 1024;
+
+    while (size < _M_datalen + len) {
+      size *= 2;
+    }
+
+    uint8_t* data;
+    if ((data = static_cast<uint8_t*>(realloc(_M_data, size))) == nullptr) {
+      return false;
+    }
+
+    _M_data = data;
+    _M_datasize = size;
+  }
+
+  memcpy(_M_data + _M_datalen, buf, len);
+  _M_datalen += len;
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::end_record()
+{
+  for (size_t i = 0; i < _M_ncolumns; i++) {
+    const uint64_t bit = static_cast<uint64_t>(1) << i;
+
+    if (_M_columns[i].type == column_type::String) {
+      if (!_M_data[i].add_string((_M_valid & bit) != 0)) {
+        return false;
+      }
+    } else if ((_M_valid & bit) != 0) {
+      if (!_M_data[i].add(true, _M_values[i])) {
+        return false;
+      }
+    } else if (!_M_data[i].add(false, 0)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::start_constructed(tag_class tc,
+                                                    tag_number tn,
+                                                    uint64_t valuelen,
+                                                    uint64_t totallen)
+{
+  // Constructed values are not extracted, but they are marked as found so
+  // a later value with the same path is not taken.
+  _M_found |= match(tc, tn);
+
+  if (_M_depth < path::max_steps) {
+    uint64_t mask = _M_masks[_M_depth] & ~_M_found;
+    uint64_t next = 0;
+
+    while (mask) {
+      unsigned c = __builtin_ctzll(mask);
+      mask &= mask - 1;
+
+      const asn1::ber::path& p = _M_columns[c].path;
+
+      if ((p.size() > _M_depth + 1) &&
+          (p[_M_depth].tc == tc) &&
+          (p[_M_depth].tn == tn)) {
+        next |= static_cast<uint64_t>(1) << c;
+      }
+    }
+
+    _M_masks[_M_depth + 1] = next;
+  }
+
+  _M_depth++;
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::primitive(tag_class tc,
+                                            tag_number tn,
+                                            const void* buf,
+                                            uint64_t len,
+                                            uint64_t valueoff,
+                                            uint64_t valuelen)
+{
+  // Beginning of the primitive value?
+  if (valueoff == 0) {
+    uint64_t matched;
+    if ((matched = match(tc, tn)) == 0) {
+      _M_strings = 0;
+      return true;
+    }
+
+    _M_found |= matched;
+    _M_strings = 0;
+
+    while (matched) {
+      unsigned c = __builtin_ctzll(matched);
+      matched &= matched - 1;
+
+      const uint64_t bit = static_cast<uint64_t>(1) << c;
+
+      switch (_M_columns[c].type) {
+        case column_type::Int64:
+          // Integer of up to 8 octets (not delivered in chunks).
+          if ((len == valuelen) && (len > 0) && (len <= 8)) {
+            _M_values[c] = decode_integer(buf, len);
+            _M_valid |= bit;
+          }
+
+          break;
+        case column_type::String:
+          _M_strings |= bit;
+          _M_valid |= bit;
+
+          break;
+        case column_type::Time:
+          if (len == valuelen) {
+            time_t t;
+            struct timeval tv;
+
+            if (decode_utc_time(buf, len, t)) {
+              _M_values[c] = static_cast<int64_t>(t) * 1000000;
+              _M_valid |= bit;
+            } else if (decode_generalized_time(buf, len, tv)) {
+              _M_values[c] = (static_cast<int64_t>(tv.tv_sec) * 1000000) +
+                             tv.tv_usec;
+
+              _M_valid |= bit;
+            }
+          }
+
+          break;
+      }
+    }
+  }
+
+  // Append the chunk to the strings.
+  uint64_t strings = _M_strings;
+
+  while (strings) {
+    unsigned c = __builtin_ctzll(strings);
+    strings &= strings - 1;
+
+    if (!_M_data[c].append(buf, len)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::int64_value(universal_class uc,
+                                              const void* buf,
+                                              uint64_t len,
+                                              int64_t val)
+{
+  uint64_t matched = match(tag_class::Universal,
+                           static_cast<tag_number>(uc));
+
+  _M_found |= matched;
+
+  while (matched) {
+    unsigned c = __builtin_ctzll(matched);
+    matched &= matched - 1;
+
+    const uint64_t bit = static_cast<uint64_t>(1) << c;
+
+    switch (_M_columns[c].type) {
+      case column_type::Int64:
+        _M_values[c] = val;
+        _M_valid |= bit;
+
+        break;
+      case column_type::String:
+        if (!_M_data[c].append(buf, len)) {
+          return false;
+        }
+
+        _M_valid |= bit;
+
+        break;
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::time_value(universal_class uc,
+                                             const void* buf,
+                                             uint64_t len,
+                                             int64_t val)
+{
+  uint64_t matched = match(tag_class::Universal,
+                           static_cast<tag_number>(uc));
+
+  _M_found |= matched;
+
+  while (matched) {
+    unsigned c = __builtin_ctzll(matched);
+    matched &= matched - 1;
+
+    const uint64_t bit = static_cast<uint64_t>(1) << c;
+
+    switch (_M_columns[c].type) {
+      case column_type::Time:
+        _M_values[c] = val;
+        _M_valid |= bit;
+
+        break;
+      case column_type::String:
+        if (!_M_data[c].append(buf, len)) {
+          return false;
+        }
+
+        _M_valid |= bit;
+
+        break;
+      default:
+        break;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::column_extractor::string_value(universal_class uc,
+                                               const void* buf,
+                                               uint64_t len)
+{
+  uint64_t matched = match(tag_class::Universal,
+                           static_cast<tag_number>(uc));
+
+  _M_found |= matched;
+
+  while (matched) {
+    unsigned c = __builtin_ctzll(matched);
+    matched &= matched - 1;
+
+    if (_M_columns[c].type == column_type::String) {
+      if (!_M_data[c].append(buf, len)) {
+        return false;
+      }
+
+      _M_valid |= static_cast<uint64_t>(1) << c;
+    }
+  }
+
+  return true;
+}
+
+asn1::ber::column_writer::~column_writer()
+{
+  close();
+}
+
+bool asn1::ber::column_writer::open(const char* dir, const column& c)
+{
+  if (c.type == column_type::String) {
+    if (((_M_values = create(dir, c.name, "offsets")) == -1) ||
+        ((_M_data = create(dir, c.name, "data")) == -1)) {
+      return false;
+    }
+
+    // The first string starts at offset 0.
+    uint64_t off = 0;
+    if (!write(_M_values, &off, sizeof(uint64_t))) {
+      return false;
+    }
+  } else {
+    if ((_M_values = create(dir, c.name, to_string(c.type))) == -1) {
+      return false;
+    }
+  }
+
+  return ((_M_validity = create(dir, c.name, "validity")) != -1);
+}
+
+bool asn1::ber::column_writer::write(const column_data& data)
+{
+  // Strings?
+  if (_M_data != -1) {
+    if (!write(_M_data, data.data(), data.data_length())) {
+      return false;
+    }
+
+    // Rebase the offsets.
+    static const size_t block = 1024;
+
+    uint64_t offsets[block];
+
+    for (size_t i = 0; i < data.records(); i += block) {
+      size_t n = (data.records() - i < block) ? data.records() - i : block;
+
+      for (size_t j = 0; j < n; j++) {
+        offsets[j] = htole64(le64toh(data.values()[i + j]) + _M_datalen);
+      }
+
+      if (!write(_M_values, offsets, n * sizeof(uint64_t))) {
+        return false;
+      }
+    }
+
+    _M_datalen += data.data_length();
+  } else {
+    if (!write(_M_values,
+               data.values(),
+               data.records() * sizeof(uint64_t))) {
+      return false;
+    }
+  }
+
+  return write_validity(data.validity(), data.records());
+}
+
+bool asn1::ber::column_writer::close()
+{
+  bool ret = true;
+
+  if (_M_validity != -1) {
+    // Write the last byte of the bitmap.
+    if (_M_nbits > 0) {
+      ret = write(_M_validity, &_M_bits, 1);
+      _M_nbits = 0;
+    }
+
+    ret = ((::close(_M_validity) == 0) && (ret));
+    _M_validity = -1;
+  }
+
+  if (_M_values != -1) {
+    ret = ((::close(_M_values) == 0) && (ret));
+    _M_values = -1;
+  }
+
+  if (_M_data != -1) {
+    ret = ((::close(_M_data) == 0) && (ret));
+    _M_data = -1;
+  }
+
+  return ret;
+}
+
+int asn1::ber::column_writer::create(const char* dir,
+                                     const char* name,
+                                     const char* ext)
+{
+  char filename[PATH_MAX];
+  if (snprintf(filename,
+               sizeof(filename),
+               "%s/%s.%s",
+               dir,
+               name,
+               ext) < static_cast<int>(sizeof(filename))) {
+    return ::open(filename, O_CREAT | O_TRUNC | O_WRONLY, 0644);
+  }
+
+  return -1;
+}
+
+bool asn1::ber::column_writer::write(int fd, const void* buf, size_t len)
+{
+  const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+  while (len > 0) {
+    ssize_t ret;
+    if ((ret = ::write(fd, b, len)) > 0) {
+      b += ret;
+      len -= ret;
+    } else if ((ret < 0) && (errno == EINTR)) {
+      continue;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::column_writer::write_validity(const uint8_t* validity,
+                                              size_t records)
+{
+  // If the bitmap is aligned to a byte...
+  if (_M_nbits == 0) {
+    if (!write(_M_validity, validity, records / 8)) {
+      return false;
+    }
+
+    if ((_M_nbits = records % 8) > 0) {
+      _M_bits = validity[records / 8] &
+                static_cast<uint8_t>((1 << _M_nbits) - 1);
+    }
+
+    return true;
+  }
+
+  // Shift the bitmap.
+  static const size_t block = 4096;
+
+  uint8_t buf[block];
+  size_t len = 0;
+
+  for (size_t i = 0; i < records; ) {
+    unsigned n = (records - i >= 8) ? 8 : records - i;
+    uint8_t b = validity[i / 8] & static_cast<uint8_t>((1 << n) - 1);
+
+    unsigned total = _M_nbits + n;
+
+    uint16_t bits = _M_bits | (static_cast<uint16_t>(b) << _M_nbits);
+
+    if (total >= 8) {
+      buf[len++] = static_cast<uint8_t>(bits);
+
+      if (len == block) {
+        if (!write(_M_validity, buf, len)) {
+          return false;
+        }
+
+        len = 0;
+      }
+
+      _M_bits = static_cast<uint8_t>(bits >> 8);
+      _M_nbits = total - 8;
+    } else {
+      _M_bits = static_cast<uint8_t>(bits);
+      _M_nbits = total;
+    }
+
+    i += n;
+  }
+
+  return write(_M_validity, buf, len);
+}
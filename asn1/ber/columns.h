@@ -0,0 +1,392 @@
+#ifndef ASN1_BER_COLUMNS_H
+#define ASN1_BER_COLUMNS_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/error.h"
+#include "asn1/ber/path.h"
+
+namespace asn1 {
+  namespace ber {
+    // Type of a column.
+    enum class column_type {
+      // INTEGER, ENUMERATED and BOOLEAN values (or primitives with the
+      // encoding of an integer of up to 8 octets).
+      Int64,
+
+      // Contents octets of the value.
+      String,
+
+      // UTCTime and GeneralizedTime values (or primitives with their
+      // encoding), as microseconds since the epoch.
+      Time
+    };
+
+    static inline const char* to_string(column_type type)
+    {
+      switch (type) {
+        case column_type::Int64:  return "int64";
+        case column_type::String: return "string";
+        case column_type::Time:   return "time";
+        default:                  return "(unknown)";
+      }
+    }
+
+    // Column: value at 'path' of each record (the first one, if the path
+    // appears several times).
+    struct column {
+      const char* name;
+      column_type type;
+      asn1::ber::path path;
+    };
+
+    // Values of a column for a range of records.
+    // For the strings, 'values' has the offset of the end of each string in
+    // 'data'. The values are stored in little-endian.
+    class column_data {
+      public:
+        // Constructor.
+        column_data() = default;
+
+        // Destructor.
+        ~column_data();
+
+        // Clear.
+        void clear()
+        {
+          _M_records = 0;
+          _M_datalen = 0;
+        }
+
+        // Add value of the next record.
+        bool add(bool valid, int64_t value);
+
+        // Add the string of the next record (its data has already been
+        // appended).
+        bool add_string(bool valid)
+        {
+          return add(valid, static_cast<int64_t>(_M_datalen));
+        }
+
+        // Append data to the string of the current record.
+        bool append(const void* buf, size_t len);
+
+        // Get number of records.
+        size_t records() const
+        {
+          return _M_records;
+        }
+
+        // Get values.
+        const uint64_t* values() const
+        {
+          return _M_values;
+        }
+
+        // Get validity bitmap (bit 'i % 8' of the byte 'i / 8' is set if
+        // the record 'i' has value).
+        const uint8_t* validity() const
+        {
+          return _M_validity;
+        }
+
+        // Get data of the strings.
+        const uint8_t* data() const
+        {
+          return _M_data;
+        }
+
+        // Get length of the data of the strings.
+        size_t data_length() const
+        {
+          return _M_datalen;
+        }
+
+      private:
+        uint64_t* _M_values = nullptr;
+        uint8_t* _M_validity = nullptr;
+        size_t _M_size = 0;
+        size_t _M_records = 0;
+
+        uint8_t* _M_data = nullptr;
+        size_t _M_datasize = 0;
+        size_t _M_datalen = 0;
+
+        // Grow the arrays of the values and of the validity bitmap.
+        bool grow();
+
+        // Disable copy constructor and assignment operator.
+        column_data(const column_data&) = delete;
+        column_data& operator=(const column_data&) = delete;
+    };
+
+    // ASN.1 object which extracts the values of the columns from the
+    // records.
+    // begin_record() has to be called before decoding each record and
+    // end_record() after decoding it.
+    class column_extractor {
+      public:
+        // Maximum number of columns.
+        static const size_t max_columns = 64;
+
+        // Constructor.
+        column_extractor(const column* columns,
+                         size_t ncolumns,
+                         column_data* data)
+          : _M_columns(columns),
+            _M_ncolumns(ncolumns),
+            _M_data(data)
+        {
+        }
+
+        // Destructor.
+        ~column_extractor() = default;
+
+        // Begin record.
+        void begin_record()
+        {
+          _M_depth = 0;
+          _M_masks[0] = (_M_ncolumns < 64) ?
+                          (static_cast<uint64_t>(1) << _M_ncolumns) - 1 :
+                          ~static_cast<uint64_t>(0);
+          _M_found = 0;
+          _M_valid = 0;
+          _M_strings = 0;
+        }
+
+        // End record.
+        bool end_record();
+
+        // Start constructed.
+        bool start_constructed(tag_class tc,
+                               tag_number tn,
+                               uint64_t valuelen,
+                               uint64_t totallen);
+
+        // End constructed.
+        bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+        {
+          _M_depth--;
+          return true;
+        }
+
+        // Boolean.
+        bool boolean(const void* buf, uint64_t len, bool val)
+        {
+          return int64_value(universal_class::Boolean, buf, len, val ? 1 : 0);
+        }
+
+        // Integer.
+        bool integer(const void* buf, uint64_t len, int64_t val)
+        {
+          return int64_value(universal_class::Integer, buf, len, val);
+        }
+
+        // Null.
+        bool null()
+        {
+          return true;
+        }
+
+        // Object identifier.
+        bool oid(const void* buf,
+                 uint64_t len,
+                 const uint64_t* oid,
+                 size_t ncomponents)
+        {
+          return string_value(universal_class::ObjectIdentifier, buf, len);
+        }
+
+        // Real.
+        bool real(const void* buf, uint64_t len, double val)
+        {
+          return string_value(universal_class::Real, buf, len);
+        }
+
+        // Enumerated.
+        bool enumerated(const void* buf, uint64_t len, int64_t val)
+        {
+          return int64_value(universal_class::Enumerated, buf, len, val);
+        }
+
+        // UTC time.
+        bool utc_time(const void* buf, uint64_t len, time_t val)
+        {
+          return time_value(universal_class::UTCTime,
+                            buf,
+                            len,
+                            static_cast<int64_t>(val) * 1000000);
+        }
+
+        // Generalized time.
+        bool generalized_time(const void* buf,
+                              uint64_t len,
+                              const struct timeval& val)
+        {
+          return time_value(universal_class::GeneralizedTime,
+                            buf,
+                            len,
+                            (static_cast<int64_t>(val.tv_sec) * 1000000) +
+                            val.tv_usec);
+        }
+
+        // Primitive.
+        bool primitive(tag_class tc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t valueoff,
+                       uint64_t valuelen);
+
+        // Error.
+        void error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        const column* const _M_columns;
+        const size_t _M_ncolumns;
+
+        column_data* const _M_data;
+
+        // Columns whose path matches the tags of the constructed values at
+        // each depth.
+        uint64_t _M_masks[path::max_steps + 1];
+
+        size_t _M_depth;
+
+        // Columns whose value has been found / is valid in the current
+        // record.
+        uint64_t _M_found;
+        uint64_t _M_valid;
+
+        // String columns receiving the chunks of the current primitive.
+        uint64_t _M_strings;
+
+        // Values (integers and times) of the current record.
+        int64_t _M_values[max_columns];
+
+        enum error _M_error = error::callback;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+
+        // Get the columns (not found yet) whose path ends at the value with
+        // the tag 'tc' / 'tn' at the current depth.
+        uint64_t match(tag_class tc, tag_number tn) const;
+
+        // Integer value.
+        bool int64_value(universal_class uc,
+                         const void* buf,
+                         uint64_t len,
+                         int64_t val);
+
+        // Time value.
+        bool time_value(universal_class uc,
+                        const void* buf,
+                        uint64_t len,
+                        int64_t val);
+
+        // Value which is only extracted by the string columns.
+        bool string_value(universal_class uc, const void* buf, uint64_t len);
+    };
+
+    // Writer of the files of a column:
+    //   - <name>.int64 / <name>.time: values (int64, little-endian, 0 for
+    //     the records without value).
+    //   - <name>.offsets / <name>.data: offsets of the strings (uint64,
+    //     little-endian, number of records + 1) and the strings.
+    //   - <name>.validity: validity bitmap.
+    class column_writer {
+      public:
+        // Constructor.
+        column_writer() = default;
+
+        // Destructor.
+        ~column_writer();
+
+        // Create the files of the column 'c' in the directory 'dir'.
+        bool open(const char* dir, const column& c);
+
+        // Write the values of a range of records.
+        bool write(const column_data& data);
+
+        // Close.
+        bool close();
+
+      private:
+        int _M_values = -1;
+        int _M_data = -1;
+        int _M_validity = -1;
+
+        // Length of the data written.
+        uint64_t _M_datalen = 0;
+
+        // Bits of the validity bitmap which don't complete a byte yet.
+        uint8_t _M_bits = 0;
+        unsigned _M_nbits = 0;
+
+        // Create file.
+        static int create(const char* dir, const char* name, const char* ext);
+
+        // Write.
+        static bool write(int fd, const void* buf, size_t len);
+
+        // Write validity bitmap.
+        bool write_validity(const uint8_t* validity, size_t records);
+
+        // Disable copy constructor and assignment operator.
+        column_writer(const column_writer&) = delete;
+        column_writer& operator=(const column_writer&) = delete;
+    };
+
+    inline uint64_t column_extractor::match(tag_class tc, tag_number tn) const
+    {
+      uint64_t matched = 0;
+
+      if (_M_depth < path::max_steps) {
+        uint64_t mask = _M_masks[_M_depth] & ~_M_found;
+
+        while (mask) {
+          unsigned c = __builtin_ctzll(mask);
+          mask &= mask - 1;
+
+          const asn1::ber::path& p = _M_columns[c].path;
+
+          if ((p.size() == _M_depth + 1) &&
+              (p[_M_depth].tc == tc) &&
+              (p[_M_depth].tn == tn)) {
+            matched |= static_cast<uint64_t>(1) << c;
+          }
+        }
+      }
+
+      return matched;
+    }
+  }
+}
+
+#endif // ASN1_BER_COLUMNS_H
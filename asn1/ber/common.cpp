@@ -4,395 +4,6 @@
 
 #define IS_DIGIT(x) (((x) >= '0') && ((x) <= '9'))
 
-size_t asn1::ber::encode_tag(tag_class tc,
-                             primitive_constructed pc,
-                             tag_number tn,
-                             uint8_t* buf)
-{
-  if (tn < 31) {
-    buf[0] = (static_cast<uint8_t>(tc) << 6) |
-             (static_cast<uint8_t>(pc) << 5) |
-             static_cast<uint8_t>(tn);
-
-    return 1;
-  } else {
-    buf[0] = (static_cast<uint8_t>(tc) << 6) |
-             (static_cast<uint8_t>(pc) << 5) |
-             static_cast<uint8_t>(0x1f);
-
-    if (tn <= 0x7full) {
-      buf[1] = static_cast<uint8_t>(tn);
-
-      return 2;
-    } else if (tn <= 0x3fffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[2] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 3;
-    } else if (tn <= 0x1fffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[3] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 4;
-    } else if (tn <= 0xfffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[4] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 5;
-    } else if (tn <= 0x7ffffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[5] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 6;
-    } else if (tn <= 0x3ffffffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[5] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[6] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 7;
-    } else if (tn <= 0x1ffffffffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[5] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[6] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[7] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 8;
-    } else if (tn <= 0xffffffffffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[5] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[6] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[7] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[8] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 9;
-    } else if (tn <= 0x7fffffffffffffffull) {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 56) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
-      buf[5] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[6] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[7] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[8] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[9] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 10;
-    } else {
-      buf[1] = 0x80 | static_cast<uint8_t>((tn >> 63) & 0x7f);
-      buf[2] = 0x80 | static_cast<uint8_t>((tn >> 56) & 0x7f);
-      buf[3] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
-      buf[4] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
-      buf[5] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
-      buf[6] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
-      buf[7] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
-      buf[8] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
-      buf[9] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
-      buf[10] = static_cast<uint8_t>(tn & 0x7f);
-
-      return 11;
-    }
-
-    // More compact but slower.
-/*
-    int i;
-    for (i = 63; (i > 0) && (((tn >> i) & 0x7f) == 0); i -= 7);
-
-    uint8_t* ptr = buf + 1;
-
-    for (; i > 0; i -= 7) {
-      *ptr++ = 0x80 | ((tn >> i) & 0x7f);
-    }
-
-    *ptr = tn & 0x7f;
-
-    return ptr + 1 - buf;
-*/
-  }
-}
-
-size_t asn1::ber::encode_length(size_t len, uint8_t* buf)
-{
-  if (len <= 0x7full) {
-    buf[0] = static_cast<uint8_t>(len);
-    return 1;
-  } else if (len <= 0xffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(1);
-
-    buf[1] = static_cast<uint8_t>(len);
-
-    return 2;
-  } else if (len <= 0xffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(2);
-
-    buf[1] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[2] = static_cast<uint8_t>(len & 0xff);
-
-    return 3;
-  } else if (len <= 0xffffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(3);
-
-    buf[1] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[3] = static_cast<uint8_t>(len & 0xff);
-
-    return 4;
-  } else if (len <= 0xffffffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(4);
-
-    buf[1] = static_cast<uint8_t>((len >> 24) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[3] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[4] = static_cast<uint8_t>(len & 0xff);
-
-    return 5;
-  } else if (len <= 0xffffffffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(5);
-
-    buf[1] = static_cast<uint8_t>((len >> 32) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 24) & 0xff);
-    buf[3] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[4] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[5] = static_cast<uint8_t>(len & 0xff);
-
-    return 6;
-  } else if (len <= 0xffffffffffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(6);
-
-    buf[1] = static_cast<uint8_t>((len >> 40) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 32) & 0xff);
-    buf[3] = static_cast<uint8_t>((len >> 24) & 0xff);
-    buf[4] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[5] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[6] = static_cast<uint8_t>(len & 0xff);
-
-    return 7;
-  } else if (len <= 0xffffffffffffffull) {
-    buf[0] = 0x80 | static_cast<uint8_t>(7);
-
-    buf[1] = static_cast<uint8_t>((len >> 48) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 40) & 0xff);
-    buf[3] = static_cast<uint8_t>((len >> 32) & 0xff);
-    buf[4] = static_cast<uint8_t>((len >> 24) & 0xff);
-    buf[5] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[6] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[7] = static_cast<uint8_t>(len & 0xff);
-
-    return 8;
-  } else {
-    buf[0] = 0x80 | static_cast<uint8_t>(8);
-
-    buf[1] = static_cast<uint8_t>((len >> 56) & 0xff);
-    buf[2] = static_cast<uint8_t>((len >> 48) & 0xff);
-    buf[3] = static_cast<uint8_t>((len >> 40) & 0xff);
-    buf[4] = static_cast<uint8_t>((len >> 32) & 0xff);
-    buf[5] = static_cast<uint8_t>((len >> 24) & 0xff);
-    buf[6] = static_cast<uint8_t>((len >> 16) & 0xff);
-    buf[7] = static_cast<uint8_t>((len >> 8) & 0xff);
-    buf[8] = static_cast<uint8_t>(len & 0xff);
-
-    return 9;
-  }
-
-  // More compact but slower.
-/*
-  if (len <= 0x7full) {
-    buf[0] = static_cast<uint8_t>(len);
-    return 1;
-  } else {
-    int i;
-    for (i = 56; (i > 0) && (((len >> i) & 0xff) == 0); i -= 8);
-
-    uint8_t* b = buf + 1;
-
-    for (; i >= 0; i -= 8) {
-      *b++ = (len >> i) & 0xff;
-    }
-
-    size_t noctets = b - 1 - buf;
-
-    buf[0] = 0x80 | static_cast<uint8_t>(noctets);
-
-    return 1 + noctets;
-  }
-*/
-}
-
-size_t asn1::ber::encode_integer(int64_t n, uint8_t* buf)
-{
-  // If the value is positive.
-  if (n >= 0) {
-    if (n < 0x80ll) {
-      buf[0] = static_cast<uint8_t>(n);
-
-      return 1;
-    } else if (n < 0x8000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[1] = static_cast<uint8_t>(n & 0xff);
-
-      return 2;
-    } else if (n < 0x800000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[2] = static_cast<uint8_t>(n & 0xff);
-
-      return 3;
-    } else if (n < 0x80000000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 24) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[2] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[3] = static_cast<uint8_t>(n & 0xff);
-
-      return 4;
-    } else if (n < 0x8000000000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 32) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 24) & 0xff);
-      buf[2] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[3] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[4] = static_cast<uint8_t>(n & 0xff);
-
-      return 5;
-    } else if (n < 0x800000000000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 40) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 32) & 0xff);
-      buf[2] = static_cast<uint8_t>((n >> 24) & 0xff);
-      buf[3] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[4] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[5] = static_cast<uint8_t>(n & 0xff);
-
-      return 6;
-    } else if (n < 0x80000000000000ll) {
-      buf[0] = static_cast<uint8_t>((n >> 48) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 40) & 0xff);
-      buf[2] = static_cast<uint8_t>((n >> 32) & 0xff);
-      buf[3] = static_cast<uint8_t>((n >> 24) & 0xff);
-      buf[4] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[5] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[6] = static_cast<uint8_t>(n & 0xff);
-
-      return 7;
-    } else {
-      buf[0] = static_cast<uint8_t>((n >> 56) & 0xff);
-      buf[1] = static_cast<uint8_t>((n >> 48) & 0xff);
-      buf[2] = static_cast<uint8_t>((n >> 40) & 0xff);
-      buf[3] = static_cast<uint8_t>((n >> 32) & 0xff);
-      buf[4] = static_cast<uint8_t>((n >> 24) & 0xff);
-      buf[5] = static_cast<uint8_t>((n >> 16) & 0xff);
-      buf[6] = static_cast<uint8_t>((n >> 8) & 0xff);
-      buf[7] = static_cast<uint8_t>(n & 0xff);
-
-      return 8;
-    }
-  } else if (n >= -0x80ll) {
-    buf[0] = static_cast<uint8_t>(n);
-
-    return 1;
-  } else if (n >= -0x8000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[1] = static_cast<uint8_t>(n & 0xff);
-
-    return 2;
-  } else if (n >= -0x800000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[2] = static_cast<uint8_t>(n & 0xff);
-
-    return 3;
-  } else if (n >= -0x80000000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 24) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[2] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[3] = static_cast<uint8_t>(n & 0xff);
-
-    return 4;
-  } else if (n >= -0x8000000000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 32) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 24) & 0xff);
-    buf[2] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[3] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[4] = static_cast<uint8_t>(n & 0xff);
-
-    return 5;
-  } else if (n >= -0x800000000000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 40) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 32) & 0xff);
-    buf[2] = static_cast<uint8_t>((n >> 24) & 0xff);
-    buf[3] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[4] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[5] = static_cast<uint8_t>(n & 0xff);
-
-    return 6;
-  } else if (n >= -0x80000000000000ll) {
-    buf[0] = static_cast<uint8_t>((n >> 48) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 40) & 0xff);
-    buf[2] = static_cast<uint8_t>((n >> 32) & 0xff);
-    buf[3] = static_cast<uint8_t>((n >> 24) & 0xff);
-    buf[4] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[5] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[6] = static_cast<uint8_t>(n & 0xff);
-
-    return 7;
-  } else {
-    buf[0] = static_cast<uint8_t>((n >> 56) & 0xff);
-    buf[1] = static_cast<uint8_t>((n >> 48) & 0xff);
-    buf[2] = static_cast<uint8_t>((n >> 40) & 0xff);
-    buf[3] = static_cast<uint8_t>((n >> 32) & 0xff);
-    buf[4] = static_cast<uint8_t>((n >> 24) & 0xff);
-    buf[5] = static_cast<uint8_t>((n >> 16) & 0xff);
-    buf[6] = static_cast<uint8_t>((n >> 8) & 0xff);
-    buf[7] = static_cast<uint8_t>(n & 0xff);
-
-    return 8;
-  }
-
-  // More compact but slower.
-/*
-  uint8_t* v = buf;
-  size_t len;
-  int i;
-
-  if (n >= 0) {
-    for (i = 56; (i > 0) && (((n >> i) & 0xff) == 0); i -= 8);
-
-    if (((n >> i) & 0x80) == 0x80) {
-      v[0] = 0;
-      len = 1;
-    } else {
-      len = 0;
-    }
-  } else {
-    for (i = 56; (i > 0) && (((n >> i) & 0xff) == 0xff); i -= 8);
-
-    if (((n >> i) & 0x80) == 0x00) {
-      v[0] = static_cast<uint8_t>(0xff);
-      len = 1;
-    } else {
-      len = 0;
-    }
-  }
-
-  for (; i >= 0; i -= 8) {
-    v[len++] = (n >> i) & 0xff;
-  }
-
-  return len;
-*/
-}
-
 static inline void encode_significand(uint64_t significand,
                                       size_t len,
                                       uint8_t* buf)
@@ -687,79 +298,45 @@ size_t asn1::ber::encode_generalized_time(const struct timeval& tv,
   return len + 1;
 }
 
-int64_t asn1::ber::decode_integer(const void* buf, uint64_t len)
+size_t asn1::ber::oid_length(const uint64_t* oid, size_t ncomponents)
 {
-  const uint8_t* const b = static_cast<const uint8_t*>(buf);
-
-  uint64_t n;
-
-  switch (len) {
-    case 8:
-      n  = (static_cast<uint64_t>(b[0]) << 56);
-      n |= (static_cast<uint64_t>(b[1]) << 48);
-      n |= (static_cast<uint64_t>(b[2]) << 40);
-      n |= (static_cast<uint64_t>(b[3]) << 32);
-      n |= (static_cast<uint64_t>(b[4]) << 24);
-      n |= (static_cast<uint64_t>(b[5]) << 16);
-      n |= (static_cast<uint64_t>(b[6]) << 8);
-      n |=  static_cast<uint64_t>(b[7]);
-
-      return n;
-    case 7:
-      n =  (static_cast<uint64_t>(b[0]) << 48);
-      n |= (static_cast<uint64_t>(b[1]) << 40);
-      n |= (static_cast<uint64_t>(b[2]) << 32);
-      n |= (static_cast<uint64_t>(b[3]) << 24);
-      n |= (static_cast<uint64_t>(b[4]) << 16);
-      n |= (static_cast<uint64_t>(b[5]) << 8);
-      n |=  static_cast<uint64_t>(b[6]);
+  // The first two components are encoded in the first subidentifier.
+  if ((ncomponents >= 2) &&
+      (ncomponents <= max_oid_components) &&
+      (((oid[0] < 2) && (oid[1] < 40)) ||
+       ((oid[0] == 2) && (oid[1] <= ~static_cast<uint64_t>(0) - 80)))) {
+    size_t len = (70 - __builtin_clzll((oid[0] * 40 + oid[1]) | 1)) / 7;
+
+    for (size_t i = 2; i < ncomponents; i++) {
+      len += (70 - __builtin_clzll(oid[i] | 1)) / 7;
+    }
 
-      break;
-    case 6:
-      n =  (static_cast<uint64_t>(b[0]) << 40);
-      n |= (static_cast<uint64_t>(b[1]) << 32);
-      n |= (static_cast<uint64_t>(b[2]) << 24);
-      n |= (static_cast<uint64_t>(b[3]) << 16);
-      n |= (static_cast<uint64_t>(b[4]) << 8);
-      n |=  static_cast<uint64_t>(b[5]);
+    return len;
+  }
 
-      break;
-    case 5:
-      n =  (static_cast<uint64_t>(b[0]) << 32);
-      n |= (static_cast<uint64_t>(b[1]) << 24);
-      n |= (static_cast<uint64_t>(b[2]) << 16);
-      n |= (static_cast<uint64_t>(b[3]) << 8);
-      n |=  static_cast<uint64_t>(b[4]);
+  return 0;
+}
 
-      break;
-    case 4:
-      n =  (static_cast<uint64_t>(b[0]) << 24);
-      n |= (static_cast<uint64_t>(b[1]) << 16);
-      n |= (static_cast<uint64_t>(b[2]) << 8);
-      n |=  static_cast<uint64_t>(b[3]);
+size_t asn1::ber::encode_oid(const uint64_t* oid,
+                             size_t ncomponents,
+                             uint8_t* buf)
+{
+  size_t len = 0;
 
-      break;
-    case 3:
-      n =  (static_cast<uint64_t>(b[0]) << 16);
-      n |= (static_cast<uint64_t>(b[1]) << 8);
-      n |=  static_cast<uint64_t>(b[2]);
+  for (size_t i = 1; i < ncomponents; i++) {
+    uint64_t subidentifier = (i > 1) ? oid[i] : (oid[0] * 40) + oid[1];
 
-      break;
-    case 2:
-      n =  (static_cast<uint64_t>(b[0]) << 8);
-      n |=  static_cast<uint64_t>(b[1]);
+    // Write the subidentifier in groups of 7 bits, most significant first.
+    for (int shift = 7 * (((70 - __builtin_clzll(subidentifier | 1)) / 7) - 1);
+         shift > 0;
+         shift -= 7) {
+      buf[len++] = 0x80 | static_cast<uint8_t>((subidentifier >> shift) & 0x7f);
+    }
 
-      break;
-    default:
-      n = static_cast<uint64_t>(b[0]);
+    buf[len++] = static_cast<uint8_t>(subidentifier & 0x7f);
   }
 
-  // If the number is positive...
-  if ((*b & 0x80) == 0) {
-    return n;
-  } else {
-    return ((~static_cast<uint64_t>(0) << (len << 3)) | n);
-  }
+  return len;
 }
 
 static bool decode_exponent(const uint8_t* b,
@@ -1860,3 +1437,147 @@ bool asn1::ber::decode_oid(const void* buf,
 
   return false;
 }
+
+bool asn1::ber::decode_header(const void* buf, size_t len, header& h)
+{
+  const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+  if (len >= 2) {
+    h.tc = static_cast<tag_class>((b[0] >> 6) & 0x03);
+    h.pc = static_cast<primitive_constructed>((b[0] >> 5) & 0x01);
+
+    size_t off;
+
+    // Low tag number?
+    if ((h.tn = b[0] & 0x1f) < 0x1f) {
+      off = 1;
+    } else {
+      h.tn = 0;
+
+      for (off = 1; ; off++) {
+        if (off == len) {
+          return false;
+        }
+
+        // If the tag number is not too big...
+        if (off <= 9) {
+          h.tn = (h.tn << 7) | (b[off] & 0x7f);
+
+          // If the most significant bit is not set...
+          if ((b[off] & 0x80) == 0) {
+            off++;
+            break;
+          }
+        } else if (b[off] <= 1) {
+          h.tn = (h.tn << 1) | b[off];
+
+          off++;
+          break;
+        } else {
+          return false;
+        }
+      }
+
+      if (off == len) {
+        return false;
+      }
+    }
+
+    // Short form?
+    if ((b[off] & 0x80) == 0) {
+      h.indefinite = false;
+      h.valuelen = b[off];
+      h.len = off + 1;
+
+      return true;
+    }
+
+    size_t lenlen = b[off] & 0x7f;
+
+    // Indefinite form?
+    if (lenlen == 0) {
+      if (h.pc == primitive_constructed::Constructed) {
+        h.indefinite = true;
+        h.valuelen = 0;
+        h.len = off + 1;
+
+        return true;
+      }
+
+      return false;
+    }
+
+    // Long form.
+    if ((lenlen <= 8) && (off + 1 + lenlen <= len)) {
+      h.valuelen = 0;
+
+      for (size_t i = 1; i <= lenlen; i++) {
+        h.valuelen = (h.valuelen << 8) | b[off + i];
+      }
+
+      h.indefinite = false;
+      h.len = off + 1 + lenlen;
+
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint64_t asn1::ber::tlv_length(const void* buf, size_t len)
+{
+  const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+  // Number of values with indefinite length which have not been ended.
+  size_t depth = 0;
+
+  size_t off = 0;
+
+  do {
+    header h;
+    if (!decode_header(b + off, len - off, h)) {
+      return 0;
+    }
+
+    off += h.len;
+
+    if (h.indefinite) {
+      depth++;
+    } else {
+      if (h.valuelen > len - off) {
+        return 0;
+      }
+
+      off += h.valuelen;
+
+      // End-of-contents?
+      if ((h.tc == tag_class::Universal) && (h.tn == 0)) {
+        if ((depth == 0) || (h.valuelen != 0)) {
+          return 0;
+        }
+
+        depth--;
+      }
+    }
+  } while (depth > 0);
+
+  return off;
+}
+
+bool asn1::ber::check_header(const void* buf, size_t len)
+{
+  const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+  header h;
+  if (!decode_header(b, len, h)) {
+    return false;
+  }
+
+  if (!h.indefinite) {
+    return (h.valuelen == len - h.len);
+  }
+
+  // End-of-contents?
+  return ((len >= h.len + 2) && (b[len - 2] == 0) && (b[len - 1] == 0));
+}
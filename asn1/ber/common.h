@@ -2,7 +2,9 @@
 #define ASN1_BER_COMMON_H
 
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <endian.h>
 #include <sys/time.h>
 #include "asn1/ber/tag.h"
 
@@ -11,14 +13,175 @@ namespace asn1 {
     // Maximum number of object identifier components.
     static constexpr const size_t max_oid_components = 64;
 
-    size_t encode_tag(tag_class tc,
-                      primitive_constructed pc,
-                      tag_number tn,
-                      uint8_t* buf);
+    // Get the number of octets of the encoded tag.
+    static constexpr size_t tag_length(tag_number tn)
+    {
+      return (tn < 31) ? 1 : 1 + ((70 - __builtin_clzll(tn)) / 7);
+    }
 
-    size_t encode_length(size_t len, uint8_t* buf);
+    // Get the number of octets of the encoded length.
+    static constexpr size_t length_length(size_t len)
+    {
+      return (len <= 0x7f) ? 1 : 1 + ((71 - __builtin_clzll(len)) / 8);
+    }
 
-    size_t encode_integer(int64_t n, uint8_t* buf);
+    // Get the number of octets of the encoded integer.
+    static constexpr size_t integer_length(int64_t n)
+    {
+      // Number of significant bits (without the sign bit) + the sign bit.
+      return (72 - __builtin_clzll((static_cast<uint64_t>(n) ^
+                                    static_cast<uint64_t>(n >> 63)) | 1)) / 8;
+    }
+
+    // Encode tag with full-word stores: 'buf' must have space for 11 octets,
+    // even if the tag has fewer.
+    static inline size_t encode_tag_padded(tag_class tc,
+                                           primitive_constructed pc,
+                                           tag_number tn,
+                                           uint8_t* buf)
+    {
+      const uint8_t identifier = (static_cast<uint8_t>(tc) << 6) |
+                                 (static_cast<uint8_t>(pc) << 5);
+
+      if (tn < 31) {
+        buf[0] = identifier | static_cast<uint8_t>(tn);
+        return 1;
+      }
+
+      buf[0] = identifier | static_cast<uint8_t>(0x1f);
+
+      const size_t len = tag_length(tn);
+
+      // If the tag number fits in 8 groups of 7 bits...
+      if (len <= 9) {
+        // Spread the groups of 7 bits over the octets.
+        uint64_t n = (tn & 0x7full) |
+                     ((tn << 1) & 0x7f00ull) |
+                     ((tn << 2) & 0x7f0000ull) |
+                     ((tn << 3) & 0x7f000000ull) |
+                     ((tn << 4) & 0x7f00000000ull) |
+                     ((tn << 5) & 0x7f0000000000ull) |
+                     ((tn << 6) & 0x7f000000000000ull) |
+                     ((tn << 7) & 0x7f00000000000000ull);
+
+        // Set the most significant bit of all the octets but the last one and
+        // store the octets with a single big-endian store.
+        n = htobe64((n | 0x8080808080808000ull) << (72 - (len << 3)));
+
+        memcpy(buf + 1, &n, sizeof(uint64_t));
+      } else {
+        // Write the tag number in groups of 7 bits, most significant first.
+        for (size_t i = 1, shift = 7 * (len - 2); i < len - 1; i++) {
+          buf[i] = 0x80 | static_cast<uint8_t>((tn >> shift) & 0x7f);
+          shift -= 7;
+        }
+
+        buf[len - 1] = static_cast<uint8_t>(tn & 0x7f);
+      }
+
+      return len;
+    }
+
+    // Encode length with full-word stores: 'buf' must have space for 9
+    // octets, even if the length has fewer (up to 9 octets are written).
+    static inline size_t encode_length_padded(size_t len, uint8_t* buf)
+    {
+      // Short form?
+      if (len <= 0x7f) {
+        buf[0] = static_cast<uint8_t>(len);
+        return 1;
+      }
+
+      const size_t noctets = length_length(len) - 1;
+
+      buf[0] = 0x80 | static_cast<uint8_t>(noctets);
+
+      // Store the length octets with a single big-endian store.
+      const uint64_t n = htobe64(static_cast<uint64_t>(len) <<
+                                 (64 - (noctets << 3)));
+
+      memcpy(buf + 1, &n, sizeof(uint64_t));
+
+      return 1 + noctets;
+    }
+
+    // Encode integer with a full-word store: 'buf' must have space for 8
+    // octets, even if the integer has fewer (8 octets are written).
+    static inline size_t encode_integer_padded(int64_t n, uint8_t* buf)
+    {
+      const size_t noctets = integer_length(n);
+
+      // Store the octets with a single big-endian store.
+      const uint64_t u64 = htobe64(static_cast<uint64_t>(n) <<
+                                   (64 - (noctets << 3)));
+
+      memcpy(buf, &u64, sizeof(uint64_t));
+
+      return noctets;
+    }
+
+    // Copy 'len' (1 - 16) octets with two overlapping fixed-size copies.
+    static inline void copy_octets(uint8_t* dst, const uint8_t* src, size_t len)
+    {
+      if (len >= 8) {
+        memcpy(dst, src, 8);
+        memcpy(dst + len - 8, src + len - 8, 8);
+      } else if (len >= 4) {
+        memcpy(dst, src, 4);
+        memcpy(dst + len - 4, src + len - 4, 4);
+      } else if (len >= 2) {
+        memcpy(dst, src, 2);
+        memcpy(dst + len - 2, src + len - 2, 2);
+      } else {
+        dst[0] = src[0];
+      }
+    }
+
+    // Encode tag (only the octets of the tag are written).
+    static inline size_t encode_tag(tag_class tc,
+                                    primitive_constructed pc,
+                                    tag_number tn,
+                                    uint8_t* buf)
+    {
+      if (tn < 31) {
+        buf[0] = (static_cast<uint8_t>(tc) << 6) |
+                 (static_cast<uint8_t>(pc) << 5) |
+                 static_cast<uint8_t>(tn);
+
+        return 1;
+      }
+
+      uint8_t b[11];
+      const size_t len = encode_tag_padded(tc, pc, tn, b);
+      copy_octets(buf, b, len);
+
+      return len;
+    }
+
+    // Encode length (only the octets of the length are written).
+    static inline size_t encode_length(size_t len, uint8_t* buf)
+    {
+      if (len <= 0x7f) {
+        buf[0] = static_cast<uint8_t>(len);
+        return 1;
+      }
+
+      uint8_t b[9];
+      const size_t noctets = encode_length_padded(len, b);
+      copy_octets(buf, b, noctets);
+
+      return noctets;
+    }
+
+    // Encode integer (only the octets of the integer are written).
+    static inline size_t encode_integer(int64_t n, uint8_t* buf)
+    {
+      uint8_t b[8];
+      const size_t noctets = encode_integer_padded(n, b);
+      copy_octets(buf, b, noctets);
+
+      return noctets;
+    }
 
     size_t encode_real(double n, uint8_t* buf);
 
@@ -26,7 +189,92 @@ namespace asn1 {
 
     size_t encode_generalized_time(const struct timeval& tv, uint8_t* buf);
 
-    int64_t decode_integer(const void* buf, uint64_t len);
+    // Get the number of octets of the encoded object identifier (0 if the
+    // object identifier is not valid).
+    size_t oid_length(const uint64_t* oid, size_t ncomponents);
+
+    // Encode object identifier ('buf' must have space for oid_length()
+    // octets).
+    size_t encode_oid(const uint64_t* oid, size_t ncomponents, uint8_t* buf);
+
+    // Decode integer.
+    static inline int64_t decode_integer(const void* buf, uint64_t len)
+    {
+      // If the integer has 8 octets...
+      if (len == 8) {
+        uint64_t n;
+        memcpy(&n, buf, sizeof(uint64_t));
+
+        return static_cast<int64_t>(be64toh(n));
+      }
+
+      const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+      // Sign-extend the first octet.
+      uint64_t n = static_cast<uint64_t>(
+                     static_cast<int64_t>(static_cast<int8_t>(b[0]))
+                   );
+
+      for (uint64_t i = 1; i < len; i++) {
+        n = (n << 8) | b[i];
+      }
+
+      return static_cast<int64_t>(n);
+    }
+
+    // Decode integer when at least 'avail' octets (>= 'len') can be read from
+    // 'buf'.
+    static inline int64_t decode_integer(const void* buf,
+                                         uint64_t len,
+                                         uint64_t avail)
+    {
+      // If 8 octets can be read and the integer has between 1 and 8 octets...
+      if ((avail >= 8) && (len - 1 < 8)) {
+        // Load 8 octets and sign-extend with an arithmetic shift.
+        uint64_t n;
+        memcpy(&n, buf, sizeof(uint64_t));
+
+        return static_cast<int64_t>(be64toh(n)) >> (64 - (len << 3));
+      }
+
+      return decode_integer(buf, len);
+    }
+
+    // Decode non-negative integer of up to 9 octets (the first one being 0).
+    static inline bool decode_unsigned(const void* buf,
+                                       uint64_t len,
+                                       uint64_t& n)
+    {
+      const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+      if ((len > 0) && (len <= 9) && ((b[0] & 0x80) == 0)) {
+        if (len == 9) {
+          if (b[0] == 0) {
+            b++;
+            len--;
+          } else {
+            return false;
+          }
+        }
+
+        if (len == 8) {
+          uint64_t u64;
+          memcpy(&u64, b, sizeof(uint64_t));
+
+          n = be64toh(u64);
+        } else {
+          n = b[0];
+
+          for (uint64_t i = 1; i < len; i++) {
+            n = (n << 8) | b[i];
+          }
+        }
+
+        return true;
+      }
+
+      return false;
+    }
 
     bool decode_real(const void* buf, uint64_t len, double& n);
 
@@ -40,6 +288,43 @@ namespace asn1 {
                     uint64_t len,
                     uint64_t* oid,
                     size_t& ncomponents);
+
+    // Identifier and length octets of a value.
+    struct header {
+      // Tag class.
+      tag_class tc;
+
+      // Primitive/Constructed (P/C).
+      primitive_constructed pc;
+
+      // Tag number.
+      tag_number tn;
+
+      // Indefinite length?
+      bool indefinite;
+
+      // Length of the value (0 if the length is indefinite).
+      uint64_t valuelen;
+
+      // Length of the identifier and length octets.
+      size_t len;
+    };
+
+    // Decode the identifier and length octets of the value at 'buf'.
+    // Returns false if the header is not valid or it is not complete.
+    bool decode_header(const void* buf, size_t len, header& h);
+
+    // Get the total length (TLV) of the value at 'buf' from the headers (the
+    // values are not decoded, the values with indefinite length are walked
+    // until their end-of-contents).
+    // Returns 0 if the value is not valid or it is not complete.
+    uint64_t tlv_length(const void* buf, size_t len);
+
+    // Check the header of the encoded value (header + contents) of 'len'
+    // bytes at 'buf': it must be valid and the length of the value must be
+    // 'len' (for the indefinite length, the value must end with the
+    // end-of-contents octets). The contents are not checked.
+    bool check_header(const void* buf, size_t len);
   }
 }
 
@@ -1,3 +1,8 @@
 #include "asn1/ber/decoder.h"
 
 constexpr const struct asn1::ber::decoder::tag asn1::ber::decoder::_M_tags[];
+
+#ifdef ASN1_BER_STATISTICS
+thread_local asn1::ber::decoder_statistics
+asn1::ber::decoder::_M_statistics;
+#endif
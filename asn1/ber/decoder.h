@@ -4,12 +4,29 @@
 #include <stdlib.h>
 #include <string.h>
 #include <limits.h>
+#include <type_traits>
+#include <utility>
 #include "asn1/ber/tag.h"
 #include "asn1/ber/common.h"
 #include "asn1/ber/error.h"
+#include "asn1/ber/statistics.h"
+#include "asn1/ber/trace.h"
 
 namespace asn1 {
   namespace ber {
+    // Action returned by the optional method tlv() of the ASN.1 object.
+    enum class tlv_action {
+      // Decode the value as usual.
+      Continue,
+
+      // Skip the value (its children / contents are not given to the
+      // object).
+      Skip,
+
+      // Stop decoding (error::callback).
+      Error
+    };
+
     class decoder {
       public:
         static const uint64_t indefinite_length = ULLONG_MAX;
@@ -24,7 +41,16 @@ namespace asn1 {
         template<typename Reader, typename ASN1Object, size_t max_depth = 64>
         static bool decode(Reader& reader, ASN1Object& obj);
 
+#ifdef ASN1_BER_STATISTICS
+        // Get the statistics of the calling thread.
+        static decoder_statistics& statistics();
+#endif
+
       private:
+#ifdef ASN1_BER_STATISTICS
+        static thread_local decoder_statistics _M_statistics;
+#endif
+
         static const uint64_t value_max_len = ULLONG_MAX - 1;
 
         // Valid universal class?
@@ -34,6 +60,110 @@ namespace asn1 {
         // Valid length?
         static bool valid_length(tag_class tc, tag_number tn, uint64_t len);
 
+        // Report error.
+        template<typename ASN1Object>
+        static void report_error(ASN1Object& obj,
+                                 enum error e,
+                                 uint64_t offset,
+                                 const char* msg = nullptr);
+
+        // Has the reader the whole input in memory?
+        template<typename Reader>
+        struct in_memory {
+          template<typename R>
+          static auto test(int) -> decltype(
+            std::declval<R&>().current(),
+            std::declval<R&>().offset(),
+            std::declval<R&>().size(),
+            std::declval<R&>().seek(size_t()),
+            std::true_type()
+          );
+
+          template<typename R>
+          static std::false_type test(...);
+
+          static const bool value = decltype(test<Reader>(0))::value;
+        };
+
+        // Has the reader the whole input in memory and the object the
+        // method tlv()?
+        template<typename Reader, typename ASN1Object>
+        struct tlv_capture {
+          template<typename O>
+          static auto test(int) -> decltype(
+            std::declval<O&>().tlv(tag_class(),
+                                   primitive_constructed(),
+                                   tag_number(),
+                                   static_cast<const void*>(nullptr),
+                                   uint64_t(),
+                                   uint64_t()),
+            std::true_type()
+          );
+
+          template<typename O>
+          static std::false_type test(...);
+
+          static const bool value = (in_memory<Reader>::value) &&
+                                    (decltype(test<ASN1Object>(0))::value);
+        };
+
+        // Number of octets which can be read from the start of the contents
+        // octets of length 'len' which have just been read from the reader
+        // (the rest of the input follows them in memory).
+        template<typename Reader>
+        static typename std::enable_if<
+          in_memory<Reader>::value,
+          uint64_t
+        >::type available(const Reader& reader, uint64_t len)
+        {
+          return len + (reader.size() - reader.offset());
+        }
+
+        // Only the contents octets can be read.
+        template<typename Reader>
+        static typename std::enable_if<
+          !in_memory<Reader>::value,
+          uint64_t
+        >::type available(const Reader& reader, uint64_t len)
+        {
+          return len;
+        }
+
+        // Give the encoded value (header + contents) whose header has just
+        // been read to the method tlv() of the object. If the value is
+        // skipped, the reader is moved past it.
+        // 'valuelen' might be 'indefinite_length'; 'totallen' is set to the
+        // length of the TLV.
+        template<typename Reader, typename ASN1Object>
+        static typename std::enable_if<
+          tlv_capture<Reader, ASN1Object>::value,
+          tlv_action
+        >::type capture(Reader& reader,
+                        ASN1Object& obj,
+                        tag_class tc,
+                        primitive_constructed pc,
+                        tag_number tn,
+                        uint64_t headerlen,
+                        uint64_t valuelen,
+                        uint64_t& totallen);
+
+        // Without tlv(), the values are always decoded.
+        template<typename Reader, typename ASN1Object>
+        static typename std::enable_if<
+          !tlv_capture<Reader, ASN1Object>::value,
+          tlv_action
+        >::type capture(Reader& reader,
+                        ASN1Object& obj,
+                        tag_class tc,
+                        primitive_constructed pc,
+                        tag_number tn,
+                        uint64_t headerlen,
+                        uint64_t valuelen,
+                        uint64_t& totallen)
+        {
+          return tlv_action::Continue;
+        }
+
         // Primitive.
         template<typename ASN1Object>
         static bool primitive(tag_class tc,
@@ -154,6 +284,8 @@ namespace asn1 {
       const void* ptr = nullptr;
       int64_t read = 0;
 
+      ASN1_BER_TRACE0(record__start);
+
       do {
         int c;
 
@@ -184,7 +316,7 @@ namespace asn1 {
                     (valid_universal_class(v->pc, v->tn))) {
                   s = state::reading_length_octets;
                 } else {
-                  obj.error(error::invalid_universal_class, offset);
+                  report_error(obj, error::invalid_universal_class, offset);
                   return false;
                 }
               } else {
@@ -195,9 +327,10 @@ namespace asn1 {
 
                   s = state::reading_identifier_octets;
                 } else {
-                  obj.error(error::invalid_universal_class,
-                            offset,
-                            "invalid tag number");
+                  report_error(obj,
+                               error::invalid_universal_class,
+                               offset,
+                               "invalid tag number");
 
                   return false;
                 }
@@ -205,10 +338,11 @@ namespace asn1 {
 
               offset++;
             } else {
-              obj.error(error::unexpected_eof,
-                        offset,
-                        "unexpected end-of-file while parsing identifier "
-                        "octets");
+              report_error(obj,
+                           error::unexpected_eof,
+                           offset,
+                           "unexpected end-of-file while parsing identifier "
+                           "octets");
 
               return false;
             }
@@ -235,9 +369,10 @@ namespace asn1 {
 
                   s = state::reading_length_octets;
                 } else {
-                  obj.error(error::invalid_tag_number,
-                            offset,
-                            "tag number is too big");
+                  report_error(obj,
+                               error::invalid_tag_number,
+                               offset,
+                               "tag number is too big");
 
                   return false;
                 }
@@ -245,9 +380,10 @@ namespace asn1 {
 
               offset++;
             } else {
-              obj.error(error::unexpected_eof,
-                        offset,
-                        "unexpected end-of-file while parsing tag number");
+              report_error(obj,
+                           error::unexpected_eof,
+                           offset,
+                           "unexpected end-of-file while parsing tag number");
 
               return false;
             }
@@ -281,8 +417,37 @@ namespace asn1 {
                   case 0:
                     // Indefinite form.
                     if (v->pc == primitive_constructed::Constructed) {
+                      switch (capture(reader,
+                                      obj,
+                                      v->tc,
+                                      v->pc,
+                                      v->tn,
+                                      offset + 1 - v->offset,
+                                      indefinite_length,
+                                      v->totallen)) {
+                        case tlv_action::Continue:
+                          break;
+                        case tlv_action::Skip:
+                          offset = v->offset + v->totallen;
+
+                          s = state::end_of_value;
+
+                          continue;
+                        case tlv_action::Error:
+                          report_error(obj, error::callback, offset);
+                          return false;
+                      }
+
                       // If the maximum depth has not been exceeded...
                       if (++depth <= max_depth) {
+                        ASN1_BER_STATS(_M_statistics.depth(depth));
+
+                        ASN1_BER_TRACE4(constructed__start,
+                                        v->offset,
+                                        static_cast<uint8_t>(v->tc),
+                                        v->tn,
+                                        indefinite_length);
+
                         // Start constructed.
                         if (obj.start_constructed(v->tc,
                                                   v->tn,
@@ -294,30 +459,32 @@ namespace asn1 {
 
                           s = state::initial;
                         } else {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::max_depth_exceeded, offset);
+                        report_error(obj, error::max_depth_exceeded, offset);
                         return false;
                       }
                     } else {
-                      obj.error(error::invalid_length,
-                                offset,
-                                "indefinite form not allowed for primitive "
-                                "types");
+                      report_error(obj,
+                                   error::invalid_length,
+                                   offset,
+                                   "indefinite form not allowed for primitive "
+                                   "types");
 
                       return false;
                     }
 
                     break;
                   case 0xff:
-                    obj.error(error::invalid_length, offset);
+                    report_error(obj, error::invalid_length, offset);
                     return false;
                   default:
-                    obj.error(error::invalid_length,
-                              offset,
-                              "length is too big");
+                    report_error(obj,
+                                 error::invalid_length,
+                                 offset,
+                                 "length is too big");
 
                     return false;
                 }
@@ -325,9 +492,10 @@ namespace asn1 {
 
               offset++;
             } else {
-              obj.error(error::unexpected_eof,
-                        offset,
-                        "unexpected end-of-file while parsing tag length");
+              report_error(obj,
+                           error::unexpected_eof,
+                           offset,
+                           "unexpected end-of-file while parsing tag length");
 
               return false;
             }
@@ -346,9 +514,10 @@ namespace asn1 {
 
               offset++;
             } else {
-              obj.error(error::unexpected_eof,
-                        offset,
-                        "unexpected end-of-file while parsing tag length");
+              report_error(obj,
+                           error::unexpected_eof,
+                           offset,
+                           "unexpected end-of-file while parsing tag length");
 
               return false;
             }
@@ -360,8 +529,31 @@ namespace asn1 {
               // Compute total length.
               v->totallen = (offset - v->offset) + v->valuelen;
 
+              ASN1_BER_STATS(_M_statistics.count(v->tc, v->tn, v->totallen));
+
               v->valueoff = 0;
 
+              switch (capture(reader,
+                              obj,
+                              v->tc,
+                              v->pc,
+                              v->tn,
+                              offset - v->offset,
+                              v->valuelen,
+                              v->totallen)) {
+                case tlv_action::Continue:
+                  break;
+                case tlv_action::Skip:
+                  offset += v->valuelen;
+
+                  s = state::end_of_value;
+
+                  continue;
+                case tlv_action::Error:
+                  report_error(obj, error::callback, offset);
+                  return false;
+              }
+
               // If there is value...
               if (v->valuelen > 0) {
                 // Primitive?
@@ -374,6 +566,14 @@ namespace asn1 {
                 } else {
                   // If the maximum depth has not been exceeded...
                   if (++depth <= max_depth) {
+                    ASN1_BER_STATS(_M_statistics.depth(depth));
+
+                    ASN1_BER_TRACE4(constructed__start,
+                                    v->offset,
+                                    static_cast<uint8_t>(v->tc),
+                                    v->tn,
+                                    v->valuelen);
+
                     if (obj.start_constructed(v->tc,
                                               v->tn,
                                               v->valuelen,
@@ -382,11 +582,11 @@ namespace asn1 {
 
                       s = state::initial;
                     } else {
-                      obj.error(error::callback, offset);
+                      report_error(obj, error::callback, offset);
                       return false;
                     }
                   } else {
-                    obj.error(error::max_depth_exceeded, offset);
+                    report_error(obj, error::max_depth_exceeded, offset);
                     return false;
                   }
                 }
@@ -400,6 +600,18 @@ namespace asn1 {
 
                   s = state::processing_value;
                 } else {
+                  ASN1_BER_TRACE4(constructed__start,
+                                  v->offset,
+                                  static_cast<uint8_t>(v->tc),
+                                  v->tn,
+                                  0);
+
+                  ASN1_BER_TRACE4(constructed__end,
+                                  v->offset,
+                                  static_cast<uint8_t>(v->tc),
+                                  v->tn,
+                                  v->totallen);
+
                   if ((obj.start_constructed(v->tc,
                                              v->tn,
                                              v->valuelen,
@@ -407,13 +619,13 @@ namespace asn1 {
                       (obj.end_constructed(v->tc, v->tn, v->totallen))) {
                     s = state::end_of_value;
                   } else {
-                    obj.error(error::callback, offset);
+                    report_error(obj, error::callback, offset);
                     return false;
                   }
                 }
               }
             } else {
-              obj.error(error::invalid_length, offset);
+              report_error(obj, error::invalid_length, offset);
               return false;
             }
 
@@ -435,6 +647,8 @@ namespace asn1 {
                   memcpy(buf + len, ptr, read);
 
                   len += read;
+
+                  ASN1_BER_STATS(_M_statistics.coalesced++);
                 } else {
                   // If the buffer is empty...
                   if (len == 0) {
@@ -455,6 +669,8 @@ namespace asn1 {
                     // Fill buffer with the read data.
                     memcpy(buf + len, ptr, left);
 
+                    ASN1_BER_STATS(_M_statistics.coalesced++);
+
                     // Give data to the user.
                     if (primitive(v->tc,
                                   v->tn,
@@ -477,6 +693,8 @@ namespace asn1 {
                           memcpy(buf, ptr, read);
 
                           len = read;
+
+                          ASN1_BER_STATS(_M_statistics.coalesced++);
                         } else {
                           // Give remaining data to the user.
                           if (primitive(v->tc,
@@ -504,10 +722,11 @@ namespace asn1 {
                 }
               }
             } else {
-              obj.error(error::unexpected_eof,
-                        offset,
-                        "unexpected end-of-file while reading contents "
-                        "octets");
+              report_error(obj,
+                           error::unexpected_eof,
+                           offset,
+                           "unexpected end-of-file while reading contents "
+                           "octets");
 
               return false;
             }
@@ -525,6 +744,8 @@ namespace asn1 {
 
                 ptr = buf;
                 read += len;
+
+                ASN1_BER_STATS(_M_statistics.coalesced++);
               }
 
               // Universal class?
@@ -538,21 +759,33 @@ namespace asn1 {
                         // Compute length of the TLV.
                         v->totallen = offset - v->offset;
 
+                        ASN1_BER_STATS(_M_statistics.count(v->tc,
+                                                           v->tn,
+                                                           v->totallen));
+
+                        ASN1_BER_TRACE4(constructed__end,
+                                        v->offset,
+                                        static_cast<uint8_t>(v->tc),
+                                        v->tn,
+                                        v->totallen);
+
                         if (obj.end_constructed(v->tc, v->tn, v->totallen)) {
                           depth--;
                         } else {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::unexpected_end_of_contents,
-                                  offset - 2);
+                        report_error(obj,
+                                     error::unexpected_end_of_contents,
+                                     offset - 2);
 
                         return false;
                       }
                     } else {
-                      obj.error(error::unexpected_end_of_contents,
-                                offset - 2);
+                      report_error(obj,
+                                   error::unexpected_end_of_contents,
+                                   offset - 2);
 
                       return false;
                     }
@@ -563,44 +796,66 @@ namespace asn1 {
                     if (!obj.boolean(ptr,
                                      v->valuelen,
                                      *static_cast<const uint8_t*>(ptr) != 0)) {
-                      obj.error(error::callback, offset);
+                      report_error(obj, error::callback, offset);
                       return false;
                     }
 
                     break;
                   case universal_class::Integer:
-                    // Give data to the user.
-                    if (!obj.integer(ptr,
-                                     v->valuelen,
-                                     decode_integer(ptr, v->valuelen))) {
-                      obj.error(error::callback, offset);
-                      return false;
+                    {
+                      // Octets which can be read from the contents octets.
+                      const uint64_t avail = (ptr == buf) ?
+                                               sizeof(buf) :
+                                               available(reader, v->valuelen);
+
+                      // Give data to the user.
+                      if (!obj.integer(ptr,
+                                       v->valuelen,
+                                       decode_integer(ptr,
+                                                      v->valuelen,
+                                                      avail))) {
+                        report_error(obj, error::callback, offset);
+                        return false;
+                      }
                     }
 
                     break;
                   case universal_class::Null:
                     // Give data to the user.
                     if (!obj.null()) {
-                      obj.error(error::callback, offset);
+                      report_error(obj, error::callback, offset);
                       return false;
                     }
 
                     break;
                   case universal_class::ObjectIdentifier:
                     {
+                      ASN1_BER_STATS_CLOCK(start);
+
                       // Decode object identifier.
                       uint64_t oid[max_oid_components];
                       size_t ncomponents;
-                      if (decode_oid(ptr, v->valuelen, oid, ncomponents)) {
+                      bool valid = decode_oid(ptr,
+                                              v->valuelen,
+                                              oid,
+                                              ncomponents);
+
+                      ASN1_BER_STATS(_M_statistics.typed(
+                        decoder_statistics::typed_decoder::Oid,
+                        start
+                      ));
+
+                      if (valid) {
                         // Give data to the user.
                         if (!obj.oid(ptr, v->valuelen, oid, ncomponents)) {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::invalid_value,
-                                  offset - v->valuelen,
-                                  "invalid oid");
+                        report_error(obj,
+                                     error::invalid_value,
+                                     offset - v->valuelen,
+                                     "invalid oid");
 
                         return false;
                       }
@@ -609,18 +864,28 @@ namespace asn1 {
                     break;
                   case universal_class::Real:
                     {
+                      ASN1_BER_STATS_CLOCK(start);
+
                       // Decode real.
                       double d;
-                      if (decode_real(ptr, v->valuelen, d)) {
+                      bool valid = decode_real(ptr, v->valuelen, d);
+
+                      ASN1_BER_STATS(_M_statistics.typed(
+                        decoder_statistics::typed_decoder::Real,
+                        start
+                      ));
+
+                      if (valid) {
                         // Give data to the user.
                         if (!obj.real(ptr, v->valuelen, d)) {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::invalid_value,
-                                  offset - v->valuelen,
-                                  "invalid real");
+                        report_error(obj,
+                                     error::invalid_value,
+                                     offset - v->valuelen,
+                                     "invalid real");
 
                         return false;
                       }
@@ -628,29 +893,48 @@ namespace asn1 {
 
                     break;
                   case universal_class::Enumerated:
-                    // Give data to the user.
-                    if (!obj.enumerated(ptr,
-                                        v->valuelen,
-                                        decode_integer(ptr, v->valuelen))) {
-                      obj.error(error::callback, offset);
-                      return false;
+                    {
+                      // Octets which can be read from the contents octets.
+                      const uint64_t avail = (ptr == buf) ?
+                                               sizeof(buf) :
+                                               available(reader, v->valuelen);
+
+                      // Give data to the user.
+                      if (!obj.enumerated(ptr,
+                                          v->valuelen,
+                                          decode_integer(ptr,
+                                                         v->valuelen,
+                                                         avail))) {
+                        report_error(obj, error::callback, offset);
+                        return false;
+                      }
                     }
 
                     break;
                   case universal_class::UTCTime:
                     {
+                      ASN1_BER_STATS_CLOCK(start);
+
                       // Decode UTC time.
                       time_t t;
-                      if (decode_utc_time(ptr, v->valuelen, t)) {
+                      bool valid = decode_utc_time(ptr, v->valuelen, t);
+
+                      ASN1_BER_STATS(_M_statistics.typed(
+                        decoder_statistics::typed_decoder::UTCTime,
+                        start
+                      ));
+
+                      if (valid) {
                         // Give data to the user.
                         if (!obj.utc_time(ptr, v->valuelen, t)) {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::invalid_value,
-                                  offset - v->valuelen,
-                                  "invalid UTC time");
+                        report_error(obj,
+                                     error::invalid_value,
+                                     offset - v->valuelen,
+                                     "invalid UTC time");
 
                         return false;
                       }
@@ -659,18 +943,30 @@ namespace asn1 {
                     break;
                   case universal_class::GeneralizedTime:
                     {
+                      ASN1_BER_STATS_CLOCK(start);
+
                       // Decode generalized time.
                       struct timeval tv;
-                      if (decode_generalized_time(ptr, v->valuelen, tv)) {
+                      bool valid = decode_generalized_time(ptr,
+                                                           v->valuelen,
+                                                           tv);
+
+                      ASN1_BER_STATS(_M_statistics.typed(
+                        decoder_statistics::typed_decoder::GeneralizedTime,
+                        start
+                      ));
+
+                      if (valid) {
                         // Give data to the user.
                         if (!obj.generalized_time(ptr, v->valuelen, tv)) {
-                          obj.error(error::callback, offset);
+                          report_error(obj, error::callback, offset);
                           return false;
                         }
                       } else {
-                        obj.error(error::invalid_value,
-                                  offset - v->valuelen,
-                                  "invalid generalized time");
+                        report_error(obj,
+                                     error::invalid_value,
+                                     offset - v->valuelen,
+                                     "invalid generalized time");
 
                         return false;
                       }
@@ -724,6 +1020,8 @@ namespace asn1 {
                 // Append read data to the buffer.
                 memcpy(buf + len, ptr, left);
 
+                ASN1_BER_STATS(_M_statistics.coalesced++);
+
                 // Give data to the user.
                 if (primitive(v->tc,
                               v->tn,
@@ -774,14 +1072,20 @@ namespace asn1 {
 
                     break;
                   } else if (len == v->valuelen) {
+                    ASN1_BER_TRACE4(constructed__end,
+                                    v->offset,
+                                    static_cast<uint8_t>(v->tc),
+                                    v->tn,
+                                    v->totallen);
+
                     if (obj.end_constructed(v->tc, v->tn, v->totallen)) {
                       depth--;
                     } else {
-                      obj.error(error::callback, offset);
+                      report_error(obj, error::callback, offset);
                       return false;
                     }
                   } else {
-                    obj.error(error::invalid_length, offset);
+                    report_error(obj, error::invalid_length, offset);
                     return false;
                   }
                 } else {
@@ -792,6 +1096,7 @@ namespace asn1 {
                   break;
                 }
               } else {
+                ASN1_BER_TRACE2(record__end, offset, 1);
                 return true;
               }
             } while (true);
@@ -801,6 +1106,13 @@ namespace asn1 {
       } while (true);
     }
 
+#ifdef ASN1_BER_STATISTICS
+    inline decoder_statistics& decoder::statistics()
+    {
+      return _M_statistics;
+    }
+#endif
+
     inline bool decoder::valid_universal_class(primitive_constructed pc,
                                                tag_number tn)
     {
@@ -817,6 +1129,61 @@ namespace asn1 {
       }
     }
 
+    template<typename Reader, typename ASN1Object>
+    inline typename std::enable_if<
+      decoder::tlv_capture<Reader, ASN1Object>::value,
+      tlv_action
+    >::type decoder::capture(Reader& reader,
+                             ASN1Object& obj,
+                             tag_class tc,
+                             primitive_constructed pc,
+                             tag_number tn,
+                             uint64_t headerlen,
+                             uint64_t valuelen,
+                             uint64_t& totallen)
+    {
+      // End-of-contents?
+      if ((tc == tag_class::Universal) &&
+          (static_cast<universal_class>(tn) ==
+           universal_class::EndOfContents)) {
+        return tlv_action::Continue;
+      }
+
+      const uint8_t* tlv = reader.current() - headerlen;
+      uint64_t left = reader.size() - reader.offset();
+
+      if (valuelen != indefinite_length) {
+        // If the value is incomplete, the decoder will report the error.
+        if (valuelen > left) {
+          return tlv_action::Continue;
+        }
+
+        totallen = headerlen + valuelen;
+      } else if ((totallen = tlv_length(tlv, headerlen + left)) == 0) {
+        return tlv_action::Continue;
+      }
+
+      tlv_action action = obj.tlv(tc, pc, tn, tlv, totallen, headerlen);
+
+      if (action == tlv_action::Skip) {
+        reader.seek(reader.offset() + (totallen - headerlen));
+      }
+
+      return action;
+    }
+
+    template<typename ASN1Object>
+    inline void decoder::report_error(ASN1Object& obj,
+                                      enum error e,
+                                      uint64_t offset,
+                                      const char* msg)
+    {
+      ASN1_BER_TRACE2(error, offset, static_cast<int>(e));
+      ASN1_BER_TRACE2(record__end, offset, 0);
+
+      obj.error(e, offset, msg);
+    }
+
     template<typename ASN1Object>
     inline bool decoder::primitive(tag_class tc,
                                    tag_number tn,
@@ -827,14 +1194,17 @@ namespace asn1 {
                                    uint64_t offset,
                                    ASN1Object& obj)
     {
+      ASN1_BER_STATS(_M_statistics.primitive_deliveries++);
+
       if (valueoff == 0) {
         if (tc == tag_class::Universal) {
           if (static_cast<universal_class>(tn) == universal_class::Bitstring) {
             if ((*static_cast<const uint8_t*>(buf) > 7) ||
                 ((valuelen == 1) && (*static_cast<const uint8_t*>(buf) != 0))) {
-              obj.error(error::invalid_value,
-                        offset - valuelen,
-                        "invalid bitstring");
+              report_error(obj,
+                           error::invalid_value,
+                           offset - valuelen,
+                           "invalid bitstring");
 
               return false;
             }
@@ -845,7 +1215,7 @@ namespace asn1 {
       if (obj.primitive(tc, tn, buf, len, valueoff, valuelen)) {
         return true;
       } else {
-        obj.error(error::callback, offset);
+        report_error(obj, error::callback, offset);
         return false;
       }
     }
@@ -8,6 +8,8 @@
 #include <limits.h>
 #include "asn1/ber/tag.h"
 #include "asn1/ber/common.h"
+#include "asn1/ber/statistics.h"
+#include "asn1/ber/trace.h"
 
 namespace asn1 {
   namespace ber {
@@ -26,18 +28,60 @@ namespace asn1 {
           Deep
         };
 
+        enum class length_form {
+          Definite,
+          Indefinite
+        };
+
         // Constructor.
         encoder() = default;
 
+        // Move constructor.
+        encoder(encoder&& other) noexcept;
+
         // Destructor.
         ~encoder();
 
+        // Move assignment operator.
+        encoder& operator=(encoder&& other) noexcept;
+
         // Clear.
+        // The storage of the values is kept unless it exceeds the high-water
+        // mark.
         void clear();
 
+        // Reserve storage for 'nvalues' values (static + dynamic).
+        bool reserve(size_t nvalues);
+
+        // Release the dynamic storage which is not in use.
+        void shrink_to_fit();
+
+        // Set the maximum number of values whose storage is kept by clear()
+        // (by default, the storage is always kept).
+        void high_water_mark(size_t nvalues);
+
+        // Get the number of values which can be stored without reallocating.
+        size_t capacity() const;
+
+        // Get the maximum number of values used since the construction or the
+        // last call to reset_peak().
+        size_t peak() const;
+
+        // Reset peak.
+        void reset_peak();
+
+#ifdef ASN1_BER_STATISTICS
+        // Get statistics.
+        encoder_statistics& statistics();
+#endif
+
         // Get current length.
         size_t length() const;
 
+        // Get the exact number of bytes encode() will write (0 if there are
+        // constructed values which have not been ended yet).
+        size_t size() const;
+
         // Add boolean.
         bool add_boolean(tag_class tc, tagging tg, tag_number tn, bool val);
 
@@ -72,6 +116,13 @@ namespace asn1 {
                             tag_number tn,
                             int64_t val);
 
+        // Add object identifier.
+        bool add_oid(tag_class tc,
+                     tagging tg,
+                     tag_number tn,
+                     const uint64_t* oid,
+                     size_t ncomponents);
+
         // Add UTF-8 string.
         bool add_utf8_string(tag_class tc,
                              tagging tg,
@@ -81,13 +132,19 @@ namespace asn1 {
                              copy cp = copy::Deep);
 
         // Start sequence.
-        bool start_sequence(tag_class tc, tagging tg, tag_number tn);
+        bool start_sequence(tag_class tc,
+                            tagging tg,
+                            tag_number tn,
+                            length_form lf = length_form::Definite);
 
         // End sequence.
         bool end_sequence();
 
         // Start set.
-        bool start_set(tag_class tc, tagging tg, tag_number tn);
+        bool start_set(tag_class tc,
+                       tagging tg,
+                       tag_number tn,
+                       length_form lf = length_form::Definite);
 
         // End set.
         bool end_set();
@@ -192,10 +249,22 @@ namespace asn1 {
                             size_t len,
                             copy cp = copy::Deep);
 
+        // Add an already encoded value (header + contents, 'len' bytes) to
+        // the current constructed value.
+        // Only the header is checked: it must be valid and the length of the
+        // value must be 'len' (for the indefinite length, the value must end
+        // with the end-of-contents octets).
+        bool add_encoded(const void* tlv, size_t len, copy cp = copy::Deep);
+
         // Encode.
         template<typename Writer>
         bool encode(Writer& writer) const;
 
+        // Encode into a preallocated buffer of 'len' bytes.
+        // Returns the number of bytes written or 0 if the buffer is too small
+        // or there are constructed values which have not been ended yet.
+        size_t encode_to(void* buf, size_t len) const;
+
       private:
         struct value {
           // Universal class.
@@ -209,7 +278,12 @@ namespace asn1 {
             BitstringDeepCopy,
             Null,
             Constructed,
-            ExplicitTag
+            IndefiniteConstructed,
+            ExplicitTag,
+
+            // Already encoded value (the header is in the contents).
+            EncodedShallowCopy,
+            EncodedDeepCopy
           };
 
           // Value type.
@@ -247,9 +321,17 @@ namespace asn1 {
           // Get length of the value.
           size_t length() const;
 
+          // Get number of bytes written by encode() (the header for the
+          // constructed values, whose contents are the following values).
+          size_t encoded_length() const;
+
           // Encode.
           template<typename Writer>
           bool encode(Writer& writer) const;
+
+          // Encode into 'buf' (which must have space for length() bytes).
+          // Returns a pointer to the end of the encoded value.
+          uint8_t* encode_to(uint8_t* buf) const;
         };
 
         value _M_static_values[number_static_values];
@@ -261,6 +343,16 @@ namespace asn1 {
 
         ssize_t _M_parent = -1;
 
+        // Maximum number of values whose storage is kept by clear().
+        size_t _M_high_water_mark = max_values;
+
+        // Maximum number of values used before the last clear().
+        size_t _M_peak = 0;
+
+#ifdef ASN1_BER_STATISTICS
+        encoder_statistics _M_statistics = encoder_statistics();
+#endif
+
         // Add integer.
         bool add_integer(tag_class tc,
                          universal_class uc,
@@ -281,7 +373,8 @@ namespace asn1 {
         bool start_constructed(tag_class tc,
                                universal_class uc,
                                tagging tg,
-                               tag_number tn);
+                               tag_number tn,
+                               length_form lf);
 
         // End constructed.
         bool end_constructed(universal_class uc);
@@ -296,6 +389,15 @@ namespace asn1 {
         // New value.
         struct value* new_value();
 
+        // Resize the storage to 'nvalues' values (static + dynamic).
+        bool resize(size_t nvalues);
+
+        // Free the deep-copied values.
+        void free_values();
+
+        // Take the values of 'other' (leaving 'other' empty).
+        void take(encoder& other);
+
         // End value.
         void end_value(struct value* value);
 
@@ -308,10 +410,17 @@ namespace asn1 {
         encoder& operator=(const encoder&) = delete;
     };
 
+    template<size_t number_static_values, size_t max_values>
+    inline
+    encoder<number_static_values, max_values>::encoder(encoder&& other) noexcept
+    {
+      take(other);
+    }
+
     template<size_t number_static_values, size_t max_values>
     inline encoder<number_static_values, max_values>::~encoder()
     {
-      clear();
+      free_values();
 
       if (_M_dynamic_values) {
         free(_M_dynamic_values);
@@ -319,30 +428,110 @@ namespace asn1 {
     }
 
     template<size_t number_static_values, size_t max_values>
-    inline void encoder<number_static_values, max_values>::clear()
+    inline encoder<number_static_values, max_values>&
+    encoder<number_static_values, max_values>::operator=(
+      encoder&& other
+    ) noexcept
     {
-      for (size_t i = 0; i < _M_used; i++) {
-        struct value* value = get(i);
-        switch (value->t) {
-          case value::type::DeepCopy:
-          case value::type::BitstringDeepCopy:
-            free(value->ptr);
-            break;
-          default:
-            ;
+      if (this != &other) {
+        free_values();
+
+        if (_M_dynamic_values) {
+          free(_M_dynamic_values);
         }
+
+        take(other);
+      }
+
+      return *this;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline void encoder<number_static_values, max_values>::clear()
+    {
+      free_values();
+
+      if (_M_used > _M_peak) {
+        _M_peak = _M_used;
       }
 
       _M_used = 0;
       _M_parent = -1;
+
+      // If the storage exceeds the high-water mark...
+      if (_M_size > _M_high_water_mark) {
+        resize(_M_high_water_mark);
+      }
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline bool encoder<number_static_values, max_values>::reserve(
+      size_t nvalues
+    )
+    {
+      if (nvalues <= _M_size) {
+        return true;
+      }
+
+      return (nvalues <= max_values) ? resize(nvalues) : false;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline void encoder<number_static_values, max_values>::shrink_to_fit()
+    {
+      if (_M_used < _M_size) {
+        resize(_M_used);
+      }
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline void encoder<number_static_values, max_values>::high_water_mark(
+      size_t nvalues
+    )
+    {
+      _M_high_water_mark = nvalues;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    inline size_t encoder<number_static_values, max_values>::capacity() const
+    {
+      return _M_size;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline size_t encoder<number_static_values, max_values>::peak() const
+    {
+      return (_M_used > _M_peak) ? _M_used : _M_peak;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline void encoder<number_static_values, max_values>::reset_peak()
+    {
+      _M_peak = 0;
+    }
+
+#ifdef ASN1_BER_STATISTICS
+    template<size_t number_static_values, size_t max_values>
+    inline encoder_statistics&
+    encoder<number_static_values, max_values>::statistics()
+    {
+      return _M_statistics;
+    }
+#endif
+
     template<size_t number_static_values, size_t max_values>
     inline size_t encoder<number_static_values, max_values>::length() const
     {
       return (_M_used > 0) ? get(0)->length() : 0;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    inline size_t encoder<number_static_values, max_values>::size() const
+    {
+      // The first value is the root, its length includes all the other values.
+      return ((_M_used > 0) && (_M_parent == -1)) ? get(0)->length() : 0;
+    }
+
     template<size_t number_static_values, size_t max_values>
     bool encoder<number_static_values, max_values>::add_boolean(tag_class tc,
                                                                 tagging tg,
@@ -404,6 +593,8 @@ namespace asn1 {
       } else {
         if ((ptr = malloc(len)) != nullptr) {
           memcpy(ptr, val, len);
+
+          ASN1_BER_STATS(_M_statistics.deep_copy_bytes += len);
           type = value::type::BitstringDeepCopy;
         } else {
           return false;
@@ -526,13 +717,72 @@ namespace asn1 {
                              cp);
     }
 
+    template<size_t number_static_values, size_t max_values>
+    bool encoder<number_static_values, max_values>::add_oid(tag_class tc,
+                                                            tagging tg,
+                                                            tag_number tn,
+                                                            const uint64_t* oid,
+                                                            size_t ncomponents)
+    {
+      size_t len;
+      if ((len = oid_length(oid, ncomponents)) == 0) {
+        return false;
+      }
+
+      typename value::type type;
+      void* ptr;
+
+      // If the encoded object identifier doesn't fit in the value...
+      if (len > sizeof(value::v)) {
+        if ((ptr = malloc(len)) != nullptr) {
+          encode_oid(oid, ncomponents, static_cast<uint8_t*>(ptr));
+
+          ASN1_BER_STATS(_M_statistics.deep_copy_bytes += len);
+          type = value::type::DeepCopy;
+        } else {
+          return false;
+        }
+      } else {
+        ptr = nullptr;
+        type = value::type::Value;
+      }
+
+      struct value* value;
+      if ((value = create_value(tc,
+                                primitive_constructed::Primitive,
+                                universal_class::ObjectIdentifier,
+                                tg,
+                                tn)) != nullptr) {
+        value->t = type;
+
+        if (type == value::type::Value) {
+          encode_oid(oid, ncomponents, value->v);
+        } else {
+          value->ptr = ptr;
+        }
+
+        value->vlen = len;
+
+        end_value(value);
+
+        return true;
+      } else {
+        if (ptr) {
+          free(ptr);
+        }
+      }
+
+      return false;
+    }
+
     template<size_t number_static_values, size_t max_values>
     inline bool
     encoder<number_static_values, max_values>::start_sequence(tag_class tc,
                                                               tagging tg,
-                                                              tag_number tn)
+                                                              tag_number tn,
+                                                              length_form lf)
     {
-      return start_constructed(tc, universal_class::Sequence, tg, tn);
+      return start_constructed(tc, universal_class::Sequence, tg, tn, lf);
     }
 
     template<size_t number_static_values, size_t max_values>
@@ -545,9 +795,10 @@ namespace asn1 {
     inline bool
     encoder<number_static_values, max_values>::start_set(tag_class tc,
                                                          tagging tg,
-                                                         tag_number tn)
+                                                         tag_number tn,
+                                                         length_form lf)
     {
-      return start_constructed(tc, universal_class::Set, tg, tn);
+      return start_constructed(tc, universal_class::Set, tg, tn, lf);
     }
 
     template<size_t number_static_values, size_t max_values>
@@ -827,24 +1078,147 @@ namespace asn1 {
                              cp);
     }
 
+    template<size_t number_static_values, size_t max_values>
+    bool encoder<number_static_values, max_values>::add_encoded(const void* tlv,
+                                                                size_t len,
+                                                                copy cp)
+    {
+      // The value must either have a parent or be the first value.
+      if ((_M_parent == -1) && (_M_used > 0)) {
+        return false;
+      }
+
+      if (!check_header(tlv, len)) {
+        return false;
+      }
+
+      typename value::type type;
+      void* ptr;
+
+      if (cp == copy::Shallow) {
+        type = value::type::EncodedShallowCopy;
+        ptr = const_cast<void*>(tlv);
+      } else {
+        if ((ptr = malloc(len)) != nullptr) {
+          memcpy(ptr, tlv, len);
+
+          ASN1_BER_STATS(_M_statistics.deep_copy_bytes += len);
+          type = value::type::EncodedDeepCopy;
+        } else {
+          return false;
+        }
+      }
+
+      struct value* value;
+      if ((value = new_value()) != nullptr) {
+        // The universal class is only used by the constructed values.
+        value->uc = universal_class::EndOfContents;
+
+        value->t = type;
+
+        value->taglen = 0;
+        value->lenlen = 0;
+
+        value->ptr = ptr;
+        value->vlen = len;
+
+        value->parent = _M_parent;
+
+        end_value(value);
+
+        return true;
+      } else {
+        if (cp == copy::Deep) {
+          free(ptr);
+        }
+      }
+
+      return false;
+    }
+
     template<size_t number_static_values, size_t max_values>
     template<typename Writer>
     inline
     bool encoder<number_static_values, max_values>::encode(Writer& writer) const
     {
       if (_M_parent == -1) {
+        ASN1_BER_TRACE2(encode__start, _M_used, size());
+
+        size_t offset = 0;
+
         for (size_t i = 0; i < _M_used; i++) {
-          if (!get(i)->encode(writer)) {
+          const struct value* value = get(i);
+
+          ASN1_BER_TRACE4(encode__value,
+                          offset,
+                          value->tag,
+                          value->taglen,
+                          value->vlen);
+
+          if (!value->encode(writer)) {
+            ASN1_BER_TRACE2(encode__end, offset, 0);
             return false;
           }
+
+          offset += value->encoded_length();
         }
 
+        ASN1_BER_TRACE2(encode__end, offset, 1);
+
         return true;
       }
 
       return false;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    size_t encoder<number_static_values, max_values>::encode_to(
+      void* buf,
+      size_t len
+    ) const
+    {
+      size_t total;
+      if (((total = size()) > 0) && (total <= len)) {
+        uint8_t* b = static_cast<uint8_t*>(buf);
+
+        ASN1_BER_TRACE2(encode__start, _M_used, total);
+
+        // Static values.
+        size_t count = (_M_used < number_static_values) ?
+                         _M_used :
+                         number_static_values;
+
+        for (size_t i = 0; i < count; i++) {
+          ASN1_BER_TRACE4(encode__value,
+                          b - static_cast<uint8_t*>(buf),
+                          _M_static_values[i].tag,
+                          _M_static_values[i].taglen,
+                          _M_static_values[i].vlen);
+
+          b = _M_static_values[i].encode_to(b);
+        }
+
+        // Dynamic values.
+        count = _M_used - count;
+
+        for (size_t i = 0; i < count; i++) {
+          ASN1_BER_TRACE4(encode__value,
+                          b - static_cast<uint8_t*>(buf),
+                          _M_dynamic_values[i].tag,
+                          _M_dynamic_values[i].taglen,
+                          _M_dynamic_values[i].vlen);
+
+          b = _M_dynamic_values[i].encode_to(b);
+        }
+
+        ASN1_BER_TRACE2(encode__end, total, 1);
+
+        return total;
+      }
+
+      return 0;
+    }
+
     template<size_t number_static_values, size_t max_values>
     inline
     size_t encoder<number_static_values, max_values>::value::length() const
@@ -852,6 +1226,20 @@ namespace asn1 {
       return taglen + lenlen + vlen;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    inline size_t
+    encoder<number_static_values, max_values>::value::encoded_length() const
+    {
+      switch (t) {
+        case value::type::Constructed:
+        case value::type::IndefiniteConstructed:
+        case value::type::ExplicitTag:
+          return taglen + lenlen;
+        default:
+          return taglen + lenlen + vlen;
+      }
+    }
+
     template<size_t number_static_values, size_t max_values>
     template<typename Writer>
     bool encoder<number_static_values,
@@ -871,6 +1259,8 @@ namespace asn1 {
               break;
             case value::type::ShallowCopy:
             case value::type::DeepCopy:
+            case value::type::EncodedShallowCopy:
+            case value::type::EncodedDeepCopy:
               // Write value.
               if (!writer.write(ptr, vlen)) {
                 return false;
@@ -911,6 +1301,7 @@ namespace asn1 {
               break;
             case value::type::Null:
             case value::type::Constructed:
+            case value::type::IndefiniteConstructed:
             case value::type::ExplicitTag:
               break;
           }
@@ -924,6 +1315,52 @@ namespace asn1 {
       return true;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    inline uint8_t*
+    encoder<number_static_values, max_values>::value::encode_to(
+      uint8_t* buf
+    ) const
+    {
+      // Write tag.
+      memcpy(buf, tag, taglen);
+      buf += taglen;
+
+      // Write length.
+      memcpy(buf, len, lenlen);
+      buf += lenlen;
+
+      // Write value.
+      switch (t) {
+        case value::type::Value:
+          memcpy(buf, v, vlen);
+          return buf + vlen;
+        case value::type::ShallowCopy:
+        case value::type::DeepCopy:
+        case value::type::EncodedShallowCopy:
+        case value::type::EncodedDeepCopy:
+          memcpy(buf, ptr, vlen);
+          return buf + vlen;
+        case value::type::BitstringShallowCopy:
+        case value::type::BitstringDeepCopy:
+          if ((bitlen & 0x07) == 0) {
+            *buf = 0;
+            memcpy(buf + 1, ptr, vlen - 1);
+          } else {
+            uint8_t unused = 8 - (bitlen & 0x07);
+
+            *buf = unused;
+            memcpy(buf + 1, ptr, vlen - 2);
+
+            buf[vlen - 1] = static_cast<const uint8_t*>(ptr)[vlen - 2] &
+                            (static_cast<uint8_t>(0xff) << unused);
+          }
+
+          return buf + vlen;
+        default:
+          return buf;
+      }
+    }
+
     template<size_t number_static_values, size_t max_values>
     bool encoder<number_static_values,
                  max_values>::add_integer(tag_class tc,
@@ -941,7 +1378,7 @@ namespace asn1 {
         value->t = value::type::Value;
 
         // Encode integer.
-        value->vlen = encode_integer(val, value->v);
+        value->vlen = encode_integer_padded(val, value->v);
 
         end_value(value);
 
@@ -970,6 +1407,8 @@ namespace asn1 {
       } else {
         if ((ptr = malloc(len)) != nullptr) {
           memcpy(ptr, val, len);
+
+          ASN1_BER_STATS(_M_statistics.deep_copy_bytes += len);
           type = value::type::DeepCopy;
         } else {
           return false;
@@ -1003,7 +1442,8 @@ namespace asn1 {
                  max_values>::start_constructed(tag_class tc,
                                                 universal_class uc,
                                                 tagging tg,
-                                                tag_number tn)
+                                                tag_number tn,
+                                                length_form lf)
     {
       struct value* value;
       if ((value = create_value(tc,
@@ -1011,7 +1451,9 @@ namespace asn1 {
                                 uc,
                                 tg,
                                 tn)) != nullptr) {
-        value->t = value::type::Constructed;
+        value->t = (lf == length_form::Definite) ?
+                     value::type::Constructed :
+                     value::type::IndefiniteConstructed;
 
         value->vlen = 0;
 
@@ -1032,6 +1474,30 @@ namespace asn1 {
         struct value* value = get(_M_parent);
 
         if (value->uc == uc) {
+          // Indefinite length?
+          if (value->t == value::type::IndefiniteConstructed) {
+            // Add end-of-contents.
+            struct value* eoc;
+            if ((eoc = new_value()) != nullptr) {
+              eoc->uc = universal_class::EndOfContents;
+              eoc->t = value::type::Null;
+
+              eoc->tag[0] = 0x00;
+              eoc->taglen = 1;
+
+              eoc->vlen = 0;
+
+              eoc->parent = _M_parent;
+
+              end_value(eoc);
+
+              // The dynamic values might have been reallocated.
+              value = get(_M_parent);
+            } else {
+              return false;
+            }
+          }
+
           _M_parent = value->parent;
 
           end_value(value);
@@ -1061,10 +1527,10 @@ namespace asn1 {
           // Create value.
           if ((value = new_value()) != nullptr) {
             // Encode tag.
-            value->taglen = encode_tag(tc,
-                                       pc,
-                                       static_cast<tag_number>(uc),
-                                       value->tag);
+            value->taglen = encode_tag_padded(tc,
+                                              pc,
+                                              static_cast<tag_number>(uc),
+                                              value->tag);
           } else {
             return nullptr;
           }
@@ -1074,21 +1540,25 @@ namespace asn1 {
             // Implicit tagging?
             if (tg == tagging::Implicit) {
               // Encode tag.
-              value->taglen = encode_tag(tc, pc, tn, value->tag);
+              value->taglen = encode_tag_padded(tc, pc, tn, value->tag);
             } else {
               // Create child value.
               struct value* child;
               if ((child = new_value()) != nullptr) {
+                // The dynamic values might have been reallocated.
+                value = get(_M_used - 2);
+
                 value->uc = uc;
 
                 // Value is a explicit tag.
                 value->t = value::type::ExplicitTag;
 
                 // Encode tag.
-                value->taglen = encode_tag(tc,
-                                           primitive_constructed::Constructed,
-                                           tn,
-                                           value->tag);
+                value->taglen =
+                  encode_tag_padded(tc,
+                                    primitive_constructed::Constructed,
+                                    tn,
+                                    value->tag);
 
                 value->vlen = 0;
 
@@ -1098,10 +1568,11 @@ namespace asn1 {
                 _M_parent = _M_used - 2;
 
                 // Encode child tag.
-                child->taglen = encode_tag(tag_class::Universal,
-                                           pc,
-                                           static_cast<tag_number>(uc),
-                                           child->tag);
+                child->taglen =
+                  encode_tag_padded(tag_class::Universal,
+                                    pc,
+                                    static_cast<tag_number>(uc),
+                                    child->tag);
 
                 value = child;
               } else {
@@ -1132,11 +1603,13 @@ namespace asn1 {
     {
       // If there are enough static values...
       if (_M_used < number_static_values) {
+        ASN1_BER_STATS(_M_statistics.values++);
         return _M_static_values + _M_used++;
       }
 
       // If there are enough dynamic values...
-      if (_M_used + 1 < _M_size) {
+      if (_M_used < _M_size) {
+        ASN1_BER_STATS(_M_statistics.values++);
         return _M_dynamic_values + _M_used++ - number_static_values;
       }
 
@@ -1178,6 +1651,9 @@ namespace asn1 {
           _M_dynamic_values = values;
           _M_size = total;
 
+          ASN1_BER_STATS(_M_statistics.values++);
+          ASN1_BER_STATS(_M_statistics.reallocations++);
+
           return _M_dynamic_values + _M_used++ - number_static_values;
         }
       }
@@ -1185,12 +1661,109 @@ namespace asn1 {
       return nullptr;
     }
 
+    template<size_t number_static_values, size_t max_values>
+    bool encoder<number_static_values, max_values>::resize(size_t nvalues)
+    {
+      // The static values are always available.
+      if (nvalues <= number_static_values) {
+        if (_M_dynamic_values) {
+          free(_M_dynamic_values);
+          _M_dynamic_values = nullptr;
+        }
+
+        _M_size = number_static_values;
+
+        return true;
+      }
+
+      struct value* values;
+      if ((values = static_cast<struct value*>(
+                      realloc(_M_dynamic_values,
+                              (nvalues - number_static_values) *
+                              sizeof(struct value))
+                    )) != nullptr) {
+        _M_dynamic_values = values;
+        _M_size = nvalues;
+
+        ASN1_BER_STATS(_M_statistics.reallocations++);
+
+        return true;
+      }
+
+      return false;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    void encoder<number_static_values, max_values>::free_values()
+    {
+      for (size_t i = 0; i < _M_used; i++) {
+        struct value* value = get(i);
+        switch (value->t) {
+          case value::type::DeepCopy:
+          case value::type::BitstringDeepCopy:
+          case value::type::EncodedDeepCopy:
+            free(value->ptr);
+            break;
+          default:
+            ;
+        }
+      }
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    void encoder<number_static_values, max_values>::take(encoder& other)
+    {
+      // Copy the static values in use (the values only reference the user
+      // data and the deep copies, which are now owned by this encoder).
+      memcpy(_M_static_values,
+             other._M_static_values,
+             ((other._M_used < number_static_values) ?
+                other._M_used :
+                number_static_values) * sizeof(struct value));
+
+      // Take the dynamic values.
+      _M_dynamic_values = other._M_dynamic_values;
+
+      _M_size = other._M_size;
+      _M_used = other._M_used;
+
+      _M_parent = other._M_parent;
+
+      _M_high_water_mark = other._M_high_water_mark;
+      _M_peak = other._M_peak;
+
+#ifdef ASN1_BER_STATISTICS
+      _M_statistics = other._M_statistics;
+      other._M_statistics.clear();
+#endif
+
+      other._M_dynamic_values = nullptr;
+
+      other._M_size = number_static_values;
+      other._M_used = 0;
+
+      other._M_parent = -1;
+
+      other._M_peak = 0;
+    }
+
     template<size_t number_static_values, size_t max_values>
     void
     encoder<number_static_values, max_values>::end_value(struct value* value)
     {
       // Encode length.
-      value->lenlen = encode_length(value->vlen, value->len);
+      switch (value->t) {
+        case value::type::IndefiniteConstructed:
+          value->len[0] = 0x80;
+          value->lenlen = 1;
+          break;
+        case value::type::EncodedShallowCopy:
+        case value::type::EncodedDeepCopy:
+          // The length is already encoded.
+          break;
+        default:
+          value->lenlen = encode_length_padded(value->vlen, value->len);
+      }
 
       // If the value has a parent...
       if (value->parent != -1) {
@@ -1203,7 +1776,7 @@ namespace asn1 {
         // If the parent is a explicit tag...
         if (parent->t == value::type::ExplicitTag) {
           // Encode parent's length.
-          parent->lenlen = encode_length(parent->vlen, parent->len);
+          parent->lenlen = encode_length_padded(parent->vlen, parent->len);
 
           // Make '_M_parent' point to the grandparent.
           _M_parent = parent->parent;
@@ -0,0 +1,169 @@
+#ifndef ASN1_BER_ENCODER_POOL_H
+#define ASN1_BER_ENCODER_POOL_H
+
+#include <stdlib.h>
+#include <new>
+#include "asn1/ber/encoder.h"
+
+namespace asn1 {
+  namespace ber {
+    template<size_t number_static_values = 128, size_t max_values = ULONG_MAX>
+    class encoder_pool {
+      public:
+        typedef encoder<number_static_values, max_values> encoder_type;
+
+        static constexpr const size_t default_max_idle = 16;
+
+        // Constructor.
+        // 'max_idle': maximum number of idle encoders kept by the pool.
+        // 'nvalues': number of values reserved by the new encoders.
+        encoder_pool(size_t max_idle = default_max_idle, size_t nvalues = 0);
+
+        // Destructor.
+        ~encoder_pool();
+
+        // Get the pool of the calling thread.
+        static encoder_pool& local();
+
+        // Create 'count' idle encoders.
+        bool warm(size_t count);
+
+        // Acquire encoder.
+        encoder_type* acquire();
+
+        // Release encoder (the encoder is cleared).
+        // Returns whether the encoder has been kept by the pool (otherwise,
+        // it has been deleted).
+        bool release(encoder_type* e);
+
+        // Get number of idle encoders.
+        size_t idle() const;
+
+      private:
+        encoder_type** _M_idle = nullptr;
+        size_t _M_max_idle;
+        size_t _M_nidle = 0;
+
+        size_t _M_nvalues;
+
+        // Create encoder.
+        encoder_type* create() const;
+
+        // Disable copy constructor and assignment operator.
+        encoder_pool(const encoder_pool&) = delete;
+        encoder_pool& operator=(const encoder_pool&) = delete;
+    };
+
+    template<size_t number_static_values, size_t max_values>
+    inline
+    encoder_pool<number_static_values, max_values>::encoder_pool(
+      size_t max_idle,
+      size_t nvalues
+    )
+      : _M_max_idle(max_idle),
+        _M_nvalues(nvalues)
+    {
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    encoder_pool<number_static_values, max_values>::~encoder_pool()
+    {
+      if (_M_idle) {
+        for (size_t i = 0; i < _M_nidle; i++) {
+          delete _M_idle[i];
+        }
+
+        free(_M_idle);
+      }
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline encoder_pool<number_static_values, max_values>&
+    encoder_pool<number_static_values, max_values>::local()
+    {
+      static thread_local encoder_pool pool;
+      return pool;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    bool encoder_pool<number_static_values, max_values>::warm(size_t count)
+    {
+      if (count > _M_max_idle) {
+        count = _M_max_idle;
+      }
+
+      while (_M_nidle < count) {
+        encoder_type* e;
+        if (((e = create()) == nullptr) || (!release(e))) {
+          return false;
+        }
+      }
+
+      return true;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline typename encoder_pool<number_static_values,
+                                 max_values>::encoder_type*
+    encoder_pool<number_static_values, max_values>::acquire()
+    {
+      // If there are idle encoders...
+      if (_M_nidle > 0) {
+        return _M_idle[--_M_nidle];
+      }
+
+      return create();
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    bool
+    encoder_pool<number_static_values, max_values>::release(encoder_type* e)
+    {
+      e->clear();
+
+      // If the encoder can be kept...
+      if (_M_nidle < _M_max_idle) {
+        if (!_M_idle) {
+          if ((_M_idle = static_cast<encoder_type**>(
+                           malloc(_M_max_idle * sizeof(encoder_type*))
+                         )) == nullptr) {
+            delete e;
+            return false;
+          }
+        }
+
+        _M_idle[_M_nidle++] = e;
+
+        return true;
+      }
+
+      delete e;
+
+      return false;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    inline size_t encoder_pool<number_static_values, max_values>::idle() const
+    {
+      return _M_nidle;
+    }
+
+    template<size_t number_static_values, size_t max_values>
+    typename encoder_pool<number_static_values, max_values>::encoder_type*
+    encoder_pool<number_static_values, max_values>::create() const
+    {
+      encoder_type* e;
+      if ((e = new (std::nothrow) encoder_type()) != nullptr) {
+        if (e->reserve(_M_nvalues)) {
+          return e;
+        }
+
+        delete e;
+      }
+
+      return nullptr;
+    }
+  }
+}
+
+#endif // ASN1_BER_ENCODER_POOL_H
@@ -0,0 +1,34 @@
+#ifndef ASN1_BER_GROW_H
+#define ASN1_BER_GROW_H
+
+#include <stdlib.h>
+
+namespace asn1 {
+  namespace ber {
+    // Grow the array 'ptr' (of 'size' elements) to hold 'count' elements.
+    template<typename T>
+    inline bool grow(T*& ptr, size_t& size, size_t count)
+    {
+      if (count <= size) {
+        return true;
+      }
+
+      size_t s = (size > 0) ? size : 16;
+      while (s < count) {
+        s *= 2;
+      }
+
+      T* p;
+      if ((p = static_cast<T*>(realloc(ptr, s * sizeof(T)))) != nullptr) {
+        ptr = p;
+        size = s;
+
+        return true;
+      }
+
+      return false;
+    }
+  }
+}
+
+#endif // ASN1_BER_GROW_H
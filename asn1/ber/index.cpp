@@ -0,0 +1,343 @@
+#include <string.h>
+#include <endian.h>
+#include <sys/stat.h>
+#include "asn1/ber/index.h"
+
+static const char magic[] = "BERINDEX";
+static const size_t magic_length = 8;
+
+// Size of an entry (offset and length) and of a key (key and record number).
+static const size_t entry_size = 16;
+static const size_t key_size = 16;
+
+// Size of the blocks of the indexed file which are hashed.
+static const size_t hash_block_size = 4096;
+
+// Load 64-bit integer (little-endian).
+static inline uint64_t load64(const uint8_t* ptr)
+{
+  uint64_t n;
+  memcpy(&n, ptr, sizeof(uint64_t));
+
+  return le64toh(n);
+}
+
+// Load 32-bit integer (little-endian).
+static inline uint32_t load32(const uint8_t* ptr)
+{
+  uint32_t n;
+  memcpy(&n, ptr, sizeof(uint32_t));
+
+  return le32toh(n);
+}
+
+// Round up to a multiple of 8.
+static inline uint64_t pad8(uint64_t n)
+{
+  return (n + 7) & ~static_cast<uint64_t>(7);
+}
+
+// FNV-1a hash.
+static uint64_t fnv1a(const uint8_t* data, size_t len, uint64_t h)
+{
+  for (size_t i = 0; i < len; i++) {
+    h = (h ^ data[i]) * 1099511628211ull;
+  }
+
+  return h;
+}
+
+bool asn1::ber::file_identity::get(const char* filename,
+                                   const uint8_t* data,
+                                   uint64_t size)
+{
+  struct stat sb;
+  if (stat(filename, &sb) != 0) {
+    return false;
+  }
+
+  this->size = size;
+
+  mtime = (static_cast<int64_t>(sb.st_mtim.tv_sec) * 1000000000ll) +
+          sb.st_mtim.tv_nsec;
+
+  // First and last blocks (which might overlap).
+  size_t len = (size < hash_block_size) ? size : hash_block_size;
+
+  hash = fnv1a(data, len, 14695981039346656037ull);
+  hash = fnv1a(data + (size - len), len, hash);
+
+  return true;
+}
+
+bool asn1::ber::index::open(const char* filename)
+{
+  if (!_M_file.open(filename)) {
+    return false;
+  }
+
+  const uint8_t* const data = _M_file.data();
+  const uint64_t size = _M_file.size();
+
+  if ((size < header_size) ||
+      (memcmp(data, magic, magic_length) != 0) ||
+      (load32(data + 8) != version)) {
+    return false;
+  }
+
+  uint32_t keytype = load32(data + 12);
+  if (keytype > static_cast<uint32_t>(index_key_type::Time)) {
+    return false;
+  }
+
+  _M_keytype = static_cast<index_key_type>(keytype);
+
+  _M_records = load64(data + 16);
+  _M_nkeys = load64(data + 24);
+
+  _M_fileid.size = load64(data + 32);
+  _M_fileid.mtime = static_cast<int64_t>(load64(data + 48));
+  _M_fileid.hash = load64(data + 56);
+
+  uint32_t pathlen = load32(data + 40);
+  if (pathlen > max_path_length) {
+    return false;
+  }
+
+  // Check the size of the index.
+  uint64_t entries = header_size + pad8(pathlen);
+
+  if ((_M_records > (size - header_size) / entry_size) ||
+      (_M_nkeys > _M_records) ||
+      (entries + (_M_records * entry_size) + (_M_nkeys * key_size) != size)) {
+    return false;
+  }
+
+  memcpy(_M_keypath, data + header_size, pathlen);
+  _M_keypath[pathlen] = 0;
+
+  _M_entries = data + entries;
+  _M_keys = _M_entries + (_M_records * entry_size);
+
+  return true;
+}
+
+bool asn1::ber::index::record(uint64_t n,
+                              uint64_t& offset,
+                              uint64_t& length) const
+{
+  if (n < _M_records) {
+    offset = load64(_M_entries + (n * entry_size));
+    length = load64(_M_entries + (n * entry_size) + 8);
+
+    return true;
+  }
+
+  return false;
+}
+
+bool asn1::ber::index::find_offset(uint64_t offset, uint64_t& n) const
+{
+  // Binary search of the last record which starts at or before 'offset'.
+  uint64_t low = 0;
+  uint64_t high = _M_records;
+
+  while (low < high) {
+    uint64_t mid = low + ((high - low) / 2);
+
+    if (load64(_M_entries + (mid * entry_size)) <= offset) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  if (low > 0) {
+    const uint8_t* entry = _M_entries + ((low - 1) * entry_size);
+
+    if (offset - load64(entry) < load64(entry + 8)) {
+      n = low - 1;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint64_t asn1::ber::index::find_key(int64_t key, uint64_t& first) const
+{
+  // Binary search of the first key >= 'key'.
+  uint64_t low = 0;
+  uint64_t high = _M_nkeys;
+
+  while (low < high) {
+    uint64_t mid = low + ((high - low) / 2);
+
+    if (this->key(mid) < key) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  first = low;
+
+  uint64_t last = low;
+  while ((last < _M_nkeys) && (this->key(last) == key)) {
+    last++;
+  }
+
+  return last - first;
+}
+
+uint64_t asn1::ber::index::key_record(uint64_t n) const
+{
+  return load64(_M_keys + (n * key_size) + 8);
+}
+
+int64_t asn1::ber::index::key(uint64_t n) const
+{
+  return static_cast<int64_t>(load64(_M_keys + (n * key_size)));
+}
+
+asn1::ber::index_writer::~index_writer()
+{
+  if (_M_file) {
+    fclose(_M_file);
+  }
+
+  if (_M_keys) {
+    free(_M_keys);
+  }
+}
+
+bool asn1::ber::index_writer::open(const char* filename,
+                                   const file_identity& file,
+                                   index_key_type keytype,
+                                   const char* keypath)
+{
+  size_t pathlen = strlen(keypath);
+  if (pathlen > index::max_path_length) {
+    return false;
+  }
+
+  if ((_M_file = fopen(filename, "w")) == nullptr) {
+    return false;
+  }
+
+  _M_fileid = file;
+  _M_keytype = keytype;
+  _M_pathlen = pathlen;
+
+  // The header is written again when the index is closed.
+  static const uint8_t zeros[8] = {0};
+
+  return ((write_header(0)) &&
+          (fwrite(keypath, 1, pathlen, _M_file) == pathlen) &&
+          (fwrite(zeros, 1, pad8(pathlen) - pathlen, _M_file) ==
+           pad8(pathlen) - pathlen));
+}
+
+bool asn1::ber::index_writer::add(uint64_t offset, uint64_t length)
+{
+  if ((write(offset)) && (write(length))) {
+    _M_records++;
+    return true;
+  }
+
+  return false;
+}
+
+bool asn1::ber::index_writer::add(uint64_t offset,
+                                  uint64_t length,
+                                  int64_t key)
+{
+  if (_M_nkeys == _M_size) {
+    size_t size = (_M_size > 0) ? _M_size * 2 : 1024;
+
+    struct key* keys;
+    if ((keys = static_cast<struct key*>(
+                  realloc(_M_keys, size * sizeof(struct key))
+                )) == nullptr) {
+      return false;
+    }
+
+    _M_keys = keys;
+    _M_size = size;
+  }
+
+  _M_keys[_M_nkeys].value = key;
+  _M_keys[_M_nkeys].record = _M_records;
+
+  if (add(offset, length)) {
+    _M_nkeys++;
+    return true;
+  }
+
+  return false;
+}
+
+bool asn1::ber::index_writer::close()
+{
+  if (!_M_file) {
+    return false;
+  }
+
+  // Sort the keys (and by record number the records with the same key).
+  if (_M_nkeys > 1) {
+    qsort(_M_keys,
+          _M_nkeys,
+          sizeof(struct key),
+          [](const void* p1, const void* p2) -> int {
+            const struct key* k1 = static_cast<const struct key*>(p1);
+            const struct key* k2 = static_cast<const struct key*>(p2);
+
+            if (k1->value != k2->value) {
+              return (k1->value < k2->value) ? -1 : 1;
+            }
+
+            return (k1->record < k2->record) ? -1 : (k1->record > k2->record);
+          });
+  }
+
+  bool ret = true;
+
+  for (size_t i = 0; (i < _M_nkeys) && (ret); i++) {
+    ret = ((write(static_cast<uint64_t>(_M_keys[i].value))) &&
+           (write(_M_keys[i].record)));
+  }
+
+  ret = ((ret) &&
+         (fseek(_M_file, 0, SEEK_SET) == 0) &&
+         (write_header(_M_nkeys)));
+
+  ret = ((fclose(_M_file) == 0) && (ret));
+  _M_file = nullptr;
+
+  return ret;
+}
+
+bool asn1::ber::index_writer::write_header(uint64_t nkeys)
+{
+  uint32_t header[4] = {
+    htole32(index::version),
+    htole32(static_cast<uint32_t>(_M_keytype)),
+    htole32(static_cast<uint32_t>(_M_pathlen)),
+    0
+  };
+
+  return ((fwrite(magic, 1, magic_length, _M_file) == magic_length) &&
+          (fwrite(header, sizeof(uint32_t), 2, _M_file) == 2) &&
+          (write(_M_records)) &&
+          (write(nkeys)) &&
+          (write(_M_fileid.size)) &&
+          (fwrite(header + 2, sizeof(uint32_t), 2, _M_file) == 2) &&
+          (write(static_cast<uint64_t>(_M_fileid.mtime))) &&
+          (write(_M_fileid.hash)));
+}
+
+bool asn1::ber::index_writer::write(uint64_t n)
+{
+  n = htole64(n);
+  return (fwrite(&n, sizeof(uint64_t), 1, _M_file) == 1);
+}
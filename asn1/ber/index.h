@@ -0,0 +1,198 @@
+#ifndef ASN1_BER_INDEX_H
+#define ASN1_BER_INDEX_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include "asn1/ber/mapped_file.h"
+
+namespace asn1 {
+  namespace ber {
+    // Type of the key of the records of an index.
+    enum class index_key_type : uint32_t {
+      None = 0,
+      Int64 = 1,
+      Time = 2
+    };
+
+    static inline const char* to_string(index_key_type type)
+    {
+      switch (type) {
+        case index_key_type::None:  return "none";
+        case index_key_type::Int64: return "int64";
+        case index_key_type::Time:  return "time";
+        default:                    return "(unknown)";
+      }
+    }
+
+    // Identity of an indexed file: an index is stale if any of the fields
+    // has changed (the modification time detects changes anywhere in the
+    // file, the hash of the first and last blocks rewrites within the
+    // resolution of the modification time).
+    struct file_identity {
+      uint64_t size;
+
+      // Modification time (nanoseconds since the epoch).
+      int64_t mtime;
+
+      // Hash of the first and last blocks.
+      uint64_t hash;
+
+      // Get the identity of the file 'filename' (mapped at 'data').
+      bool get(const char* filename, const uint8_t* data, uint64_t size);
+
+      bool operator==(const file_identity& other) const
+      {
+        return ((size == other.size) &&
+                (mtime == other.mtime) &&
+                (hash == other.hash));
+      }
+
+      bool operator!=(const file_identity& other) const
+      {
+        return !(*this == other);
+      }
+    };
+
+    // Index of the records of a file. Format (little-endian):
+    //   - Header (64 bytes):
+    //       magic ("BERINDEX"), version (uint32), type of the key (uint32),
+    //       number of records (uint64), number of keys (uint64), size of the
+    //       indexed file (uint64), length of the path of the key (uint32),
+    //       reserved (uint32), modification time of the indexed file
+    //       (int64, nanoseconds), hash of the first and last blocks of the
+    //       indexed file (uint64).
+    //   - Path of the key (padded with zeros to a multiple of 8 bytes).
+    //   - Offset and length of each record (uint64, uint64).
+    //   - Key and record number (int64, uint64) of the records which have
+    //     key, sorted by key.
+    class index {
+      public:
+        static const uint32_t version = 2;
+        static const size_t header_size = 64;
+        static const size_t max_path_length = 1024;
+
+        // Constructor.
+        index() = default;
+
+        // Destructor.
+        ~index() = default;
+
+        // Open.
+        bool open(const char* filename);
+
+        // Get number of records.
+        uint64_t records() const
+        {
+          return _M_records;
+        }
+
+        // Get identity of the indexed file.
+        const file_identity& file() const
+        {
+          return _M_fileid;
+        }
+
+        // Get type of the key.
+        index_key_type key_type() const
+        {
+          return _M_keytype;
+        }
+
+        // Get path of the key.
+        const char* key_path() const
+        {
+          return _M_keypath;
+        }
+
+        // Get offset and length of the record 'n'.
+        bool record(uint64_t n, uint64_t& offset, uint64_t& length) const;
+
+        // Find the record which contains the byte at 'offset'.
+        bool find_offset(uint64_t offset, uint64_t& n) const;
+
+        // Find the records with the key 'key'.
+        // Returns the number of records; the first one is the key number
+        // 'first' (see key_record()).
+        uint64_t find_key(int64_t key, uint64_t& first) const;
+
+        // Get the record number of the key number 'n' (keys are sorted).
+        uint64_t key_record(uint64_t n) const;
+
+      private:
+        mapped_file _M_file;
+
+        uint64_t _M_records = 0;
+        uint64_t _M_nkeys = 0;
+
+        file_identity _M_fileid;
+
+        index_key_type _M_keytype = index_key_type::None;
+
+        char _M_keypath[max_path_length + 1];
+
+        const uint8_t* _M_entries = nullptr;
+        const uint8_t* _M_keys = nullptr;
+
+        // Get key number 'n'.
+        int64_t key(uint64_t n) const;
+    };
+
+    // Writer of an index.
+    class index_writer {
+      public:
+        // Constructor.
+        index_writer() = default;
+
+        // Destructor.
+        ~index_writer();
+
+        // Create index for the file 'file'.
+        bool open(const char* filename,
+                  const file_identity& file,
+                  index_key_type keytype = index_key_type::None,
+                  const char* keypath = "");
+
+        // Add record (without key).
+        bool add(uint64_t offset, uint64_t length);
+
+        // Add record with key.
+        bool add(uint64_t offset, uint64_t length, int64_t key);
+
+        // Write the keys and the header and close the index.
+        bool close();
+
+      private:
+        FILE* _M_file = nullptr;
+
+        uint64_t _M_records = 0;
+
+        file_identity _M_fileid;
+
+        index_key_type _M_keytype = index_key_type::None;
+        size_t _M_pathlen = 0;
+
+        // Keys.
+        struct key {
+          int64_t value;
+          uint64_t record;
+        };
+
+        key* _M_keys = nullptr;
+        size_t _M_nkeys = 0;
+        size_t _M_size = 0;
+
+        // Write header.
+        bool write_header(uint64_t nkeys);
+
+        // Write 64-bit integer (little-endian).
+        bool write(uint64_t n);
+
+        // Disable copy constructor and assignment operator.
+        index_writer(const index_writer&) = delete;
+        index_writer& operator=(const index_writer&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_INDEX_H
@@ -0,0 +1,748 @@
+#ifndef ASN1_BER_JSON_H
+#define ASN1_BER_JSON_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/error.h"
+
+#if defined(__SSE2__)
+  #include <emmintrin.h>
+#endif
+
+namespace asn1 {
+  namespace ber {
+    // ASN.1 object which transcodes the decoded values to JSON, one object
+    // per line (NDJSON) for each top-level value (record).
+    //
+    // Each value is written as:
+    //   {"tag":"[APPLICATION 1]","type":"constructed","value":[...]}
+    //
+    // Types:
+    //   - "constructed": array of values.
+    //   - "boolean", "integer", "enumerated", "real": JSON number / boolean
+    //     (non-finite reals are written as the strings "NaN", "Infinity"
+    //     and "-Infinity").
+    //   - "null": null.
+    //   - "oid": string ("1.2.840").
+    //   - "utc_time", "generalized_time": string in ISO 8601 format (UTC).
+    //   - "string": character strings of the universal class (invalid UTF-8
+    //     sequences are replaced by U+FFFD).
+    //   - "bytes": any other primitive, encoded in base64 or in hexadecimal.
+    //
+    // 'Writer' must have the methods of 'buffered_writer'.
+    template<typename Writer>
+    class json_object {
+      public:
+        // Encoding of the binary values.
+        enum class binary_encoding {
+          Base64,
+          Hex
+        };
+
+        // Constructor.
+        json_object(Writer& writer,
+                    binary_encoding encoding = binary_encoding::Base64)
+          : _M_writer(writer),
+            _M_encoding(encoding)
+        {
+        }
+
+        // Destructor.
+        ~json_object() = default;
+
+        // Start constructed.
+        bool start_constructed(tag_class tc,
+                               tag_number tn,
+                               uint64_t valuelen,
+                               uint64_t totallen)
+        {
+          begin_value(tc, tn, "constructed");
+          _M_writer.put('[');
+
+          _M_first = true;
+          _M_depth++;
+
+          return true;
+        }
+
+        // End constructed.
+        bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+        {
+          if (_M_depth > 0) {
+            _M_depth--;
+
+            _M_writer.write("]}", 2);
+            end_value();
+
+            return true;
+          }
+
+          return false;
+        }
+
+        // Boolean.
+        bool boolean(const void* buf, uint64_t len, bool val)
+        {
+          begin_value(universal_class::Boolean, "boolean");
+          _M_writer.write(val ? "true}" : "false}");
+          end_value();
+
+          return true;
+        }
+
+        // Integer.
+        bool integer(const void* buf, uint64_t len, int64_t val)
+        {
+          begin_value(universal_class::Integer, "integer");
+          _M_writer.integer(val);
+          _M_writer.put('}');
+          end_value();
+
+          return true;
+        }
+
+        // Null.
+        bool null()
+        {
+          begin_value(universal_class::Null, "null");
+          _M_writer.write("null}", 5);
+          end_value();
+
+          return true;
+        }
+
+        // Object identifier.
+        bool oid(const void* buf,
+                 uint64_t len,
+                 const uint64_t* oid,
+                 size_t ncomponents)
+        {
+          begin_value(universal_class::ObjectIdentifier, "oid");
+          _M_writer.put('"');
+
+          for (size_t i = 0; i < ncomponents; i++) {
+            if (i > 0) {
+              _M_writer.put('.');
+            }
+
+            _M_writer.unsigned_integer(oid[i]);
+          }
+
+          _M_writer.write("\"}", 2);
+          end_value();
+
+          return true;
+        }
+
+        // Real.
+        bool real(const void* buf, uint64_t len, double val);
+
+        // Enumerated.
+        bool enumerated(const void* buf, uint64_t len, int64_t val)
+        {
+          begin_value(universal_class::Enumerated, "enumerated");
+          _M_writer.integer(val);
+          _M_writer.put('}');
+          end_value();
+
+          return true;
+        }
+
+        // UTC time.
+        bool utc_time(const void* buf, uint64_t len, time_t val)
+        {
+          begin_value(universal_class::UTCTime, "utc_time");
+
+          if (!date_time(val)) {
+            return false;
+          }
+
+          _M_writer.write("Z\"}", 3);
+          end_value();
+
+          return true;
+        }
+
+        // Generalized time.
+        bool generalized_time(const void* buf,
+                              uint64_t len,
+                              const struct timeval& val)
+        {
+          begin_value(universal_class::GeneralizedTime, "generalized_time");
+
+          if (!date_time(val.tv_sec)) {
+            return false;
+          }
+
+          _M_writer.put('.');
+          _M_writer.unsigned_integer(static_cast<uint64_t>(val.tv_usec), 6);
+          _M_writer.write("Z\"}", 3);
+          end_value();
+
+          return true;
+        }
+
+        // Primitive.
+        bool primitive(tag_class tc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t valueoff,
+                       uint64_t valuelen);
+
+        // Error.
+        void error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        Writer& _M_writer;
+
+        const binary_encoding _M_encoding;
+
+        size_t _M_depth = 0;
+
+        // Is the next value the first one of the constructed?
+        bool _M_first = true;
+
+        // Is the primitive value being written a string?
+        bool _M_string;
+
+        // Incomplete UTF-8 sequence at the end of the last chunk of a string.
+        uint8_t _M_pending[4];
+        size_t _M_npending = 0;
+
+        // Bytes not yet encoded in base64 (the last chunk of a binary value
+        // didn't have a multiple of three bytes).
+        uint8_t _M_carry[3];
+        size_t _M_ncarry = 0;
+
+        enum error _M_error = error::callback;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+
+        // Write the beginning of a value (up to the value itself).
+        void begin_value(tag_class tc, tag_number tn, const char* type);
+
+        void begin_value(universal_class uc, const char* type)
+        {
+          begin_value(tag_class::Universal, static_cast<tag_number>(uc), type);
+        }
+
+        // End of value.
+        void end_value()
+        {
+          _M_first = false;
+
+          // End of record?
+          if (_M_depth == 0) {
+            _M_writer.put('\n');
+          }
+        }
+
+        // Write date and time ("YYYY-MM-DDThh:mm:ss").
+        bool date_time(time_t t);
+
+        // Is the value of the universal class 'uc' a character string?
+        static bool is_string(universal_class uc);
+
+        // Write chunk of a string.
+        void string(const uint8_t* b, size_t len, bool last);
+
+        // Escape chunk of a string. If 'last' is false, an incomplete UTF-8
+        // sequence at the end is kept in '_M_pending'.
+        void escape(const uint8_t* b, size_t len, bool last);
+
+        // Escape character (< 0x80).
+        void escape(uint8_t c);
+
+        // Get length of the UTF-8 sequence starting with 'c' (0 if 'c' is
+        // not a valid first byte).
+        static size_t utf8_length(uint8_t c)
+        {
+          if ((c >= 0xc2) && (c <= 0xdf)) {
+            return 2;
+          } else if ((c >= 0xe0) && (c <= 0xef)) {
+            return 3;
+          } else if ((c >= 0xf0) && (c <= 0xf4)) {
+            return 4;
+          } else {
+            return 0;
+          }
+        }
+
+        // Get the number of bytes of b[0..len) which are a valid prefix of
+        // the UTF-8 sequence starting with b[0] (at least 1).
+        static size_t utf8_prefix(const uint8_t* b, size_t len);
+
+        // Write replacement character (U+FFFD).
+        void replacement_character()
+        {
+          _M_writer.write("\xef\xbf\xbd", 3);
+        }
+
+        // Write chunk of a binary value.
+        void binary(const uint8_t* b, size_t len, bool last);
+
+        // Encode in base64 groups of three bytes.
+        void base64(const uint8_t* b, size_t len);
+    };
+
+    template<typename Writer>
+    bool json_object<Writer>::real(const void* buf,
+                                   uint64_t len,
+                                   double val)
+    {
+      begin_value(universal_class::Real, "real");
+
+      if (isfinite(val)) {
+        static const size_t max_real_len = 32;
+
+        char* ptr;
+        if ((ptr = _M_writer.reserve(max_real_len)) == nullptr) {
+          return false;
+        }
+
+        int n = snprintf(ptr, max_real_len, "%.17g", val);
+        if ((n <= 0) || (static_cast<size_t>(n) >= max_real_len)) {
+          return false;
+        }
+
+        _M_writer.commit(n);
+      } else if (isnan(val)) {
+        _M_writer.write("\"NaN\"");
+      } else if (val > 0) {
+        _M_writer.write("\"Infinity\"");
+      } else {
+        _M_writer.write("\"-Infinity\"");
+      }
+
+      _M_writer.put('}');
+      end_value();
+
+      return true;
+    }
+
+    template<typename Writer>
+    bool json_object<Writer>::primitive(tag_class tc,
+                                        tag_number tn,
+                                        const void* buf,
+                                        uint64_t len,
+                                        uint64_t valueoff,
+                                        uint64_t valuelen)
+    {
+      // Beginning of the primitive value?
+      if (valueoff == 0) {
+        _M_string = ((tc == tag_class::Universal) &&
+                     (is_string(static_cast<universal_class>(tn))));
+
+        begin_value(tc, tn, _M_string ? "string" : "bytes");
+        _M_writer.put('"');
+
+        _M_npending = 0;
+        _M_ncarry = 0;
+      }
+
+      const bool last = (valueoff + len == valuelen);
+
+      if (_M_string) {
+        string(static_cast<const uint8_t*>(buf), len, last);
+      } else {
+        binary(static_cast<const uint8_t*>(buf), len, last);
+      }
+
+      if (last) {
+        _M_writer.write("\"}", 2);
+        end_value();
+      }
+
+      return true;
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::begin_value(tag_class tc,
+                                          tag_number tn,
+                                          const char* type)
+    {
+      if (!_M_first) {
+        _M_writer.put(',');
+      }
+
+      _M_writer.write("{\"tag\":\"[", 9);
+
+      switch (tc) {
+        case tag_class::Universal:
+          _M_writer.write("UNIVERSAL ", 10);
+          break;
+        case tag_class::Application:
+          _M_writer.write("APPLICATION ", 12);
+          break;
+        case tag_class::ContextSpecific:
+          break;
+        case tag_class::Private:
+          _M_writer.write("PRIVATE ", 8);
+          break;
+      }
+
+      _M_writer.unsigned_integer(tn);
+      _M_writer.write("]\",\"type\":\"", 11);
+      _M_writer.write(type);
+      _M_writer.write("\",\"value\":", 10);
+    }
+
+    template<typename Writer>
+    bool json_object<Writer>::date_time(time_t t)
+    {
+      struct tm tm;
+      if (gmtime_r(&t, &tm)) {
+        _M_writer.put('"');
+        _M_writer.unsigned_integer(static_cast<unsigned>(1900 + tm.tm_year), 4);
+        _M_writer.put('-');
+        _M_writer.unsigned_integer(static_cast<unsigned>(1 + tm.tm_mon), 2);
+        _M_writer.put('-');
+        _M_writer.unsigned_integer(static_cast<unsigned>(tm.tm_mday), 2);
+        _M_writer.put('T');
+        _M_writer.unsigned_integer(static_cast<unsigned>(tm.tm_hour), 2);
+        _M_writer.put(':');
+        _M_writer.unsigned_integer(static_cast<unsigned>(tm.tm_min), 2);
+        _M_writer.put(':');
+        _M_writer.unsigned_integer(static_cast<unsigned>(tm.tm_sec), 2);
+
+        return true;
+      }
+
+      return false;
+    }
+
+    template<typename Writer>
+    bool json_object<Writer>::is_string(universal_class uc)
+    {
+      switch (uc) {
+        case universal_class::ObjectDescriptor:
+        case universal_class::UTF8String:
+        case universal_class::NumericString:
+        case universal_class::PrintableString:
+        case universal_class::IA5String:
+        case universal_class::GraphicString:
+        case universal_class::VisibleString:
+        case universal_class::GeneralString:
+          return true;
+        default:
+          return false;
+      }
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::string(const uint8_t* b, size_t len, bool last)
+    {
+      // Complete the UTF-8 sequence of the previous chunk.
+      while ((_M_npending > 0) && (len > 0)) {
+        uint8_t tmp[4];
+        size_t n = _M_npending;
+        memcpy(tmp, _M_pending, n);
+
+        size_t count = utf8_length(tmp[0]) - n;
+        if (count > len) {
+          count = len;
+        }
+
+        memcpy(tmp + n, b, count);
+
+        b += count;
+        len -= count;
+
+        _M_npending = 0;
+
+        escape(tmp, n + count, last && (len == 0));
+      }
+
+      if (len > 0) {
+        escape(b, len, last);
+      } else if ((last) && (_M_npending > 0)) {
+        replacement_character();
+        _M_npending = 0;
+      }
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::escape(const uint8_t* b, size_t len, bool last)
+    {
+      // Beginning of the run of characters which don't need escaping.
+      size_t run = 0;
+
+      size_t i = 0;
+
+      while (i < len) {
+#if defined(__SSE2__)
+        // Skip blocks of 16 characters which don't need escaping: the
+        // signed comparison with 0x20 also matches the bytes >= 0x80.
+        const __m128i space = _mm_set1_epi8(0x20);
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+
+        while (i + 16 <= len) {
+          const __m128i v = _mm_loadu_si128(
+                              reinterpret_cast<const __m128i*>(b + i)
+                            );
+
+          int mask = _mm_movemask_epi8(
+                       _mm_or_si128(_mm_cmplt_epi8(v, space),
+                                    _mm_or_si128(_mm_cmpeq_epi8(v, quote),
+                                                 _mm_cmpeq_epi8(v, backslash)))
+                     );
+
+          if (mask == 0) {
+            i += 16;
+          } else {
+            i += __builtin_ctz(mask);
+            break;
+          }
+        }
+
+        if (i == len) {
+          break;
+        }
+#endif
+
+        const uint8_t c = b[i];
+
+        if ((c >= 0x20) && (c < 0x80) && (c != '"') && (c != '\\')) {
+          i++;
+          continue;
+        }
+
+        // Write the characters which don't need escaping.
+        if (i > run) {
+          _M_writer.write(b + run, i - run);
+        }
+
+        if (c < 0x80) {
+          escape(c);
+          i++;
+        } else {
+          size_t n = utf8_length(c);
+
+          if (n > 0) {
+            size_t available = (i + n <= len) ? n : len - i;
+            size_t valid = utf8_prefix(b + i, available);
+
+            if (valid == n) {
+              _M_writer.write(b + i, n);
+              i += n;
+            } else if ((valid == available) && (!last)) {
+              // Keep the incomplete sequence for the next chunk.
+              memcpy(_M_pending, b + i, available);
+              _M_npending = available;
+
+              return;
+            } else {
+              // Replace the maximal valid prefix of the sequence.
+              replacement_character();
+              i += valid;
+            }
+          } else {
+            replacement_character();
+            i++;
+          }
+        }
+
+        run = i;
+      }
+
+      if (len > run) {
+        _M_writer.write(b + run, len - run);
+      }
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::escape(uint8_t c)
+    {
+      switch (c) {
+        case '"':
+          _M_writer.write("\\\"", 2);
+          break;
+        case '\\':
+          _M_writer.write("\\\\", 2);
+          break;
+        case '\b':
+          _M_writer.write("\\b", 2);
+          break;
+        case '\f':
+          _M_writer.write("\\f", 2);
+          break;
+        case '\n':
+          _M_writer.write("\\n", 2);
+          break;
+        case '\r':
+          _M_writer.write("\\r", 2);
+          break;
+        case '\t':
+          _M_writer.write("\\t", 2);
+          break;
+        default:
+          _M_writer.write("\\u00", 4);
+          _M_writer.hex(c);
+      }
+    }
+
+    template<typename Writer>
+    size_t json_object<Writer>::utf8_prefix(const uint8_t* b, size_t len)
+    {
+      for (size_t i = 1; i < len; i++) {
+        uint8_t min = 0x80;
+        uint8_t max = 0xbf;
+
+        // The second byte excludes the overlong encodings, the surrogates
+        // and the code points above U+10FFFF.
+        if (i == 1) {
+          switch (b[0]) {
+            case 0xe0:
+              min = 0xa0;
+              break;
+            case 0xed:
+              max = 0x9f;
+              break;
+            case 0xf0:
+              min = 0x90;
+              break;
+            case 0xf4:
+              max = 0x8f;
+              break;
+          }
+        }
+
+        if ((b[i] < min) || (b[i] > max)) {
+          return i;
+        }
+      }
+
+      return len;
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::binary(const uint8_t* b, size_t len, bool last)
+    {
+      if (_M_encoding == binary_encoding::Hex) {
+        for (size_t i = 0; i < len; i++) {
+          _M_writer.hex(b[i]);
+        }
+
+        return;
+      }
+
+      // Complete the group of three bytes of the previous chunk.
+      if (_M_ncarry > 0) {
+        while ((_M_ncarry < 3) && (len > 0)) {
+          _M_carry[_M_ncarry++] = *b++;
+          len--;
+        }
+
+        if (_M_ncarry == 3) {
+          base64(_M_carry, 3);
+          _M_ncarry = 0;
+        }
+      }
+
+      size_t groups = len - (len % 3);
+      base64(b, groups);
+
+      b += groups;
+      len -= groups;
+
+      memcpy(_M_carry + _M_ncarry, b, len);
+      _M_ncarry += len;
+
+      // Padding.
+      if ((last) && (_M_ncarry > 0)) {
+        static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                       "abcdefghijklmnopqrstuvwxyz"
+                                       "0123456789+/";
+
+        char out[4];
+
+        out[0] = alphabet[_M_carry[0] >> 2];
+
+        if (_M_ncarry == 1) {
+          out[1] = alphabet[(_M_carry[0] & 0x03) << 4];
+          out[2] = '=';
+        } else {
+          out[1] = alphabet[((_M_carry[0] & 0x03) << 4) | (_M_carry[1] >> 4)];
+          out[2] = alphabet[(_M_carry[1] & 0x0f) << 2];
+        }
+
+        out[3] = '=';
+
+        _M_writer.write(out, 4);
+
+        _M_ncarry = 0;
+      }
+    }
+
+    template<typename Writer>
+    void json_object<Writer>::base64(const uint8_t* b, size_t len)
+    {
+      static const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ"
+                                     "abcdefghijklmnopqrstuvwxyz"
+                                     "0123456789+/";
+
+      // Number of groups of three bytes encoded per reservation.
+      static const size_t groups_per_block = 1024;
+
+      while (len > 0) {
+        size_t groups = len / 3;
+        if (groups > groups_per_block) {
+          groups = groups_per_block;
+        }
+
+        char* ptr;
+        if ((ptr = _M_writer.reserve(groups * 4)) == nullptr) {
+          return;
+        }
+
+        for (size_t i = 0; i < groups; i++, b += 3, ptr += 4) {
+          const uint32_t n = (static_cast<uint32_t>(b[0]) << 16) |
+                             (static_cast<uint32_t>(b[1]) << 8) |
+                             b[2];
+
+          ptr[0] = alphabet[n >> 18];
+          ptr[1] = alphabet[(n >> 12) & 0x3f];
+          ptr[2] = alphabet[(n >> 6) & 0x3f];
+          ptr[3] = alphabet[n & 0x3f];
+        }
+
+        _M_writer.commit(groups * 4);
+
+        len -= groups * 3;
+      }
+    }
+  }
+}
+
+#endif // ASN1_BER_JSON_H
@@ -0,0 +1,113 @@
+#ifndef ASN1_BER_MAPPED_FILE_H
+#define ASN1_BER_MAPPED_FILE_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+namespace asn1 {
+  namespace ber {
+    // File mapped into memory (read-only).
+    class mapped_file {
+      public:
+        // Constructor.
+        mapped_file() = default;
+
+        // Destructor.
+        ~mapped_file()
+        {
+          if (_M_buf != MAP_FAILED) {
+            munmap(_M_buf, _M_size);
+          }
+
+          if (_M_fd != -1) {
+            close(_M_fd);
+          }
+        }
+
+        // Open.
+        // If 'copy_on_write' is true, the file is mapped privately and can be
+        // modified through writable_data() (the changes are not written to
+        // the file).
+        bool open(const char* filename, bool copy_on_write = false)
+        {
+          // If the file exists and is a regular file...
+          struct stat sb;
+          if ((stat(filename, &sb) == 0) && (S_ISREG(sb.st_mode))) {
+            // Open file for reading.
+            if ((_M_fd = ::open(filename, O_RDONLY)) != -1) {
+              // Empty file?
+              if (sb.st_size == 0) {
+                return true;
+              }
+
+              // Map file into memory.
+              if ((_M_buf = mmap(nullptr,
+                                 sb.st_size,
+                                 copy_on_write ?
+                                   PROT_READ | PROT_WRITE :
+                                   PROT_READ,
+                                 copy_on_write ? MAP_PRIVATE : MAP_SHARED,
+                                 _M_fd,
+                                 0)) != MAP_FAILED) {
+                _M_size = sb.st_size;
+                _M_writable = copy_on_write;
+
+                return true;
+              }
+            }
+          }
+
+          return false;
+        }
+
+        // Get data.
+        const uint8_t* data() const
+        {
+          return (_M_buf != MAP_FAILED) ?
+                   static_cast<const uint8_t*>(_M_buf) :
+                   nullptr;
+        }
+
+        // Get data (nullptr if the file has not been mapped copy-on-write).
+        uint8_t* writable_data()
+        {
+          return ((_M_buf != MAP_FAILED) && (_M_writable)) ?
+                   static_cast<uint8_t*>(_M_buf) :
+                   nullptr;
+        }
+
+        // Get file size.
+        size_t size() const
+        {
+          return _M_size;
+        }
+
+        // Is 'filename' the file which has been opened?
+        bool same_file(const char* filename) const
+        {
+          struct stat sb1, sb2;
+          return ((_M_fd != -1) &&
+                  (fstat(_M_fd, &sb1) == 0) &&
+                  (stat(filename, &sb2) == 0) &&
+                  (sb1.st_dev == sb2.st_dev) &&
+                  (sb1.st_ino == sb2.st_ino));
+        }
+
+      private:
+        int _M_fd = -1;
+        void* _M_buf = MAP_FAILED;
+        size_t _M_size = 0;
+        bool _M_writable = false;
+
+        // Disable copy constructor and assignment operator.
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_MAPPED_FILE_H
@@ -0,0 +1,957 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "asn1/ber/matcher.h"
+#include "asn1/ber/common.h"
+#include "asn1/ber/path.h"
+#include "asn1/ber/grow.h"
+
+#define IS_DIGIT(x) (((x) >= '0') && ((x) <= '9'))
+#define IS_SPACE(x) (((x) == ' ') || ((x) == '\t'))
+
+// Initial size of the hash tables (power of 2).
+static const size_t initial_table_size = 256;
+
+// Mix the bits of 'h'.
+static inline uint64_t mix(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+
+  return h;
+}
+
+// Hash of a transition.
+static inline uint64_t transition_hash(uint32_t from,
+                                       asn1::ber::tag_class tc,
+                                       asn1::ber::tag_number tn)
+{
+  return mix(mix(tn) ^
+             ((static_cast<uint64_t>(from) << 2) | static_cast<uint64_t>(tc)));
+}
+
+// Get the value of a hexadecimal digit (-1 if it is not valid).
+static inline int hex_value(char c)
+{
+  if (IS_DIGIT(c)) {
+    return c - '0';
+  } else if ((c >= 'a') && (c <= 'f')) {
+    return c - 'a' + 10;
+  } else if ((c >= 'A') && (c <= 'F')) {
+    return c - 'A' + 10;
+  }
+
+  return -1;
+}
+
+// Skip spaces.
+static inline const char* skip_spaces(const char* s)
+{
+  while (IS_SPACE(*s)) {
+    s++;
+  }
+
+  return s;
+}
+
+asn1::ber::matcher::~matcher()
+{
+  free(_M_steps);
+  free(_M_queries);
+  free(_M_literals);
+  free(_M_states);
+  free(_M_pool);
+  free(_M_statetable);
+  free(_M_transitions);
+  free(_M_tagtable);
+  free(_M_positions);
+  free(_M_matched);
+  free(_M_matches);
+}
+
+bool asn1::ber::matcher::add(const char* s)
+{
+  if (_M_nqueries == UINT32_MAX - 1) {
+    return false;
+  }
+
+  const size_t nsteps = _M_nsteps;
+  const size_t literalslen = _M_literalslen;
+
+  query q;
+  q.first = _M_nsteps;
+
+  // Parse pattern.
+  bool ret;
+
+  do {
+    if ((s[0] == '*') && (s[1] == '*')) {
+      ret = add_step(step_type::AnyPath, tag_class::Universal, 0);
+      s += 2;
+    } else if (*s == '*') {
+      ret = add_step(step_type::Any, tag_class::Universal, 0);
+      s++;
+    } else {
+      path_step step;
+      if ((s = path::parse_step(s, step)) == nullptr) {
+        ret = false;
+        break;
+      }
+
+      ret = add_step(step_type::Tag, step.tc, step.tn);
+    }
+  } while ((ret) && (*s == '/') && (++s));
+
+  if (ret) {
+    s = skip_spaces(s);
+
+    // Only the existence of the value?
+    if (!*s) {
+      q.op = operation::Exists;
+      q.integer = false;
+    } else {
+      ret = parse_value(s, q);
+    }
+  }
+
+  if ((ret) &&
+      (add_step(step_type::Accept,
+                tag_class::Universal,
+                static_cast<tag_number>(_M_nqueries))) &&
+      (grow(_M_queries, _M_sizequeries, _M_nqueries + 1)) &&
+      (grow(_M_matches, _M_sizematches, _M_nqueries + 1))) {
+    // Grow the bitmap of the matched queries.
+    if (_M_nqueries % 64 == 0) {
+      uint64_t* matched;
+      if ((matched = static_cast<uint64_t*>(
+                       realloc(_M_matched,
+                               ((_M_nqueries / 64) + 1) * sizeof(uint64_t))
+                     )) == nullptr) {
+        _M_nsteps = nsteps;
+        _M_literalslen = literalslen;
+
+        return false;
+      }
+
+      _M_matched = matched;
+      _M_matched[_M_nqueries / 64] = 0;
+    }
+
+    _M_queries[_M_nqueries++] = q;
+
+    // The DFA has to be built again.
+    clear();
+
+    return true;
+  }
+
+  _M_nsteps = nsteps;
+  _M_literalslen = literalslen;
+
+  return false;
+}
+
+bool asn1::ber::matcher::begin_record()
+{
+  if ((_M_nstates == 0) && (!init())) {
+    return false;
+  }
+
+  // Clear the matched queries.
+  for (size_t i = 0; i < _M_nmatches; i++) {
+    _M_matched[_M_matches[i] / 64] = 0;
+  }
+
+  _M_nmatches = 0;
+
+  _M_record++;
+
+  _M_depth = 0;
+  _M_stack[0] = _M_initial;
+
+  _M_primitive = dead;
+
+  return true;
+}
+
+bool asn1::ber::matcher::start_constructed(tag_class tc,
+                                           tag_number tn,
+                                           uint64_t valuelen,
+                                           uint64_t totallen)
+{
+  if (_M_depth > max_depth) {
+    _M_message = "maximum depth exceeded";
+    return false;
+  }
+
+  uint32_t s;
+  if ((s = next(_M_stack[_M_depth], tc, tn)) == empty) {
+    _M_message = "error allocating memory";
+    return false;
+  }
+
+  _M_stack[++_M_depth] = s;
+
+  if (_M_states[s].naccepts > 0) {
+    evaluate(s, false, nullptr, 0, false, 0);
+  }
+
+  return true;
+}
+
+bool asn1::ber::matcher::primitive(tag_class tc,
+                                   tag_number tn,
+                                   const void* buf,
+                                   uint64_t len,
+                                   uint64_t valueoff,
+                                   uint64_t valuelen)
+{
+  // First chunk?
+  if (valueoff == 0) {
+    uint32_t s;
+    if ((s = next(_M_stack[_M_depth], tc, tn)) == empty) {
+      _M_message = "error allocating memory";
+      return false;
+    }
+
+    if (_M_states[s].naccepts == 0) {
+      _M_primitive = dead;
+      return true;
+    }
+
+    // Complete value?
+    if (len == valuelen) {
+      const bool isint = (len - 1 < 8);
+
+      evaluate(s,
+               true,
+               buf,
+               len,
+               isint,
+               isint ? decode_integer(buf, len) : 0);
+
+      _M_primitive = dead;
+
+      return true;
+    }
+
+    _M_primitive = s;
+
+    // The values longer than the values of the queries are not buffered.
+    if ((_M_buffering = (valuelen <= max_value_length)) == false) {
+      evaluate(s, true, nullptr, valuelen, false, 0);
+
+      _M_primitive = dead;
+
+      return true;
+    }
+  }
+
+  if (_M_primitive != dead) {
+    memcpy(_M_value + valueoff, buf, len);
+
+    // Last chunk?
+    if (valueoff + len == valuelen) {
+      const bool isint = (valuelen - 1 < 8);
+
+      evaluate(_M_primitive,
+               true,
+               _M_value,
+               valuelen,
+               isint,
+               isint ? decode_integer(_M_value, valuelen) : 0);
+
+      _M_primitive = dead;
+    }
+  }
+
+  return true;
+}
+
+bool asn1::ber::matcher::parse_value(const char* s, query& q)
+{
+  // Parse operator.
+  if ((s[0] == '=') && (s[1] == '=')) {
+    q.op = operation::Equal;
+    s += 2;
+  } else if ((s[0] == '!') && (s[1] == '=')) {
+    q.op = operation::NotEqual;
+    s += 2;
+  } else if ((s[0] == '<') && (s[1] == '=')) {
+    q.op = operation::LessEqual;
+    s += 2;
+  } else if (s[0] == '<') {
+    q.op = operation::Less;
+    s++;
+  } else if ((s[0] == '>') && (s[1] == '=')) {
+    q.op = operation::GreaterEqual;
+    s += 2;
+  } else if (s[0] == '>') {
+    q.op = operation::Greater;
+    s++;
+  } else {
+    return false;
+  }
+
+  s = skip_spaces(s);
+
+  q.integer = false;
+  q.offset = _M_literalslen;
+
+  if (*s == '"') {
+    // String.
+    for (s++; *s != '"'; s++) {
+      if (!*s) {
+        return false;
+      }
+
+      if ((*s == '\\') && ((s[1] == '"') || (s[1] == '\\'))) {
+        s++;
+      }
+
+      if (!add_literal(s, 1)) {
+        return false;
+      }
+    }
+
+    s++;
+  } else if ((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'))) {
+    // Hexadecimal string.
+    int hi, lo;
+    for (s += 2;
+         ((hi = hex_value(s[0])) >= 0) && ((lo = hex_value(s[1])) >= 0);
+         s += 2) {
+      const uint8_t b = static_cast<uint8_t>((hi << 4) | lo);
+      if (!add_literal(&b, 1)) {
+        return false;
+      }
+    }
+  } else if ((IS_DIGIT(*s)) && (strchr(s, '.'))) {
+    // Object identifier.
+    uint64_t oid[max_oid_components];
+    size_t ncomponents = 0;
+
+    do {
+      if ((ncomponents == max_oid_components) || (!IS_DIGIT(*s))) {
+        return false;
+      }
+
+      char* end;
+      errno = 0;
+      oid[ncomponents++] = strtoull(s, &end, 10);
+      if (errno != 0) {
+        return false;
+      }
+
+      s = end;
+    } while ((*s == '.') && (*++s));
+
+    uint8_t buf[max_value_length];
+    size_t len;
+    if (((len = oid_length(oid, ncomponents)) == 0) ||
+        (len > sizeof(buf))) {
+      return false;
+    }
+
+    encode_oid(oid, ncomponents, buf);
+
+    if (!add_literal(buf, len)) {
+      return false;
+    }
+  } else {
+    // Integer.
+    char* end;
+    errno = 0;
+    q.value = strtoll(s, &end, 10);
+    if ((end == s) || (errno != 0)) {
+      return false;
+    }
+
+    q.integer = true;
+
+    s = end;
+  }
+
+  if ((q.length = _M_literalslen - q.offset) > max_value_length) {
+    return false;
+  }
+
+  // Only equality for the strings and the object identifiers.
+  if ((!q.integer) &&
+      (q.op != operation::Equal) &&
+      (q.op != operation::NotEqual)) {
+    return false;
+  }
+
+  return (!*skip_spaces(s));
+}
+
+bool asn1::ber::matcher::add_step(step_type type,
+                                  tag_class tc,
+                                  tag_number tn)
+{
+  if (grow(_M_steps, _M_sizesteps, _M_nsteps + 1)) {
+    _M_steps[_M_nsteps].type = type;
+    _M_steps[_M_nsteps].tc = tc;
+    _M_steps[_M_nsteps].tn = tn;
+
+    _M_nsteps++;
+
+    return true;
+  }
+
+  return false;
+}
+
+bool asn1::ber::matcher::add_literal(const void* buf, size_t len)
+{
+  if (grow(_M_literals, _M_sizeliterals, _M_literalslen + len)) {
+    memcpy(_M_literals + _M_literalslen, buf, len);
+    _M_literalslen += len;
+
+    return true;
+  }
+
+  return false;
+}
+
+void asn1::ber::matcher::clear()
+{
+  _M_nstates = 0;
+  _M_poollen = 0;
+  _M_ntransitions = 0;
+
+  for (size_t i = 0; i < _M_statetablesize; i++) {
+    _M_statetable[i] = empty;
+  }
+
+  for (size_t i = 0; i < _M_transitionssize; i++) {
+    _M_transitions[i].from = empty;
+  }
+}
+
+bool asn1::ber::matcher::init()
+{
+  if (_M_statetablesize == 0) {
+    if ((_M_statetable = static_cast<uint32_t*>(
+                           malloc(initial_table_size * sizeof(uint32_t))
+                         )) == nullptr) {
+      return false;
+    }
+
+    if ((_M_transitions = static_cast<transition*>(
+                            malloc(initial_table_size * sizeof(transition))
+                          )) == nullptr) {
+      free(_M_statetable);
+      _M_statetable = nullptr;
+
+      return false;
+    }
+
+    _M_statetablesize = initial_table_size;
+    _M_transitionssize = initial_table_size;
+
+    clear();
+  }
+
+  // Hash table of the tags of the patterns (the empty slots have the type
+  // 'Accept').
+  size_t ntags = 0;
+  for (size_t i = 0; i < _M_nsteps; i++) {
+    if (_M_steps[i].type == step_type::Tag) {
+      ntags++;
+    }
+  }
+
+  size_t size = 16;
+  while (size < ntags * 2) {
+    size *= 2;
+  }
+
+  if (size != _M_tagtablesize) {
+    step* table;
+    if ((table = static_cast<step*>(
+                   realloc(_M_tagtable, size * sizeof(step))
+                 )) == nullptr) {
+      return false;
+    }
+
+    _M_tagtable = table;
+    _M_tagtablesize = size;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    _M_tagtable[i].type = step_type::Accept;
+  }
+
+  for (size_t i = 0; i < _M_nsteps; i++) {
+    const step& st = _M_steps[i];
+
+    if ((st.type == step_type::Tag) && (!pattern_tag(st.tc, st.tn))) {
+      size_t j;
+      for (j = transition_hash(0, st.tc, st.tn) & (size - 1);
+           _M_tagtable[j].type != step_type::Accept;
+           j = (j + 1) & (size - 1));
+
+      _M_tagtable[j] = st;
+    }
+  }
+
+  // Dead state.
+  if (!grow(_M_states, _M_sizestates, 1)) {
+    return false;
+  }
+
+  _M_states[dead].hash = 0;
+  _M_states[dead].positions = 0;
+  _M_states[dead].npositions = 0;
+  _M_states[dead].accepts = 0;
+  _M_states[dead].naccepts = 0;
+  _M_states[dead].nexists = 0;
+  _M_states[dead].record = 0;
+  _M_states[dead].other = dead;
+
+  _M_nstates = 1;
+
+  // Initial state: the beginning of all the patterns.
+  _M_npositions = 0;
+
+  for (size_t i = 0; i < _M_nqueries; i++) {
+    if (!add_position(_M_queries[i].first)) {
+      clear();
+      return false;
+    }
+  }
+
+  if ((_M_initial = build_state()) == empty) {
+    clear();
+    return false;
+  }
+
+  return true;
+}
+
+uint32_t asn1::ber::matcher::next(uint32_t from, tag_class tc, tag_number tn)
+{
+  if (from == dead) {
+    return dead;
+  }
+
+  // Look the transition up.
+  const size_t mask = _M_transitionssize - 1;
+
+  for (size_t i = transition_hash(from, tc, tn) & mask;
+       _M_transitions[i].from != empty;
+       i = (i + 1) & mask) {
+    const transition& t = _M_transitions[i];
+
+    if ((t.from == from) && (t.tn == tn) && (t.tc == tc)) {
+      return t.to;
+    }
+  }
+
+  // If no pattern has the tag, the next state only depends on the '*' and
+  // the '**' of the state (it is built once for all these tags).
+  if (!pattern_tag(tc, tn)) {
+    if (_M_states[from].other == empty) {
+      uint32_t to;
+      if ((to = build_next(from, tc, tn, false)) == empty) {
+        return empty;
+      }
+
+      _M_states[from].other = to;
+    }
+
+    return _M_states[from].other;
+  }
+
+  uint32_t to;
+  if (((to = build_next(from, tc, tn, true)) == empty) ||
+      (!add_transition(from, tc, tn, to))) {
+    return empty;
+  }
+
+  return to;
+}
+
+uint32_t asn1::ber::matcher::build_next(uint32_t from,
+                                        tag_class tc,
+                                        tag_number tn,
+                                        bool tags)
+{
+  _M_npositions = 0;
+
+  const size_t positions = _M_states[from].positions;
+  const uint32_t npositions = _M_states[from].npositions;
+
+  for (uint32_t i = 0; i < npositions; i++) {
+    const uint32_t pos = _M_pool[positions + i];
+    const step& s = _M_steps[pos];
+
+    bool ret;
+
+    switch (s.type) {
+      case step_type::Tag:
+        ret = ((!tags) ||
+               (s.tc != tc) ||
+               (s.tn != tn) ||
+               (add_position(pos + 1)));
+
+        break;
+      case step_type::Any:
+        ret = add_position(pos + 1);
+        break;
+      case step_type::AnyPath:
+        ret = add_position(pos);
+        break;
+      default:
+        ret = true;
+    }
+
+    if (!ret) {
+      return empty;
+    }
+  }
+
+  return build_state();
+}
+
+bool asn1::ber::matcher::pattern_tag(tag_class tc, tag_number tn) const
+{
+  const size_t mask = _M_tagtablesize - 1;
+
+  for (size_t i = transition_hash(0, tc, tn) & mask;
+       _M_tagtable[i].type != step_type::Accept;
+       i = (i + 1) & mask) {
+    if ((_M_tagtable[i].tn == tn) && (_M_tagtable[i].tc == tc)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+uint32_t asn1::ber::matcher::build_state()
+{
+  if (_M_npositions == 0) {
+    return dead;
+  }
+
+  // Sort the positions and remove the duplicates.
+  if (_M_npositions > 1) {
+    qsort(_M_positions,
+          _M_npositions,
+          sizeof(uint32_t),
+          [](const void* p1, const void* p2) -> int {
+            const uint32_t n1 = *static_cast<const uint32_t*>(p1);
+            const uint32_t n2 = *static_cast<const uint32_t*>(p2);
+
+            return (n1 < n2) ? -1 : (n1 > n2);
+          });
+
+    size_t n = 1;
+    for (size_t i = 1; i < _M_npositions; i++) {
+      if (_M_positions[i] != _M_positions[n - 1]) {
+        _M_positions[n++] = _M_positions[i];
+      }
+    }
+
+    _M_npositions = n;
+  }
+
+  uint64_t hash = _M_npositions;
+  for (size_t i = 0; i < _M_npositions; i++) {
+    hash = mix(hash ^ _M_positions[i]);
+  }
+
+  // Look the state up.
+  size_t mask = _M_statetablesize - 1;
+  size_t idx;
+
+  for (idx = hash & mask; _M_statetable[idx] != empty; idx = (idx + 1) & mask) {
+    const state& s = _M_states[_M_statetable[idx]];
+
+    if ((s.hash == hash) &&
+        (s.npositions == _M_npositions) &&
+        (memcmp(_M_pool + s.positions,
+                _M_positions,
+                _M_npositions * sizeof(uint32_t)) == 0)) {
+      return _M_statetable[idx];
+    }
+  }
+
+  if (_M_nstates == empty - 1) {
+    return empty;
+  }
+
+  // Count the accepted queries.
+  uint32_t naccepts = 0;
+  uint32_t nexists = 0;
+
+  for (size_t i = 0; i < _M_npositions; i++) {
+    const step& st = _M_steps[_M_positions[i]];
+
+    if (st.type == step_type::Accept) {
+      naccepts++;
+
+      if (_M_queries[st.tn].op == operation::Exists) {
+        nexists++;
+      }
+    }
+  }
+
+  if ((!grow(_M_states, _M_sizestates, _M_nstates + 1)) ||
+      (!grow(_M_pool, _M_sizepool, _M_poollen + _M_npositions + naccepts))) {
+    return empty;
+  }
+
+  state& s = _M_states[_M_nstates];
+
+  s.hash = hash;
+
+  s.positions = _M_poollen;
+  s.npositions = _M_npositions;
+
+  memcpy(_M_pool + _M_poollen,
+         _M_positions,
+         _M_npositions * sizeof(uint32_t));
+
+  _M_poollen += _M_npositions;
+
+  s.accepts = _M_poollen;
+  s.naccepts = naccepts;
+  s.nexists = nexists;
+  s.record = 0;
+  s.other = empty;
+
+  // First the existence queries.
+  size_t exists = _M_poollen;
+  size_t others = _M_poollen + nexists;
+
+  for (size_t i = 0; i < _M_npositions; i++) {
+    const step& st = _M_steps[_M_positions[i]];
+
+    if (st.type == step_type::Accept) {
+      if (_M_queries[st.tn].op == operation::Exists) {
+        _M_pool[exists++] = static_cast<uint32_t>(st.tn);
+      } else {
+        _M_pool[others++] = static_cast<uint32_t>(st.tn);
+      }
+    }
+  }
+
+  _M_poollen = others;
+
+  const uint32_t n = static_cast<uint32_t>(_M_nstates++);
+
+  // Grow the hash table of the states if it is half full.
+  if (_M_nstates * 2 > _M_statetablesize) {
+    uint32_t* table;
+    if ((table = static_cast<uint32_t*>(
+                   malloc(_M_statetablesize * 2 * sizeof(uint32_t))
+                 )) == nullptr) {
+      _M_nstates--;
+      _M_poollen = s.positions;
+
+      return empty;
+    }
+
+    const size_t size = _M_statetablesize * 2;
+    for (size_t i = 0; i < size; i++) {
+      table[i] = empty;
+    }
+
+    mask = size - 1;
+
+    // The dead state is not in the table.
+    for (uint32_t i = 1; i < n; i++) {
+      size_t j;
+      for (j = _M_states[i].hash & mask;
+           table[j] != empty;
+           j = (j + 1) & mask);
+
+      table[j] = i;
+    }
+
+    free(_M_statetable);
+
+    _M_statetable = table;
+    _M_statetablesize = size;
+
+    for (idx = hash & mask; _M_statetable[idx] != empty; idx = (idx + 1) & mask);
+  }
+
+  _M_statetable[idx] = n;
+
+  return n;
+}
+
+bool asn1::ber::matcher::add_position(uint32_t pos)
+{
+  do {
+    if (!grow(_M_positions, _M_sizepositions, _M_npositions + 1)) {
+      return false;
+    }
+
+    _M_positions[_M_npositions++] = pos;
+
+    // A '**' can also match no tags.
+  } while (_M_steps[pos++].type == step_type::AnyPath);
+
+  return true;
+}
+
+bool asn1::ber::matcher::add_transition(uint32_t from,
+                                        tag_class tc,
+                                        tag_number tn,
+                                        uint32_t to)
+{
+  // Grow the hash table of the transitions if it is half full.
+  if ((_M_ntransitions + 1) * 2 > _M_transitionssize) {
+    const size_t size = _M_transitionssize * 2;
+
+    transition* transitions;
+    if ((transitions = static_cast<transition*>(
+                         malloc(size * sizeof(transition))
+                       )) == nullptr) {
+      return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+      transitions[i].from = empty;
+    }
+
+    const size_t mask = size - 1;
+
+    for (size_t i = 0; i < _M_transitionssize; i++) {
+      const transition& t = _M_transitions[i];
+
+      if (t.from != empty) {
+        size_t j;
+        for (j = transition_hash(t.from, t.tc, t.tn) & mask;
+             transitions[j].from != empty;
+             j = (j + 1) & mask);
+
+        transitions[j] = t;
+      }
+    }
+
+    free(_M_transitions);
+
+    _M_transitions = transitions;
+    _M_transitionssize = size;
+  }
+
+  const size_t mask = _M_transitionssize - 1;
+
+  size_t i;
+  for (i = transition_hash(from, tc, tn) & mask;
+       _M_transitions[i].from != empty;
+       i = (i + 1) & mask);
+
+  _M_transitions[i].from = from;
+  _M_transitions[i].tc = tc;
+  _M_transitions[i].tn = tn;
+  _M_transitions[i].to = to;
+
+  _M_ntransitions++;
+
+  return true;
+}
+
+bool asn1::ber::matcher::typed_value(universal_class uc,
+                                     const void* buf,
+                                     uint64_t len,
+                                     bool isint,
+                                     int64_t val)
+{
+  uint32_t s;
+  if ((s = next(_M_stack[_M_depth],
+                tag_class::Universal,
+                static_cast<tag_number>(uc))) == empty) {
+    _M_message = "error allocating memory";
+    return false;
+  }
+
+  if (_M_states[s].naccepts > 0) {
+    evaluate(s, true, buf, len, isint, val);
+  }
+
+  return true;
+}
+
+void asn1::ber::matcher::evaluate(uint32_t s,
+                                  bool contents,
+                                  const void* buf,
+                                  uint64_t len,
+                                  bool isint,
+                                  int64_t val)
+{
+  state& st = _M_states[s];
+
+  const uint32_t* const accepts = _M_pool + st.accepts;
+
+  // The existence queries are matched once per record.
+  if (st.record != _M_record) {
+    for (uint32_t i = 0; i < st.nexists; i++) {
+      match(accepts[i]);
+    }
+
+    st.record = _M_record;
+  }
+
+  for (uint32_t i = st.nexists; i < st.naccepts; i++) {
+    const uint32_t n = accepts[i];
+
+    if (matched(n)) {
+      continue;
+    }
+
+    const query& q = _M_queries[n];
+
+    bool ret;
+
+    if (!contents) {
+      ret = false;
+    } else if (q.integer) {
+      if (isint) {
+        switch (q.op) {
+          case operation::Equal:
+            ret = (val == q.value);
+            break;
+          case operation::NotEqual:
+            ret = (val != q.value);
+            break;
+          case operation::Less:
+            ret = (val < q.value);
+            break;
+          case operation::LessEqual:
+            ret = (val <= q.value);
+            break;
+          case operation::Greater:
+            ret = (val > q.value);
+            break;
+          default:
+            ret = (val >= q.value);
+        }
+      } else {
+        ret = false;
+      }
+    } else {
+      // The values longer than 'max_value_length' are not compared.
+      ret = ((len == q.length) &&
+             (memcmp(buf, _M_literals + q.offset, len) == 0));
+
+      if (q.op == operation::NotEqual) {
+        ret = !ret;
+      }
+    }
+
+    if (ret) {
+      match(n);
+    }
+  }
+}
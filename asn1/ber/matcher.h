@@ -0,0 +1,411 @@
+#ifndef ASN1_BER_MATCHER_H
+#define ASN1_BER_MATCHER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/error.h"
+
+namespace asn1 {
+  namespace ber {
+    // ASN.1 object which evaluates many queries over the values of a record
+    // in a single decoding pass.
+    // Query: <pattern> [<operator> <value>]
+    //   - <pattern>: steps separated by '/'. A step is a tag in the notation
+    //     of asn1::ber::path ("[APPLICATION 1]"), '*' (any tag) or '**'
+    //     (any number of tags, including none):
+    //       [APPLICATION 1]/[3]/[UNIVERSAL 2]
+    //       **/[UNIVERSAL 6]
+    //   - <operator>: ==, !=, <, <=, > or >= (only == and != for strings and
+    //     object identifiers).
+    //   - <value>: integer (compared with the INTEGER, ENUMERATED and BOOLEAN
+    //     values and the primitives of up to 8 octets), string ("abc", with
+    //     \" and \\), hexadecimal string (0x0102) or object identifier
+    //     (1.2.840.113549). The strings and the object identifiers are
+    //     compared with the contents octets.
+    // Without operator, the query matches if the record has a value at the
+    // pattern. A record matches a query if any value at the pattern
+    // satisfies the condition.
+    // The patterns are compiled lazily into a DFA: each state is the set of
+    // the positions of the patterns which can still match the tags of the
+    // constructed values being decoded; the states and the transitions are
+    // built the first time they are needed, so the cost per value is a hash
+    // table lookup regardless of the number of queries.
+    class matcher {
+      public:
+        // Maximum depth of the values.
+        static const size_t max_depth = 64;
+
+        // Maximum length of a string or object identifier of a query.
+        static const size_t max_value_length = 1024;
+
+        // Constructor.
+        matcher() = default;
+
+        // Destructor.
+        ~matcher();
+
+        // Add query.
+        // Returns false if the query is not valid.
+        bool add(const char* query);
+
+        // Get number of queries.
+        size_t size() const
+        {
+          return _M_nqueries;
+        }
+
+        // Get number of states of the DFA built so far.
+        size_t states() const
+        {
+          return _M_nstates;
+        }
+
+        // Begin record.
+        bool begin_record();
+
+        // Get number of queries matched by the record.
+        size_t nmatches() const
+        {
+          return _M_nmatches;
+        }
+
+        // Get queries matched by the record (in the order they matched).
+        const uint32_t* matches() const
+        {
+          return _M_matches;
+        }
+
+        // Has the record matched the query 'q'?
+        bool matched(size_t q) const
+        {
+          return ((_M_matched[q / 64] >> (q % 64)) & 0x01);
+        }
+
+        // Start constructed.
+        bool start_constructed(tag_class tc,
+                               tag_number tn,
+                               uint64_t valuelen,
+                               uint64_t totallen);
+
+        // End constructed.
+        bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+        {
+          _M_depth--;
+          return true;
+        }
+
+        // Boolean.
+        bool boolean(const void* buf, uint64_t len, bool val)
+        {
+          return typed_value(universal_class::Boolean,
+                             buf,
+                             len,
+                             true,
+                             val ? 1 : 0);
+        }
+
+        // Integer.
+        bool integer(const void* buf, uint64_t len, int64_t val)
+        {
+          return typed_value(universal_class::Integer, buf, len, true, val);
+        }
+
+        // Null.
+        bool null()
+        {
+          return typed_value(universal_class::Null, "", 0, false, 0);
+        }
+
+        // Object identifier.
+        bool oid(const void* buf,
+                 uint64_t len,
+                 const uint64_t* oid,
+                 size_t ncomponents)
+        {
+          return typed_value(universal_class::ObjectIdentifier,
+                             buf,
+                             len,
+                             false,
+                             0);
+        }
+
+        // Real.
+        bool real(const void* buf, uint64_t len, double val)
+        {
+          return typed_value(universal_class::Real, buf, len, false, 0);
+        }
+
+        // Enumerated.
+        bool enumerated(const void* buf, uint64_t len, int64_t val)
+        {
+          return typed_value(universal_class::Enumerated, buf, len, true, val);
+        }
+
+        // UTC time.
+        bool utc_time(const void* buf, uint64_t len, time_t val)
+        {
+          return typed_value(universal_class::UTCTime, buf, len, false, 0);
+        }
+
+        // Generalized time.
+        bool generalized_time(const void* buf,
+                              uint64_t len,
+                              const struct timeval& val)
+        {
+          return typed_value(universal_class::GeneralizedTime,
+                             buf,
+                             len,
+                             false,
+                             0);
+        }
+
+        // Primitive.
+        bool primitive(tag_class tc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t valueoff,
+                       uint64_t valuelen);
+
+        // Error.
+        void error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        // Step of a pattern.
+        enum class step_type : uint8_t {
+          Tag,
+          Any,
+          AnyPath,
+
+          // End of the pattern ('tn' is the number of the query).
+          Accept
+        };
+
+        struct step {
+          step_type type;
+          tag_class tc;
+          tag_number tn;
+        };
+
+        enum class operation : uint8_t {
+          Exists,
+          Equal,
+          NotEqual,
+          Less,
+          LessEqual,
+          Greater,
+          GreaterEqual
+        };
+
+        struct query {
+          // First step of the pattern.
+          size_t first;
+
+          operation op;
+
+          // Integer value (the string and object identifier values are
+          // in '_M_literals').
+          bool integer;
+          int64_t value;
+
+          size_t offset;
+          size_t length;
+        };
+
+        // State of the DFA: positions (indices in '_M_steps') and queries
+        // which are accepted (in '_M_pool'; first the queries which only
+        // check the existence of the value).
+        struct state {
+          uint64_t hash;
+
+          size_t positions;
+          uint32_t npositions;
+
+          size_t accepts;
+          uint32_t naccepts;
+          uint32_t nexists;
+
+          // Last record in which the existence queries have been matched.
+          uint64_t record;
+
+          // Next state for the tags which are not in the patterns ('empty'
+          // if it has not been built yet).
+          uint32_t other;
+        };
+
+        struct transition {
+          uint32_t from;
+          tag_class tc;
+          tag_number tn;
+          uint32_t to;
+        };
+
+        // Empty slot of the hash tables.
+        static const uint32_t empty = UINT32_MAX;
+
+        // Dead state (no pattern can match).
+        static const uint32_t dead = 0;
+
+        step* _M_steps = nullptr;
+        size_t _M_nsteps = 0;
+        size_t _M_sizesteps = 0;
+
+        query* _M_queries = nullptr;
+        size_t _M_nqueries = 0;
+        size_t _M_sizequeries = 0;
+
+        uint8_t* _M_literals = nullptr;
+        size_t _M_literalslen = 0;
+        size_t _M_sizeliterals = 0;
+
+        // DFA.
+        state* _M_states = nullptr;
+        size_t _M_nstates = 0;
+        size_t _M_sizestates = 0;
+
+        uint32_t* _M_pool = nullptr;
+        size_t _M_poollen = 0;
+        size_t _M_sizepool = 0;
+
+        // Hash table of the states (indices in '_M_states').
+        uint32_t* _M_statetable = nullptr;
+        size_t _M_statetablesize = 0;
+
+        // Hash table of the transitions.
+        transition* _M_transitions = nullptr;
+        size_t _M_ntransitions = 0;
+        size_t _M_transitionssize = 0;
+
+        // Hash table of the tags of the patterns.
+        step* _M_tagtable = nullptr;
+        size_t _M_tagtablesize = 0;
+
+        // Positions of the state being built.
+        uint32_t* _M_positions = nullptr;
+        size_t _M_npositions = 0;
+        size_t _M_sizepositions = 0;
+
+        // State of each depth.
+        uint32_t _M_stack[max_depth + 2];
+        size_t _M_depth = 0;
+
+        // Number of the current record.
+        uint64_t _M_record = 0;
+
+        // Queries matched by the current record.
+        uint64_t* _M_matched = nullptr;
+        uint32_t* _M_matches = nullptr;
+        size_t _M_nmatches = 0;
+        size_t _M_sizematches = 0;
+
+        // Primitive being received in chunks.
+        uint32_t _M_primitive = dead;
+        bool _M_buffering = false;
+        uint8_t _M_value[max_value_length];
+
+        enum error _M_error = error::callback;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+
+        // Initial state.
+        uint32_t _M_initial = dead;
+
+        // Parse value.
+        bool parse_value(const char* s, query& q);
+
+        // Add step / literal.
+        bool add_step(step_type type, tag_class tc, tag_number tn);
+        bool add_literal(const void* buf, size_t len);
+
+        // Clear the DFA.
+        void clear();
+
+        // Build the dead and the initial states.
+        bool init();
+
+        // Get the state which follows 'from' with the tag 'tc' / 'tn'.
+        uint32_t next(uint32_t from, tag_class tc, tag_number tn);
+
+        // Build the state which follows 'from' with the tag 'tc' / 'tn' (if
+        // 'tags' is false, only the '*' and the '**' of 'from' are followed).
+        uint32_t build_next(uint32_t from,
+                            tag_class tc,
+                            tag_number tn,
+                            bool tags);
+
+        // Is the tag in any pattern?
+        bool pattern_tag(tag_class tc, tag_number tn) const;
+
+        // Build the state with the positions in '_M_positions'.
+        uint32_t build_state();
+
+        // Add the position 'pos' (and the ones which follow a '**') to
+        // '_M_positions'.
+        bool add_position(uint32_t pos);
+
+        // Add transition.
+        bool add_transition(uint32_t from,
+                            tag_class tc,
+                            tag_number tn,
+                            uint32_t to);
+
+        // Value of a universal type.
+        bool typed_value(universal_class uc,
+                         const void* buf,
+                         uint64_t len,
+                         bool isint,
+                         int64_t val);
+
+        // Evaluate the queries accepted by the state 's' with a value
+        // ('contents' is false for the constructed values; 'buf' might be
+        // nullptr if the value is longer than 'max_value_length').
+        void evaluate(uint32_t s,
+                      bool contents,
+                      const void* buf,
+                      uint64_t len,
+                      bool isint,
+                      int64_t val);
+
+        // Mark query as matched.
+        void match(uint32_t q)
+        {
+          if (!matched(q)) {
+            _M_matched[q / 64] |= static_cast<uint64_t>(1) << (q % 64);
+            _M_matches[_M_nmatches++] = q;
+          }
+        }
+
+        // Disable copy constructor and assignment operator.
+        matcher(const matcher&) = delete;
+        matcher& operator=(const matcher&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_MATCHER_H
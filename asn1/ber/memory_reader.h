@@ -0,0 +1,98 @@
+#ifndef ASN1_BER_MEMORY_READER_H
+#define ASN1_BER_MEMORY_READER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace asn1 {
+  namespace ber {
+    // Reader over a memory buffer (the data is not copied).
+    class memory_reader {
+      public:
+        // Constructor.
+        memory_reader(const void* buf, size_t len)
+          : _M_begin(static_cast<const uint8_t*>(buf)),
+            _M_ptr(_M_begin),
+            _M_end(_M_begin + len)
+        {
+        }
+
+        // Destructor.
+        ~memory_reader() = default;
+
+        // Get character.
+        int getc()
+        {
+          // If the end of the buffer has not been reached...
+          if (_M_ptr < _M_end) {
+            return *_M_ptr++;
+          }
+
+          return -1;
+        }
+
+        // Read.
+        int64_t get(const void*& buf, uint64_t len)
+        {
+          uint64_t remaining = _M_end - _M_ptr;
+
+          if (remaining < len) {
+            len = remaining;
+          }
+
+          buf = _M_ptr;
+          _M_ptr += len;
+
+          return len;
+        }
+
+        // End of buffer?
+        bool eof() const
+        {
+          return (_M_ptr == _M_end);
+        }
+
+        // Get offset.
+        size_t offset() const
+        {
+          return _M_ptr - _M_begin;
+        }
+
+        // Set offset.
+        bool seek(size_t off)
+        {
+          if (off <= static_cast<size_t>(_M_end - _M_begin)) {
+            _M_ptr = _M_begin + off;
+            return true;
+          }
+
+          return false;
+        }
+
+        // Get pointer to the next character.
+        const uint8_t* current() const
+        {
+          return _M_ptr;
+        }
+
+        // Get buffer.
+        const uint8_t* data() const
+        {
+          return _M_begin;
+        }
+
+        // Get size of the buffer.
+        size_t size() const
+        {
+          return _M_end - _M_begin;
+        }
+
+      private:
+        const uint8_t* _M_begin;
+        const uint8_t* _M_ptr;
+        const uint8_t* _M_end;
+    };
+  }
+}
+
+#endif // ASN1_BER_MEMORY_READER_H
@@ -0,0 +1,136 @@
+#ifndef ASN1_BER_NULL_OBJECT_H
+#define ASN1_BER_NULL_OBJECT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/error.h"
+
+namespace asn1 {
+  namespace ber {
+    // ASN.1 object which ignores the decoded values and only keeps the last
+    // error.
+    class null_object {
+      public:
+        // Constructor.
+        null_object() = default;
+
+        // Destructor.
+        ~null_object() = default;
+
+        // Start constructed.
+        bool start_constructed(tag_class tc,
+                               tag_number tn,
+                               uint64_t valuelen,
+                               uint64_t totallen)
+        {
+          return true;
+        }
+
+        // End constructed.
+        bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+        {
+          return true;
+        }
+
+        // Boolean.
+        bool boolean(const void* buf, uint64_t len, bool val)
+        {
+          return true;
+        }
+
+        // Integer.
+        bool integer(const void* buf, uint64_t len, int64_t val)
+        {
+          return true;
+        }
+
+        // Null.
+        bool null()
+        {
+          return true;
+        }
+
+        // Object identifier.
+        bool oid(const void* buf,
+                 uint64_t len,
+                 const uint64_t* oid,
+                 size_t ncomponents)
+        {
+          return true;
+        }
+
+        // Real.
+        bool real(const void* buf, uint64_t len, double val)
+        {
+          return true;
+        }
+
+        // Enumerated.
+        bool enumerated(const void* buf, uint64_t len, int64_t val)
+        {
+          return true;
+        }
+
+        // UTC time.
+        bool utc_time(const void* buf, uint64_t len, time_t val)
+        {
+          return true;
+        }
+
+        // Generalized time.
+        bool generalized_time(const void* buf,
+                              uint64_t len,
+                              const struct timeval& val)
+        {
+          return true;
+        }
+
+        // Primitive.
+        bool primitive(tag_class tc,
+                       tag_number tn,
+                       const void* buf,
+                       uint64_t len,
+                       uint64_t valueoff,
+                       uint64_t valuelen)
+        {
+          return true;
+        }
+
+        // Error.
+        void error(enum error e, uint64_t offset, const char* msg = nullptr)
+        {
+          _M_error = e;
+          _M_offset = offset;
+          _M_message = msg;
+        }
+
+        // Get last error.
+        enum error last_error() const
+        {
+          return _M_error;
+        }
+
+        // Get offset of the last error.
+        uint64_t error_offset() const
+        {
+          return _M_offset;
+        }
+
+        // Get message of the last error (might be nullptr).
+        const char* error_message() const
+        {
+          return _M_message;
+        }
+
+      private:
+        enum error _M_error = error::callback;
+        uint64_t _M_offset = 0;
+        const char* _M_message = nullptr;
+    };
+  }
+}
+
+#endif // ASN1_BER_NULL_OBJECT_H
@@ -0,0 +1,109 @@
+#ifndef ASN1_BER_OUTPUT_FILE_H
+#define ASN1_BER_OUTPUT_FILE_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "asn1/ber/mapped_file.h"
+
+namespace asn1 {
+  namespace ber {
+    // Output file of a tool which reads a mapped file. If the output is the
+    // input file, it is written to a temporary file in the same directory
+    // which replaces the input when it is closed (truncating the input
+    // while it is mapped would lose it).
+    class output_file {
+      public:
+        // Constructor.
+        output_file() = default;
+
+        // Destructor.
+        ~output_file()
+        {
+          if (_M_fd != -1) {
+            ::close(_M_fd);
+
+            if (_M_temporary) {
+              unlink(_M_tmpname);
+            }
+          }
+        }
+
+        // Open 'filename' for writing ('input' is the input file).
+        bool open(const char* filename, const mapped_file& input)
+        {
+          if (!input.same_file(filename)) {
+            return ((_M_fd = ::open(filename,
+                                    O_CREAT | O_TRUNC | O_WRONLY,
+                                    0644)) != -1);
+          }
+
+          // (The temporary file replaces the target of a symbolic link.)
+          struct stat sb;
+          if ((realpath(filename, _M_filename) == nullptr) ||
+              (stat(_M_filename, &sb) != 0) ||
+              (static_cast<size_t>(snprintf(_M_tmpname,
+                                            sizeof(_M_tmpname),
+                                            "%s.XXXXXX",
+                                            _M_filename)) >=
+               sizeof(_M_tmpname))) {
+            return false;
+          }
+
+          if ((_M_fd = mkstemp(_M_tmpname)) == -1) {
+            return false;
+          }
+
+          _M_temporary = true;
+
+          // Keep the permissions of the file.
+          fchmod(_M_fd, sb.st_mode & 07777);
+
+          return true;
+        }
+
+        // Get file descriptor.
+        int fd() const
+        {
+          return _M_fd;
+        }
+
+        // Close (the temporary file replaces the input).
+        bool close()
+        {
+          if (_M_fd == -1) {
+            return false;
+          }
+
+          bool ret = (::close(_M_fd) == 0);
+          _M_fd = -1;
+
+          if (_M_temporary) {
+            if ((!ret) || (rename(_M_tmpname, _M_filename) != 0)) {
+              unlink(_M_tmpname);
+              return false;
+            }
+          }
+
+          return ret;
+        }
+
+      private:
+        int _M_fd = -1;
+
+        // Temporary file (the output is the input file)?
+        bool _M_temporary = false;
+        char _M_tmpname[PATH_MAX];
+        char _M_filename[PATH_MAX];
+
+        // Disable copy constructor and assignment operator.
+        output_file(const output_file&) = delete;
+        output_file& operator=(const output_file&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_OUTPUT_FILE_H
@@ -0,0 +1,307 @@
+#include <string.h>
+#include "asn1/ber/patch.h"
+#include "asn1/ber/common.h"
+#include "asn1/ber/grow.h"
+
+// Replacement of 'oldlen' bytes at 'offset' by 'noctets' length octets
+// followed by 'datalen' bytes of 'data'.
+struct splice {
+  size_t offset;
+  size_t oldlen;
+
+  uint8_t octets[9];
+  size_t noctets;
+
+  const uint8_t* data;
+  size_t datalen;
+
+  // Get new length.
+  size_t length() const
+  {
+    return noctets + datalen;
+  }
+};
+
+// Get the offset and the number of the length octets of the value at 'loc'
+// (they follow the identifier octets).
+static void length_octets(const uint8_t* buf,
+                          const asn1::ber::value_location& loc,
+                          size_t& offset,
+                          size_t& noctets)
+{
+  size_t taglen = 1;
+  if ((buf[loc.offset] & 0x1f) == 0x1f) {
+    do {
+      taglen++;
+    } while (buf[loc.offset + taglen - 1] & 0x80);
+  }
+
+  offset = loc.offset + taglen;
+  noctets = loc.h.len - taglen;
+}
+
+// Encode the length 'len' with 'noctets' octets if it fits (to avoid moving
+// the bytes which follow), otherwise with the minimum number of octets.
+static size_t encode_length_in_place(uint64_t len,
+                                     size_t noctets,
+                                     uint8_t* buf)
+{
+  if (noctets == 1) {
+    if (len <= 0x7f) {
+      buf[0] = static_cast<uint8_t>(len);
+      return 1;
+    }
+  } else if ((noctets == 9) || ((len >> ((noctets - 1) << 3)) == 0)) {
+    buf[0] = 0x80 | static_cast<uint8_t>(noctets - 1);
+
+    for (size_t i = noctets - 1; i > 0; i--) {
+      buf[i] = static_cast<uint8_t>(len);
+      len >>= 8;
+    }
+
+    return noctets;
+  }
+
+  return asn1::ber::encode_length_padded(len, buf);
+}
+
+asn1::ber::patch::~patch()
+{
+  if (_M_edits) {
+    free(_M_edits);
+  }
+
+  if (_M_data) {
+    free(_M_data);
+  }
+}
+
+bool asn1::ber::patch::replace(const path& p, const void* value, size_t len)
+{
+  return add(operation::Replace, p, value, len);
+}
+
+bool asn1::ber::patch::remove(const path& p)
+{
+  return add(operation::Remove, p, nullptr, 0);
+}
+
+bool asn1::ber::patch::insert(const path& p, const void* tlv, size_t len)
+{
+  return ((check_header(tlv, len)) && (add(operation::Insert, p, tlv, len)));
+}
+
+size_t asn1::ber::patch::max_growth() const
+{
+  size_t growth = 0;
+
+  for (size_t i = 0; i < _M_nedits; i++) {
+    // The value, its length octets and one more octet for each length of
+    // the ancestors.
+    growth += _M_edits[i].length + 9 + path::max_steps * 8;
+  }
+
+  return growth;
+}
+
+bool asn1::ber::patch::apply(uint8_t* buf,
+                             size_t len,
+                             size_t size,
+                             size_t& newlen,
+                             size_t& napplied) const
+{
+  napplied = 0;
+
+  for (size_t i = 0; i < _M_nedits; i++) {
+    switch (apply(_M_edits[i], buf, len, size)) {
+      case -1:
+        newlen = len;
+        return false;
+      case 1:
+        napplied++;
+        break;
+    }
+  }
+
+  newlen = len;
+
+  return true;
+}
+
+bool asn1::ber::patch::add(operation op,
+                           const path& p,
+                           const void* buf,
+                           size_t len)
+{
+  if ((p.size() == 0) ||
+      (!grow(_M_edits, _M_sizeedits, _M_nedits + 1)) ||
+      (!grow(_M_data, _M_sizedata, _M_datalen + len))) {
+    return false;
+  }
+
+  edit* e = _M_edits + _M_nedits++;
+
+  e->op = op;
+  e->p = p;
+  e->offset = _M_datalen;
+  e->length = len;
+
+  if (len > 0) {
+    memcpy(_M_data + _M_datalen, buf, len);
+    _M_datalen += len;
+  }
+
+  return true;
+}
+
+int asn1::ber::patch::apply(const edit& e,
+                            uint8_t* buf,
+                            size_t& len,
+                            size_t size) const
+{
+  value_location ancestors[path::max_steps + 1];
+  size_t nancestors;
+  value_location loc;
+
+  if (!find(buf, len, e.p, ancestors, nancestors, loc)) {
+    return 0;
+  }
+
+  // The length octets of the ancestors and the edit (in ascending order of
+  // offset).
+  splice splices[path::max_steps + 2];
+
+  splice s;
+  s.noctets = 0;
+  s.data = _M_data + e.offset;
+  s.datalen = e.length;
+
+  switch (e.op) {
+    case operation::Replace:
+      if (loc.h.pc != primitive_constructed::Primitive) {
+        return 0;
+      }
+
+      // Length and contents.
+      {
+        size_t lengthlen;
+        length_octets(buf, loc, s.offset, lengthlen);
+
+        s.oldlen = lengthlen + loc.h.valuelen;
+        s.noctets = encode_length_in_place(e.length, lengthlen, s.octets);
+      }
+
+      break;
+    case operation::Remove:
+      s.offset = loc.offset;
+      s.oldlen = loc.tlvlen;
+
+      break;
+    case operation::Insert:
+      if (loc.h.pc != primitive_constructed::Constructed) {
+        return 0;
+      }
+
+      // After the last value.
+      s.offset = loc.h.indefinite ?
+                   loc.offset + loc.tlvlen - 2 :
+                   loc.offset + loc.tlvlen;
+
+      s.oldlen = 0;
+
+      // The constructed value is one more ancestor.
+      ancestors[nancestors++] = loc;
+
+      break;
+  }
+
+  splices[nancestors] = s;
+
+  const size_t nsplices = nancestors + 1;
+
+  // Increment of the length of the values, from the innermost ancestor.
+  ssize_t delta = static_cast<ssize_t>(splices[nancestors].length()) -
+                  static_cast<ssize_t>(splices[nancestors].oldlen);
+
+  for (size_t i = nancestors; i > 0; i--) {
+    const value_location& a = ancestors[i - 1];
+    splice& sp = splices[i - 1];
+
+    length_octets(buf, a, sp.offset, sp.oldlen);
+
+    sp.data = nullptr;
+    sp.datalen = 0;
+
+    if (!a.h.indefinite) {
+      sp.noctets = encode_length_in_place(a.h.valuelen + delta,
+                                          sp.oldlen,
+                                          sp.octets);
+      delta += static_cast<ssize_t>(sp.noctets) -
+               static_cast<ssize_t>(sp.oldlen);
+    } else {
+      // The length octet is kept.
+      sp.octets[0] = 0x80;
+      sp.noctets = 1;
+    }
+  }
+
+  if (static_cast<ssize_t>(size - len) < delta) {
+    return -1;
+  }
+
+  // The lengths keep their number of octets when the record shrinks, so
+  // either all the splices grow or none does: when the record grows, the
+  // bytes are moved from the end, otherwise from the beginning, and each
+  // byte is moved once.
+  if (delta > 0) {
+    ssize_t shift = delta;
+
+    for (size_t i = nsplices; i > 0; i--) {
+      const splice& sp = splices[i - 1];
+
+      size_t from = sp.offset + sp.oldlen;
+      size_t to = (i < nsplices) ? splices[i].offset : len;
+
+      shift -= static_cast<ssize_t>(sp.length()) -
+               static_cast<ssize_t>(sp.oldlen);
+
+      size_t dest = sp.offset + shift + sp.length();
+
+      if ((dest != from) && (to > from)) {
+        memmove(buf + dest, buf + from, to - from);
+      }
+
+      memcpy(buf + sp.offset + shift, sp.octets, sp.noctets);
+
+      if (sp.datalen > 0) {
+        memcpy(buf + sp.offset + shift + sp.noctets, sp.data, sp.datalen);
+      }
+    }
+  } else {
+    ssize_t shift = 0;
+
+    for (size_t i = 0; i < nsplices; i++) {
+      const splice& sp = splices[i];
+
+      memcpy(buf + sp.offset + shift, sp.octets, sp.noctets);
+
+      if (sp.datalen > 0) {
+        memcpy(buf + sp.offset + shift + sp.noctets, sp.data, sp.datalen);
+      }
+
+      size_t from = sp.offset + sp.oldlen;
+      size_t to = (i + 1 < nsplices) ? splices[i + 1].offset : len;
+
+      shift += static_cast<ssize_t>(sp.length()) -
+               static_cast<ssize_t>(sp.oldlen);
+
+      if ((shift != 0) && (to > from)) {
+        memmove(buf + from + shift, buf + from, to - from);
+      }
+    }
+  }
+
+  len += delta;
+
+  return 1;
+}
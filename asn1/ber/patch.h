@@ -0,0 +1,110 @@
+#ifndef ASN1_BER_PATCH_H
+#define ASN1_BER_PATCH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "asn1/ber/path.h"
+
+namespace asn1 {
+  namespace ber {
+    // List of edits applied to encoded records without decoding and
+    // re-encoding them:
+    //   - replace(): replace the contents of the primitive value at a path.
+    //   - remove(): remove the value at a path.
+    //   - insert(): insert an encoded value (header + contents) as the last
+    //     value of the constructed value at a path.
+    // The path is the one of asn1::ber::find() (the first value which
+    // matches each step). Only the edited value and the length octets of its
+    // ancestors are rewritten. The lengths keep their number of octets
+    // whenever the new length fits (the bytes which follow are only shifted
+    // when the number of octets of a length grows), and the bytes which
+    // follow an edit are moved only once per edit.
+    class patch {
+      public:
+        // Constructor.
+        patch() = default;
+
+        // Destructor.
+        ~patch();
+
+        // Add replacement of the contents of the primitive value at 'p'.
+        bool replace(const path& p, const void* value, size_t len);
+
+        // Add removal of the value at 'p'.
+        bool remove(const path& p);
+
+        // Add insertion of the encoded value 'tlv' as the last value of the
+        // constructed value at 'p'.
+        // Returns false if the header of 'tlv' is not valid or its length is
+        // not 'len'.
+        bool insert(const path& p, const void* tlv, size_t len);
+
+        // Get number of edits.
+        size_t size() const
+        {
+          return _M_nedits;
+        }
+
+        // Remove the edits.
+        void clear()
+        {
+          _M_nedits = 0;
+          _M_datalen = 0;
+        }
+
+        // Get the maximum number of bytes a record can grow.
+        size_t max_growth() const;
+
+        // Apply the edits (in the order they were added) to the record of
+        // 'len' bytes at 'buf', which has space for 'size' bytes.
+        // The edits whose value is not found (or whose path goes through
+        // invalid headers) are skipped; 'napplied' is the number of edits
+        // applied.
+        // Returns false if there is not enough space (the previous edits
+        // have already been applied).
+        bool apply(uint8_t* buf,
+                   size_t len,
+                   size_t size,
+                   size_t& newlen,
+                   size_t& napplied) const;
+
+      private:
+        enum class operation {
+          Replace,
+          Remove,
+          Insert
+        };
+
+        struct edit {
+          operation op;
+          path p;
+
+          // Value (in '_M_data').
+          size_t offset;
+          size_t length;
+        };
+
+        edit* _M_edits = nullptr;
+        size_t _M_nedits = 0;
+        size_t _M_sizeedits = 0;
+
+        uint8_t* _M_data = nullptr;
+        size_t _M_datalen = 0;
+        size_t _M_sizedata = 0;
+
+        // Add edit.
+        bool add(operation op, const path& p, const void* buf, size_t len);
+
+        // Apply edit.
+        // Returns -1 if there is not enough space, 0 if the value has not
+        // been found and 1 if the edit has been applied.
+        int apply(const edit& e, uint8_t* buf, size_t& len, size_t size) const;
+
+        // Disable copy constructor and assignment operator.
+        patch(const patch&) = delete;
+        patch& operator=(const patch&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_PATCH_H
@@ -0,0 +1,224 @@
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include "asn1/ber/path.h"
+#include "asn1/ber/common.h"
+
+#define IS_DIGIT(x) (((x) >= '0') && ((x) <= '9'))
+
+const char* asn1::ber::path::parse_step(const char* s, path_step& step)
+{
+  static const struct {
+    const char* name;
+    size_t len;
+    tag_class tc;
+  } classes[] = {
+    {"UNIVERSAL", 9, tag_class::Universal},
+    {"APPLICATION", 11, tag_class::Application},
+    {"PRIVATE", 7, tag_class::Private}
+  };
+
+  if (*s++ != '[') {
+    return nullptr;
+  }
+
+  step.tc = tag_class::ContextSpecific;
+
+  for (size_t i = 0; i < sizeof(classes) / sizeof(classes[0]); i++) {
+    if (strncasecmp(s, classes[i].name, classes[i].len) == 0) {
+      s += classes[i].len;
+
+      // Skip spaces.
+      if (*s != ' ') {
+        return nullptr;
+      }
+
+      do {
+        s++;
+      } while (*s == ' ');
+
+      step.tc = classes[i].tc;
+
+      break;
+    }
+  }
+
+  if (!IS_DIGIT(*s)) {
+    return nullptr;
+  }
+
+  uint64_t tn = 0;
+
+  do {
+    uint64_t n = (tn * 10) + (*s - '0');
+
+    // Overflow?
+    if (n / 10 != tn) {
+      return nullptr;
+    }
+
+    tn = n;
+
+    s++;
+  } while (IS_DIGIT(*s));
+
+  if (*s != ']') {
+    return nullptr;
+  }
+
+  // The universal class only has tag numbers up to 30.
+  if ((step.tc == tag_class::Universal) && (tn > 30)) {
+    return nullptr;
+  }
+
+  step.tn = tn;
+
+  return s + 1;
+}
+
+bool asn1::ber::path::parse(const char* s)
+{
+  _M_nsteps = 0;
+
+  do {
+    if (_M_nsteps == max_steps) {
+      return false;
+    }
+
+    if ((s = parse_step(s, _M_steps[_M_nsteps])) == nullptr) {
+      return false;
+    }
+
+    _M_nsteps++;
+
+    if (!*s) {
+      return true;
+    }
+  } while (*s++ == '/');
+
+  return false;
+}
+
+size_t asn1::ber::path::print(char* buf, size_t size) const
+{
+  size_t len = 0;
+
+  for (size_t i = 0; i < _M_nsteps; i++) {
+    const char* cls;
+    switch (_M_steps[i].tc) {
+      case tag_class::Universal:
+        cls = "UNIVERSAL ";
+        break;
+      case tag_class::Application:
+        cls = "APPLICATION ";
+        break;
+      case tag_class::Private:
+        cls = "PRIVATE ";
+        break;
+      default:
+        cls = "";
+    }
+
+    int n = snprintf((len < size) ? buf + len : nullptr,
+                     (len < size) ? size - len : 0,
+                     "%s[%s%llu]",
+                     (i > 0) ? "/" : "",
+                     cls,
+                     static_cast<unsigned long long>(_M_steps[i].tn));
+
+    if (n > 0) {
+      len += n;
+    }
+  }
+
+  if ((_M_nsteps == 0) && (size > 0)) {
+    *buf = 0;
+  }
+
+  return len;
+}
+
+bool asn1::ber::find(const void* buf,
+                     size_t len,
+                     const path& p,
+                     value_location* ancestors,
+                     size_t& nancestors,
+                     value_location& loc)
+{
+  const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+  size_t off = 0;
+  size_t end = len;
+
+  nancestors = 0;
+
+  for (size_t i = 0; i < p.size(); i++) {
+    header& h = loc.h;
+
+    // Search the step among the values of [off, end).
+    do {
+      if ((off == end) || (!decode_header(b + off, end - off, h))) {
+        return false;
+      }
+
+      if (h.indefinite) {
+        if ((loc.tlvlen = tlv_length(b + off, end - off)) == 0) {
+          return false;
+        }
+      } else if (h.valuelen <= end - off - h.len) {
+        loc.tlvlen = h.len + h.valuelen;
+      } else {
+        return false;
+      }
+
+      if ((h.tc == p[i].tc) && (h.tn == p[i].tn)) {
+        break;
+      }
+
+      off += loc.tlvlen;
+    } while (true);
+
+    loc.offset = off;
+
+    // Last step?
+    if (i + 1 == p.size()) {
+      return true;
+    }
+
+    if (h.pc != primitive_constructed::Constructed) {
+      return false;
+    }
+
+    if (ancestors) {
+      ancestors[nancestors] = loc;
+    }
+
+    nancestors++;
+
+    // Values of the constructed value (without the end-of-contents).
+    end = h.indefinite ? off + loc.tlvlen - 2 : off + h.len + h.valuelen;
+    off += h.len;
+  }
+
+  return false;
+}
+
+bool asn1::ber::find(const void* buf,
+                     size_t len,
+                     const path& p,
+                     const uint8_t*& value,
+                     uint64_t& valuelen)
+{
+  value_location loc;
+  size_t nancestors;
+
+  if ((!find(buf, len, p, nullptr, nancestors, loc)) ||
+      (loc.h.pc != primitive_constructed::Primitive)) {
+    return false;
+  }
+
+  value = static_cast<const uint8_t*>(buf) + loc.offset + loc.h.len;
+  valuelen = loc.h.valuelen;
+
+  return true;
+}
@@ -0,0 +1,125 @@
+#ifndef ASN1_BER_PATH_H
+#define ASN1_BER_PATH_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "asn1/ber/tag.h"
+#include "asn1/ber/common.h"
+
+namespace asn1 {
+  namespace ber {
+    // Tag of a value of a path.
+    struct path_step {
+      tag_class tc;
+      tag_number tn;
+
+      bool operator==(const path_step& other) const
+      {
+        return ((tc == other.tc) && (tn == other.tn));
+      }
+
+      bool operator!=(const path_step& other) const
+      {
+        return !(*this == other);
+      }
+    };
+
+    // Path of tags from the top-level value of a record to a value, in the
+    // ASN.1 notation and separated by '/':
+    //   [APPLICATION 1]/[3]/[UNIVERSAL 2]
+    // (the tag class is one of UNIVERSAL, APPLICATION or PRIVATE, or none for
+    // context-specific tags).
+    class path {
+      public:
+        // Maximum number of steps.
+        static const size_t max_steps = 16;
+
+        // Constructor.
+        path() = default;
+
+        // Destructor.
+        ~path() = default;
+
+        // Parse path.
+        // Returns false if the path is not valid.
+        bool parse(const char* s);
+
+        // Parse step ("[APPLICATION 1]").
+        // Returns a pointer to the character which follows the step or
+        // nullptr if the step is not valid.
+        static const char* parse_step(const char* s, path_step& step);
+
+        // Get number of steps.
+        size_t size() const
+        {
+          return _M_nsteps;
+        }
+
+        // Get step.
+        const path_step& operator[](size_t idx) const
+        {
+          return _M_steps[idx];
+        }
+
+        // Add step.
+        bool push_back(tag_class tc, tag_number tn)
+        {
+          if (_M_nsteps < max_steps) {
+            _M_steps[_M_nsteps].tc = tc;
+            _M_steps[_M_nsteps].tn = tn;
+
+            _M_nsteps++;
+
+            return true;
+          }
+
+          return false;
+        }
+
+        // Print path into 'buf'.
+        // Returns the length of the path (it has been truncated if it is
+        // >= 'size').
+        size_t print(char* buf, size_t size) const;
+
+      private:
+        path_step _M_steps[max_steps];
+        size_t _M_nsteps = 0;
+    };
+
+    // Location of a value in an encoded value.
+    struct value_location {
+      // Offset of the identifier octets.
+      size_t offset;
+
+      // Identifier and length octets.
+      header h;
+
+      // Total length (TLV).
+      uint64_t tlvlen;
+    };
+
+    // Find the first value at the path 'p' in the encoded value of 'len'
+    // bytes at 'buf', walking the headers (the values which are not in the
+    // path are skipped without being decoded).
+    // 'loc' receives the location of the value (primitive or constructed)
+    // and, if 'ancestors' is not nullptr, 'ancestors' receives the location
+    // of the constructed values which contain it, from the top-level value
+    // ('nancestors' = p.size() - 1).
+    bool find(const void* buf,
+              size_t len,
+              const path& p,
+              value_location* ancestors,
+              size_t& nancestors,
+              value_location& loc);
+
+    // Find the first value at the path 'p' (see above).
+    // The value has to be primitive; 'value' / 'valuelen' are its contents.
+    bool find(const void* buf,
+              size_t len,
+              const path& p,
+              const uint8_t*& value,
+              uint64_t& valuelen);
+  }
+}
+
+#endif // ASN1_BER_PATH_H
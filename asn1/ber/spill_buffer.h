@@ -0,0 +1,288 @@
+#ifndef ASN1_BER_SPILL_BUFFER_H
+#define ASN1_BER_SPILL_BUFFER_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+namespace asn1 {
+  namespace ber {
+    // Buffer which is kept in memory up to a limit and spills to a temporary
+    // file when it grows bigger (the memory is then used to batch the
+    // writes to the file).
+    class spill_buffer {
+      public:
+        // Default memory limit.
+        static const size_t default_memory = 16 * 1024 * 1024;
+
+        // Constructor.
+        spill_buffer() = default;
+
+        // Destructor.
+        ~spill_buffer()
+        {
+          unmap();
+
+          free(_M_buf);
+
+          if (_M_fd != -1) {
+            close(_M_fd);
+          }
+        }
+
+        // Set memory limit and directory of the temporary file (nullptr:
+        // $TMPDIR or /tmp).
+        void configure(size_t memory, const char* dir)
+        {
+          _M_memory = memory;
+          _M_dir = dir;
+        }
+
+        // Append.
+        bool write(const void* buf, size_t len);
+
+        // Overwrite 'len' bytes at 'offset' (which have already been
+        // written).
+        bool overwrite(uint64_t offset, const void* buf, size_t len);
+
+        // Get size.
+        uint64_t size() const
+        {
+          return _M_flushed + _M_used;
+        }
+
+        // Get the contents (in memory or the temporary file mapped into
+        // memory). The buffer cannot be written until it is cleared.
+        bool data(const uint8_t*& ptr);
+
+        // Clear (the memory and the temporary file are reused).
+        void clear()
+        {
+          unmap();
+
+          _M_flushed = 0;
+          _M_used = 0;
+        }
+
+        // Get number of bytes written to the temporary file so far.
+        uint64_t spilled() const
+        {
+          return _M_spilled;
+        }
+
+      private:
+        // Memory.
+        uint8_t* _M_buf = nullptr;
+        size_t _M_size = 0;
+        size_t _M_used = 0;
+
+        size_t _M_memory = default_memory;
+
+        // Temporary file.
+        const char* _M_dir = nullptr;
+        int _M_fd = -1;
+
+        // Number of bytes in the temporary file.
+        uint64_t _M_flushed = 0;
+
+        uint64_t _M_spilled = 0;
+
+        // Temporary file mapped into memory.
+        void* _M_map = MAP_FAILED;
+        size_t _M_mapsize = 0;
+
+        // Write the memory to the temporary file (creating it).
+        bool flush();
+
+        // Write at 'offset' of the temporary file.
+        bool write_file(uint64_t offset, const void* buf, size_t len);
+
+        // Unmap the temporary file.
+        void unmap()
+        {
+          if (_M_map != MAP_FAILED) {
+            munmap(_M_map, _M_mapsize);
+            _M_map = MAP_FAILED;
+          }
+        }
+
+        // Disable copy constructor and assignment operator.
+        spill_buffer(const spill_buffer&) = delete;
+        spill_buffer& operator=(const spill_buffer&) = delete;
+    };
+
+    inline bool spill_buffer::write(const void* buf, size_t len)
+    {
+      if (_M_used + len > _M_size) {
+        // If the memory limit would be exceeded...
+        if (_M_used + len > _M_memory) {
+          if (!flush()) {
+            return false;
+          }
+
+          // If the data doesn't fit in the memory...
+          if (len >= _M_memory) {
+            if (!write_file(_M_flushed, buf, len)) {
+              return false;
+            }
+
+            _M_flushed += len;
+
+            return true;
+          }
+        }
+
+        if (_M_used + len > _M_size) {
+          size_t size = (_M_size > 0) ? _M_size : 4096;
+          while (size < _M_used + len) {
+            size *= 2;
+          }
+
+          if (size > _M_memory) {
+            size = _M_memory;
+          }
+
+          uint8_t* b;
+          if ((b = static_cast<uint8_t*>(realloc(_M_buf, size))) == nullptr) {
+            return false;
+          }
+
+          _M_buf = b;
+          _M_size = size;
+        }
+      }
+
+      memcpy(_M_buf + _M_used, buf, len);
+      _M_used += len;
+
+      return true;
+    }
+
+    inline bool spill_buffer::overwrite(uint64_t offset,
+                                        const void* buf,
+                                        size_t len)
+    {
+      const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+      // Part in the temporary file.
+      if (offset < _M_flushed) {
+        size_t l = (offset + len <= _M_flushed) ? len : _M_flushed - offset;
+
+        if (!write_file(offset, b, l)) {
+          return false;
+        }
+
+        offset += l;
+        b += l;
+        len -= l;
+      }
+
+      // Part in memory.
+      if (len > 0) {
+        memcpy(_M_buf + (offset - _M_flushed), b, len);
+      }
+
+      return true;
+    }
+
+    inline bool spill_buffer::data(const uint8_t*& ptr)
+    {
+      if (_M_fd == -1) {
+        ptr = _M_buf;
+        return true;
+      }
+
+      if (!flush()) {
+        return false;
+      }
+
+      if (_M_flushed == 0) {
+        ptr = _M_buf;
+        return true;
+      }
+
+      unmap();
+
+      if ((_M_map = mmap(nullptr,
+                         _M_flushed,
+                         PROT_READ,
+                         MAP_SHARED,
+                         _M_fd,
+                         0)) != MAP_FAILED) {
+        _M_mapsize = _M_flushed;
+
+        ptr = static_cast<const uint8_t*>(_M_map);
+        return true;
+      }
+
+      return false;
+    }
+
+    inline bool spill_buffer::flush()
+    {
+      if (_M_fd == -1) {
+        const char* dir = _M_dir;
+        if ((!dir) && ((dir = getenv("TMPDIR")) == nullptr)) {
+          dir = "/tmp";
+        }
+
+        char filename[PATH_MAX];
+        if (static_cast<size_t>(snprintf(filename,
+                                         sizeof(filename),
+                                         "%s/ber.XXXXXX",
+                                         dir)) >= sizeof(filename)) {
+          return false;
+        }
+
+        if ((_M_fd = mkstemp(filename)) == -1) {
+          return false;
+        }
+
+        // The file is removed when it is closed.
+        unlink(filename);
+      }
+
+      if (_M_used > 0) {
+        if (!write_file(_M_flushed, _M_buf, _M_used)) {
+          return false;
+        }
+
+        _M_flushed += _M_used;
+        _M_used = 0;
+      }
+
+      return true;
+    }
+
+    inline bool spill_buffer::write_file(uint64_t offset,
+                                         const void* buf,
+                                         size_t len)
+    {
+      const uint8_t* b = static_cast<const uint8_t*>(buf);
+
+      while (len > 0) {
+        ssize_t ret;
+        if ((ret = pwrite(_M_fd, b, len, offset)) > 0) {
+          b += ret;
+          len -= ret;
+          offset += ret;
+
+          _M_spilled += ret;
+        } else if ((ret < 0) && (errno == EINTR)) {
+          continue;
+        } else {
+          return false;
+        }
+      }
+
+      return true;
+    }
+  }
+}
+
+#endif // ASN1_BER_SPILL_BUFFER_H
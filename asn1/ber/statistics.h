@@ -0,0 +1,186 @@
+#ifndef ASN1_BER_STATISTICS_H
+#define ASN1_BER_STATISTICS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+#include "asn1/ber/tag.h"
+
+// The statistics are only collected when ASN1_BER_STATISTICS is defined,
+// otherwise ASN1_BER_STATS() and ASN1_BER_STATS_CLOCK() (which declares a
+// constant with the current time) expand to nothing.
+#ifdef ASN1_BER_STATISTICS
+  #define ASN1_BER_STATS(statement) do { statement; } while (0)
+  #define ASN1_BER_STATS_CLOCK(name)                                          \
+    const uint64_t name = asn1::ber::statistics_clock()
+#else
+  #define ASN1_BER_STATS(statement) do {} while (0)
+  #define ASN1_BER_STATS_CLOCK(name)
+#endif
+
+namespace asn1 {
+  namespace ber {
+    struct decoder_statistics {
+      enum class typed_decoder {
+        Oid,
+        Real,
+        UTCTime,
+        GeneralizedTime
+      };
+
+      static const size_t number_tag_classes = 4;
+      static const size_t number_universal_classes = 31;
+      static const size_t number_typed_decoders = 4;
+
+      // Number of values and bytes (TLV) per tag class.
+      uint64_t values[number_tag_classes];
+      uint64_t bytes[number_tag_classes];
+
+      // Number of values and bytes (TLV) per universal class.
+      uint64_t universal_values[number_universal_classes];
+      uint64_t universal_bytes[number_universal_classes];
+
+      // Maximum depth reached.
+      uint64_t max_depth;
+
+      // Calls and time (nanoseconds) spent in the typed decoders.
+      uint64_t typed_decoder_calls[number_typed_decoders];
+      uint64_t typed_decoder_time[number_typed_decoders];
+
+      // Number of calls to 'primitive()'.
+      uint64_t primitive_deliveries;
+
+      // Number of times data has been copied to the coalescing buffer.
+      uint64_t coalesced;
+
+      // Clear.
+      void clear()
+      {
+        *this = decoder_statistics();
+      }
+
+      // Count value.
+      void count(tag_class tc, tag_number tn, uint64_t totallen)
+      {
+        values[static_cast<uint8_t>(tc)]++;
+        bytes[static_cast<uint8_t>(tc)] += totallen;
+
+        if (tc == tag_class::Universal) {
+          universal_values[tn]++;
+          universal_bytes[tn] += totallen;
+        }
+      }
+
+      // Update maximum depth.
+      void depth(uint64_t d)
+      {
+        if (d > max_depth) {
+          max_depth = d;
+        }
+      }
+
+      // Count call to a typed decoder which started at 'start'.
+      void typed(typed_decoder d, uint64_t start);
+
+      // Print.
+      void print(FILE* file) const;
+    };
+
+    struct encoder_statistics {
+      // Number of values created.
+      uint64_t values;
+
+      // Number of bytes deep-copied.
+      uint64_t deep_copy_bytes;
+
+      // Number of reallocations of the dynamic values.
+      uint64_t reallocations;
+
+      // Clear.
+      void clear()
+      {
+        *this = encoder_statistics();
+      }
+
+      // Print.
+      void print(FILE* file) const
+      {
+        fprintf(file,
+                "Encoder: values: %llu, deep-copied bytes: %llu, "
+                "reallocations: %llu\n",
+                static_cast<unsigned long long>(values),
+                static_cast<unsigned long long>(deep_copy_bytes),
+                static_cast<unsigned long long>(reallocations));
+      }
+    };
+
+    // Get monotonic time in nanoseconds.
+    static inline uint64_t statistics_clock()
+    {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+
+      return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ull) + ts.tv_nsec;
+    }
+
+    inline void decoder_statistics::typed(typed_decoder d, uint64_t start)
+    {
+      typed_decoder_calls[static_cast<size_t>(d)]++;
+      typed_decoder_time[static_cast<size_t>(d)] += statistics_clock() - start;
+    }
+
+    inline void decoder_statistics::print(FILE* file) const
+    {
+      static const char* const typed_decoders[number_typed_decoders] = {
+        "decode_oid",
+        "decode_real",
+        "decode_utc_time",
+        "decode_generalized_time"
+      };
+
+      fprintf(file, "Decoder:\n");
+
+      for (size_t i = 0; i < number_tag_classes; i++) {
+        if (values[i] > 0) {
+          fprintf(file,
+                  "  %-24s values: %12llu, bytes: %14llu\n",
+                  to_string(static_cast<tag_class>(i)),
+                  static_cast<unsigned long long>(values[i]),
+                  static_cast<unsigned long long>(bytes[i]));
+        }
+      }
+
+      for (size_t i = 0; i < number_universal_classes; i++) {
+        if (universal_values[i] > 0) {
+          fprintf(file,
+                  "    %-22s values: %12llu, bytes: %14llu\n",
+                  to_string(static_cast<universal_class>(i)),
+                  static_cast<unsigned long long>(universal_values[i]),
+                  static_cast<unsigned long long>(universal_bytes[i]));
+        }
+      }
+
+      fprintf(file,
+              "  Maximum depth: %llu\n",
+              static_cast<unsigned long long>(max_depth));
+
+      for (size_t i = 0; i < number_typed_decoders; i++) {
+        if (typed_decoder_calls[i] > 0) {
+          fprintf(file,
+                  "  %-24s calls: %12llu, time: %14llu ns\n",
+                  typed_decoders[i],
+                  static_cast<unsigned long long>(typed_decoder_calls[i]),
+                  static_cast<unsigned long long>(typed_decoder_time[i]));
+        }
+      }
+
+      fprintf(file,
+              "  primitive() deliveries: %llu\n"
+              "  Coalesced copies: %llu\n",
+              static_cast<unsigned long long>(primitive_deliveries),
+              static_cast<unsigned long long>(coalesced));
+    }
+  }
+}
+
+#endif // ASN1_BER_STATISTICS_H
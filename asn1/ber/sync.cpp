@@ -0,0 +1,165 @@
+#include <string.h>
+#include "asn1/ber/sync.h"
+
+// Maximum depth of the nested values whose headers are checked.
+static const unsigned max_depth = 32;
+
+// Check the headers of the values nested in the 'len' bytes at 'buf'.
+static bool check_nested(const uint8_t* buf, uint64_t len, unsigned depth)
+{
+  uint64_t off = 0;
+
+  while (off < len) {
+    asn1::ber::header h;
+    if (!asn1::ber::decode_header(buf + off, len - off, h)) {
+      return false;
+    }
+
+    if (h.indefinite) {
+      // The headers of the values with indefinite length are walked by
+      // tlv_length().
+      uint64_t l;
+      if ((l = asn1::ber::tlv_length(buf + off, len - off)) == 0) {
+        return false;
+      }
+
+      off += l;
+    } else {
+      // End-of-contents out of a value with indefinite length?
+      if ((h.tc == asn1::ber::tag_class::Universal) && (h.tn == 0)) {
+        return false;
+      }
+
+      off += h.len;
+
+      if (h.valuelen > len - off) {
+        return false;
+      }
+
+      if ((h.pc == asn1::ber::primitive_constructed::Constructed) &&
+          (depth < max_depth) &&
+          (!check_nested(buf + off, h.valuelen, depth + 1))) {
+        return false;
+      }
+
+      off += h.valuelen;
+    }
+  }
+
+  return true;
+}
+
+asn1::ber::synchronizer::synchronizer(const void* data,
+                                      size_t size,
+                                      unsigned confirmations)
+  : _M_data(static_cast<const uint8_t*>(data)),
+    _M_size(size),
+    _M_confirmations(confirmations)
+{
+  _M_valid = ((size > 0) && (decode_header(data, size, _M_header)));
+}
+
+bool asn1::ber::synchronizer::plausible(size_t offset, uint64_t& length) const
+{
+  if (!check(offset, length)) {
+    return false;
+  }
+
+  // Check the next records.
+  size_t off = offset + length;
+
+  for (unsigned i = 0; (i < _M_confirmations) && (off < _M_size); i++) {
+    uint64_t len;
+    if (!check(off, len)) {
+      return false;
+    }
+
+    off += len;
+  }
+
+  return true;
+}
+
+bool asn1::ber::synchronizer::next(size_t from,
+                                   size_t to,
+                                   size_t& offset,
+                                   uint64_t& length) const
+{
+  if (!_M_valid) {
+    return false;
+  }
+
+  if (to > _M_size) {
+    to = _M_size;
+  }
+
+  // The records start with the first octet of the tag of the first record.
+  const uint8_t identifier = *_M_data;
+
+  while (from < to) {
+    const uint8_t* ptr;
+    if ((ptr = static_cast<const uint8_t*>(
+                 memchr(_M_data + from, identifier, to - from)
+               )) == nullptr) {
+      return false;
+    }
+
+    size_t off = ptr - _M_data;
+
+    if (plausible(off, length)) {
+      // Take the innermost record.
+      header h;
+      uint64_t len;
+      while ((decode_header(_M_data + off, _M_size - off, h)) &&
+             (h.pc == primitive_constructed::Constructed) &&
+             (h.len < length) &&
+             (plausible(off + h.len, len))) {
+        off += h.len;
+        length = len;
+      }
+
+      offset = off;
+      return true;
+    }
+
+    from = off + 1;
+  }
+
+  return false;
+}
+
+bool asn1::ber::synchronizer::check(size_t offset, uint64_t& length) const
+{
+  header h;
+  if (!decode_record_header(offset, h, length)) {
+    return false;
+  }
+
+  return ((h.indefinite) ||
+          (h.pc == primitive_constructed::Primitive) ||
+          (check_nested(_M_data + offset + h.len, h.valuelen, 1)));
+}
+
+bool asn1::ber::synchronizer::starts(size_t offset, uint64_t& length) const
+{
+  header h;
+  return decode_record_header(offset, h, length);
+}
+
+bool asn1::ber::synchronizer::decode_record_header(size_t offset,
+                                                   header& h,
+                                                   uint64_t& length) const
+{
+  if (offset >= _M_size) {
+    return false;
+  }
+
+  const uint8_t* const buf = _M_data + offset;
+  const size_t len = _M_size - offset;
+
+  return ((decode_header(buf, len, h)) &&
+          (h.tc == _M_header.tc) &&
+          (h.pc == _M_header.pc) &&
+          (h.tn == _M_header.tn) &&
+          ((length = tlv_length(buf, len)) != 0));
+}
@@ -0,0 +1,76 @@
+#ifndef ASN1_BER_SYNC_H
+#define ASN1_BER_SYNC_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include "asn1/ber/common.h"
+
+namespace asn1 {
+  namespace ber {
+    // Finds the boundaries of the top-level records of a file of concatenated
+    // records from an arbitrary offset (the midpoint of a binary search, the
+    // byte after a corrupt record...).
+    // A record is plausible if:
+    //   - It has the tag of the first record of the file.
+    //   - Its length doesn't go past the end of the file.
+    //   - The headers of the values nested in it are valid and their lengths
+    //     add up.
+    //   - The next 'confirmations' records are also plausible (or the file
+    //     ends before).
+    // If the first value nested in a plausible record is also a plausible
+    // record, the nested one is taken (the record found would contain
+    // garbage followed by the header of a record).
+    class synchronizer {
+      public:
+        // Default number of records which confirm a record.
+        static const unsigned default_confirmations = 8;
+
+        // Constructor.
+        synchronizer(const void* data,
+                     size_t size,
+                     unsigned confirmations = default_confirmations);
+
+        // Destructor.
+        ~synchronizer() = default;
+
+        // Is there a plausible record at 'offset'?
+        bool plausible(size_t offset, uint64_t& length) const;
+
+        // Is there a valid record at 'offset' (the next records are not
+        // checked)?
+        bool check(size_t offset, uint64_t& length) const;
+
+        // Does a record start at 'offset' (only the headers of the record
+        // are checked, not the ones of the values nested in it)?
+        bool starts(size_t offset, uint64_t& length) const;
+
+        // Find the first plausible record which starts in [from, to).
+        bool next(size_t from,
+                  size_t to,
+                  size_t& offset,
+                  uint64_t& length) const;
+
+      private:
+        const uint8_t* _M_data;
+        size_t _M_size;
+
+        unsigned _M_confirmations;
+
+        // Tag of the records (from the first record of the file).
+        bool _M_valid;
+        header _M_header;
+
+        // Decode the header of the record at 'offset' and get the length of
+        // the record.
+        bool decode_record_header(size_t offset,
+                                  header& h,
+                                  uint64_t& length) const;
+
+        // Disable copy constructor and assignment operator.
+        synchronizer(const synchronizer&) = delete;
+        synchronizer& operator=(const synchronizer&) = delete;
+    };
+  }
+}
+
+#endif // ASN1_BER_SYNC_H
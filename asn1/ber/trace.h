@@ -0,0 +1,32 @@
+#ifndef ASN1_BER_TRACE_H
+#define ASN1_BER_TRACE_H
+
+// Static tracepoints (USDT probes of the provider "asn1_ber"), which can be
+// used with bpftrace, perf or SystemTap. A probe which is not attached is a
+// single nop.
+// The probes are only compiled in when <sys/sdt.h> is available (no runtime
+// dependency) and ASN1_BER_NO_TRACE is not defined.
+#if !defined(ASN1_BER_NO_TRACE) && defined(__has_include)
+  #if __has_include(<sys/sdt.h>)
+    #include <sys/sdt.h>
+    #define ASN1_BER_HAVE_TRACE 1
+  #endif
+#endif
+
+#ifdef ASN1_BER_HAVE_TRACE
+  #define ASN1_BER_TRACE0(name)                                               \
+    DTRACE_PROBE(asn1_ber, name)
+  #define ASN1_BER_TRACE2(name, a1, a2)                                       \
+    DTRACE_PROBE2(asn1_ber, name, a1, a2)
+  #define ASN1_BER_TRACE3(name, a1, a2, a3)                                   \
+    DTRACE_PROBE3(asn1_ber, name, a1, a2, a3)
+  #define ASN1_BER_TRACE4(name, a1, a2, a3, a4)                               \
+    DTRACE_PROBE4(asn1_ber, name, a1, a2, a3, a4)
+#else
+  #define ASN1_BER_TRACE0(name) do {} while (0)
+  #define ASN1_BER_TRACE2(name, a1, a2) do {} while (0)
+  #define ASN1_BER_TRACE3(name, a1, a2, a3) do {} while (0)
+  #define ASN1_BER_TRACE4(name, a1, a2, a3, a4) do {} while (0)
+#endif
+
+#endif // ASN1_BER_TRACE_H
@@ -0,0 +1,1168 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/common.h"
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/encoder.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/null_object.h"
+
+using namespace asn1::ber;
+
+// Previous implementations of the primitives (if/else ladders and
+// switch statements), used as the reference.
+namespace legacy {
+  static size_t encode_tag(tag_class tc,
+                           primitive_constructed pc,
+                           tag_number tn,
+                           uint8_t* buf)
+  {
+    if (tn < 31) {
+      buf[0] = (static_cast<uint8_t>(tc) << 6) |
+               (static_cast<uint8_t>(pc) << 5) |
+               static_cast<uint8_t>(tn);
+
+      return 1;
+    } else {
+      buf[0] = (static_cast<uint8_t>(tc) << 6) |
+               (static_cast<uint8_t>(pc) << 5) |
+               static_cast<uint8_t>(0x1f);
+
+      if (tn <= 0x7full) {
+        buf[1] = static_cast<uint8_t>(tn);
+
+        return 2;
+      } else if (tn <= 0x3fffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[2] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 3;
+      } else if (tn <= 0x1fffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[3] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 4;
+      } else if (tn <= 0xfffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[4] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 5;
+      } else if (tn <= 0x7ffffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[5] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 6;
+      } else if (tn <= 0x3ffffffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[5] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[6] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 7;
+      } else if (tn <= 0x1ffffffffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[5] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[6] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[7] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 8;
+      } else if (tn <= 0xffffffffffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[5] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[6] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[7] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[8] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 9;
+      } else if (tn <= 0x7fffffffffffffffull) {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 56) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
+        buf[5] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[6] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[7] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[8] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[9] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 10;
+      } else {
+        buf[1] = 0x80 | static_cast<uint8_t>((tn >> 63) & 0x7f);
+        buf[2] = 0x80 | static_cast<uint8_t>((tn >> 56) & 0x7f);
+        buf[3] = 0x80 | static_cast<uint8_t>((tn >> 49) & 0x7f);
+        buf[4] = 0x80 | static_cast<uint8_t>((tn >> 42) & 0x7f);
+        buf[5] = 0x80 | static_cast<uint8_t>((tn >> 35) & 0x7f);
+        buf[6] = 0x80 | static_cast<uint8_t>((tn >> 28) & 0x7f);
+        buf[7] = 0x80 | static_cast<uint8_t>((tn >> 21) & 0x7f);
+        buf[8] = 0x80 | static_cast<uint8_t>((tn >> 14) & 0x7f);
+        buf[9] = 0x80 | static_cast<uint8_t>((tn >> 7) & 0x7f);
+        buf[10] = static_cast<uint8_t>(tn & 0x7f);
+
+        return 11;
+      }
+    }
+  }
+
+  static size_t encode_length(size_t len, uint8_t* buf)
+  {
+    if (len <= 0x7full) {
+      buf[0] = static_cast<uint8_t>(len);
+      return 1;
+    } else if (len <= 0xffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(1);
+
+      buf[1] = static_cast<uint8_t>(len);
+
+      return 2;
+    } else if (len <= 0xffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(2);
+
+      buf[1] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[2] = static_cast<uint8_t>(len & 0xff);
+
+      return 3;
+    } else if (len <= 0xffffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(3);
+
+      buf[1] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[3] = static_cast<uint8_t>(len & 0xff);
+
+      return 4;
+    } else if (len <= 0xffffffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(4);
+
+      buf[1] = static_cast<uint8_t>((len >> 24) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[3] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[4] = static_cast<uint8_t>(len & 0xff);
+
+      return 5;
+    } else if (len <= 0xffffffffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(5);
+
+      buf[1] = static_cast<uint8_t>((len >> 32) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 24) & 0xff);
+      buf[3] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[4] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[5] = static_cast<uint8_t>(len & 0xff);
+
+      return 6;
+    } else if (len <= 0xffffffffffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(6);
+
+      buf[1] = static_cast<uint8_t>((len >> 40) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 32) & 0xff);
+      buf[3] = static_cast<uint8_t>((len >> 24) & 0xff);
+      buf[4] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[5] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[6] = static_cast<uint8_t>(len & 0xff);
+
+      return 7;
+    } else if (len <= 0xffffffffffffffull) {
+      buf[0] = 0x80 | static_cast<uint8_t>(7);
+
+      buf[1] = static_cast<uint8_t>((len >> 48) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 40) & 0xff);
+      buf[3] = static_cast<uint8_t>((len >> 32) & 0xff);
+      buf[4] = static_cast<uint8_t>((len >> 24) & 0xff);
+      buf[5] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[6] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[7] = static_cast<uint8_t>(len & 0xff);
+
+      return 8;
+    } else {
+      buf[0] = 0x80 | static_cast<uint8_t>(8);
+
+      buf[1] = static_cast<uint8_t>((len >> 56) & 0xff);
+      buf[2] = static_cast<uint8_t>((len >> 48) & 0xff);
+      buf[3] = static_cast<uint8_t>((len >> 40) & 0xff);
+      buf[4] = static_cast<uint8_t>((len >> 32) & 0xff);
+      buf[5] = static_cast<uint8_t>((len >> 24) & 0xff);
+      buf[6] = static_cast<uint8_t>((len >> 16) & 0xff);
+      buf[7] = static_cast<uint8_t>((len >> 8) & 0xff);
+      buf[8] = static_cast<uint8_t>(len & 0xff);
+
+      return 9;
+    }
+  }
+
+  static size_t encode_integer(int64_t n, uint8_t* buf)
+  {
+    // If the value is positive.
+    if (n >= 0) {
+      if (n < 0x80ll) {
+        buf[0] = static_cast<uint8_t>(n);
+
+        return 1;
+      } else if (n < 0x8000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[1] = static_cast<uint8_t>(n & 0xff);
+
+        return 2;
+      } else if (n < 0x800000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[2] = static_cast<uint8_t>(n & 0xff);
+
+        return 3;
+      } else if (n < 0x80000000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 24) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[2] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[3] = static_cast<uint8_t>(n & 0xff);
+
+        return 4;
+      } else if (n < 0x8000000000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 32) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 24) & 0xff);
+        buf[2] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[3] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[4] = static_cast<uint8_t>(n & 0xff);
+
+        return 5;
+      } else if (n < 0x800000000000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 40) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 32) & 0xff);
+        buf[2] = static_cast<uint8_t>((n >> 24) & 0xff);
+        buf[3] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[4] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[5] = static_cast<uint8_t>(n & 0xff);
+
+        return 6;
+      } else if (n < 0x80000000000000ll) {
+        buf[0] = static_cast<uint8_t>((n >> 48) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 40) & 0xff);
+        buf[2] = static_cast<uint8_t>((n >> 32) & 0xff);
+        buf[3] = static_cast<uint8_t>((n >> 24) & 0xff);
+        buf[4] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[5] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[6] = static_cast<uint8_t>(n & 0xff);
+
+        return 7;
+      } else {
+        buf[0] = static_cast<uint8_t>((n >> 56) & 0xff);
+        buf[1] = static_cast<uint8_t>((n >> 48) & 0xff);
+        buf[2] = static_cast<uint8_t>((n >> 40) & 0xff);
+        buf[3] = static_cast<uint8_t>((n >> 32) & 0xff);
+        buf[4] = static_cast<uint8_t>((n >> 24) & 0xff);
+        buf[5] = static_cast<uint8_t>((n >> 16) & 0xff);
+        buf[6] = static_cast<uint8_t>((n >> 8) & 0xff);
+        buf[7] = static_cast<uint8_t>(n & 0xff);
+
+        return 8;
+      }
+    } else if (n >= -0x80ll) {
+      buf[0] = static_cast<uint8_t>(n);
+
+      return 1;
+    } else if (n >= -0x8000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[1] = static_cast<uint8_t>(n & 0xff);
+
+      return 2;
+    } else if (n >= -0x800000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[2] = static_cast<uint8_t>(n & 0xff);
+
+      return 3;
+    } else if (n >= -0x80000000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 24) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[2] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[3] = static_cast<uint8_t>(n & 0xff);
+
+      return 4;
+    } else if (n >= -0x8000000000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 32) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 24) & 0xff);
+      buf[2] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[3] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[4] = static_cast<uint8_t>(n & 0xff);
+
+      return 5;
+    } else if (n >= -0x800000000000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 40) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 32) & 0xff);
+      buf[2] = static_cast<uint8_t>((n >> 24) & 0xff);
+      buf[3] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[4] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[5] = static_cast<uint8_t>(n & 0xff);
+
+      return 6;
+    } else if (n >= -0x80000000000000ll) {
+      buf[0] = static_cast<uint8_t>((n >> 48) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 40) & 0xff);
+      buf[2] = static_cast<uint8_t>((n >> 32) & 0xff);
+      buf[3] = static_cast<uint8_t>((n >> 24) & 0xff);
+      buf[4] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[5] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[6] = static_cast<uint8_t>(n & 0xff);
+
+      return 7;
+    } else {
+      buf[0] = static_cast<uint8_t>((n >> 56) & 0xff);
+      buf[1] = static_cast<uint8_t>((n >> 48) & 0xff);
+      buf[2] = static_cast<uint8_t>((n >> 40) & 0xff);
+      buf[3] = static_cast<uint8_t>((n >> 32) & 0xff);
+      buf[4] = static_cast<uint8_t>((n >> 24) & 0xff);
+      buf[5] = static_cast<uint8_t>((n >> 16) & 0xff);
+      buf[6] = static_cast<uint8_t>((n >> 8) & 0xff);
+      buf[7] = static_cast<uint8_t>(n & 0xff);
+
+      return 8;
+    }
+  }
+
+  static int64_t decode_integer(const void* buf, uint64_t len)
+  {
+    const uint8_t* const b = static_cast<const uint8_t*>(buf);
+
+    uint64_t n;
+
+    switch (len) {
+      case 8:
+        n  = (static_cast<uint64_t>(b[0]) << 56);
+        n |= (static_cast<uint64_t>(b[1]) << 48);
+        n |= (static_cast<uint64_t>(b[2]) << 40);
+        n |= (static_cast<uint64_t>(b[3]) << 32);
+        n |= (static_cast<uint64_t>(b[4]) << 24);
+        n |= (static_cast<uint64_t>(b[5]) << 16);
+        n |= (static_cast<uint64_t>(b[6]) << 8);
+        n |=  static_cast<uint64_t>(b[7]);
+
+        return n;
+      case 7:
+        n =  (static_cast<uint64_t>(b[0]) << 48);
+        n |= (static_cast<uint64_t>(b[1]) << 40);
+        n |= (static_cast<uint64_t>(b[2]) << 32);
+        n |= (static_cast<uint64_t>(b[3]) << 24);
+        n |= (static_cast<uint64_t>(b[4]) << 16);
+        n |= (static_cast<uint64_t>(b[5]) << 8);
+        n |=  static_cast<uint64_t>(b[6]);
+
+        break;
+      case 6:
+        n =  (static_cast<uint64_t>(b[0]) << 40);
+        n |= (static_cast<uint64_t>(b[1]) << 32);
+        n |= (static_cast<uint64_t>(b[2]) << 24);
+        n |= (static_cast<uint64_t>(b[3]) << 16);
+        n |= (static_cast<uint64_t>(b[4]) << 8);
+        n |=  static_cast<uint64_t>(b[5]);
+
+        break;
+      case 5:
+        n =  (static_cast<uint64_t>(b[0]) << 32);
+        n |= (static_cast<uint64_t>(b[1]) << 24);
+        n |= (static_cast<uint64_t>(b[2]) << 16);
+        n |= (static_cast<uint64_t>(b[3]) << 8);
+        n |=  static_cast<uint64_t>(b[4]);
+
+        break;
+      case 4:
+        n =  (static_cast<uint64_t>(b[0]) << 24);
+        n |= (static_cast<uint64_t>(b[1]) << 16);
+        n |= (static_cast<uint64_t>(b[2]) << 8);
+        n |=  static_cast<uint64_t>(b[3]);
+
+        break;
+      case 3:
+        n =  (static_cast<uint64_t>(b[0]) << 16);
+        n |= (static_cast<uint64_t>(b[1]) << 8);
+        n |=  static_cast<uint64_t>(b[2]);
+
+        break;
+      case 2:
+        n =  (static_cast<uint64_t>(b[0]) << 8);
+        n |=  static_cast<uint64_t>(b[1]);
+
+        break;
+      default:
+        n = static_cast<uint64_t>(b[0]);
+    }
+
+    // If the number is positive...
+    if ((*b & 0x80) == 0) {
+      return n;
+    } else {
+      return ((~static_cast<uint64_t>(0) << (len << 3)) | n);
+    }
+  }
+}
+
+// Number of input values (big enough so that the branch predictor cannot
+// learn the sequence).
+static const size_t number_inputs = 65536;
+
+// Approximate size of the corpora used by the end-to-end benchmarks.
+static const size_t corpus_size = 4 * 1024 * 1024;
+
+static volatile size_t sink;
+
+// Get monotonic time in nanoseconds.
+static uint64_t now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ull) + ts.tv_nsec;
+}
+
+// Pseudo-random number generator (xorshift64*).
+static uint64_t random64()
+{
+  static uint64_t state = 0x9e3779b97f4a7c15ull;
+
+  state ^= state >> 12;
+  state ^= state << 25;
+  state ^= state >> 27;
+
+  return state * 0x2545f4914f6cdd1dull;
+}
+
+// Generate a value whose number of significant bits is uniformly distributed.
+static uint64_t random_value()
+{
+  return random64() >> (random64() & 0x3f);
+}
+
+class benchmarks {
+  public:
+    // Constructor.
+    benchmarks(int argc, const char** argv);
+
+    // Destructor.
+    ~benchmarks();
+
+    // Valid arguments?
+    bool valid() const
+    {
+      return _M_valid;
+    }
+
+    // Run microbenchmark: 'fn(i)' processes the input 'i'.
+    template<typename Function>
+    void run(const char* name, Function fn);
+
+    // Run microbenchmark of 'fn' and of the previous implementation
+    // 'legacy_fn' and report both timings and the speedup.
+    template<typename Legacy, typename Function>
+    void compare(const char* name,
+                 const char* legacy_name,
+                 Legacy legacy_fn,
+                 Function fn);
+
+    // Run end-to-end benchmark: 'fn()' processes 'records' records
+    // ('bytes' bytes).
+    template<typename Function>
+    void run(const char* name, size_t records, size_t bytes, Function fn);
+
+  private:
+    // Minimum running time of a benchmark (nanoseconds).
+    uint64_t _M_min_time = 200000000ull;
+
+    const char* _M_filter = nullptr;
+
+    bool _M_json = false;
+
+    size_t _M_count = 0;
+
+    bool _M_valid = true;
+
+    // Run benchmark?
+    bool selected(const char* name) const
+    {
+      return ((!_M_filter) || (strstr(name, _M_filter)));
+    }
+
+    // Measure microbenchmark.
+    template<typename Function>
+    void measure(Function fn, uint64_t& iterations, uint64_t& elapsed);
+
+    // Report (with the speedup over the previous implementation if it is
+    // not 0).
+    void report(const char* name,
+                uint64_t iterations,
+                uint64_t elapsed,
+                size_t records,
+                size_t bytes,
+                double speedup = 0.0);
+};
+
+benchmarks::benchmarks(int argc, const char** argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--json") == 0) {
+      _M_json = true;
+    } else if ((strcmp(argv[i], "--filter") == 0) && (i + 1 < argc)) {
+      _M_filter = argv[++i];
+    } else if ((strcmp(argv[i], "--min-time") == 0) && (i + 1 < argc)) {
+      _M_min_time = strtoull(argv[++i], nullptr, 10) * 1000000ull;
+    } else {
+      _M_valid = false;
+      return;
+    }
+  }
+
+  if (_M_json) {
+    printf("{\n  \"benchmarks\": [");
+  } else {
+    printf("%-32s %12s %12s %12s %12s\n",
+           "benchmark",
+           "ns/op",
+           "MB/s",
+           "records/s",
+           "speedup");
+  }
+}
+
+benchmarks::~benchmarks()
+{
+  if ((_M_valid) && (_M_json)) {
+    printf("\n  ]\n}\n");
+  }
+}
+
+template<typename Function>
+void benchmarks::run(const char* name, Function fn)
+{
+  if (selected(name)) {
+    uint64_t iterations, elapsed;
+    measure(fn, iterations, elapsed);
+
+    report(name, iterations, elapsed, 0, 0);
+  }
+}
+
+template<typename Legacy, typename Function>
+void benchmarks::compare(const char* name,
+                         const char* legacy_name,
+                         Legacy legacy_fn,
+                         Function fn)
+{
+  if ((selected(name)) || (selected(legacy_name))) {
+    uint64_t legacy_iterations, legacy_elapsed;
+    measure(legacy_fn, legacy_iterations, legacy_elapsed);
+
+    uint64_t iterations, elapsed;
+    measure(fn, iterations, elapsed);
+
+    report(legacy_name, legacy_iterations, legacy_elapsed, 0, 0);
+
+    const double speedup =
+      (static_cast<double>(legacy_elapsed) / legacy_iterations) /
+      (static_cast<double>(elapsed) / iterations);
+
+    report(name, iterations, elapsed, 0, 0, speedup);
+  }
+}
+
+template<typename Function>
+void benchmarks::measure(Function fn, uint64_t& iterations, uint64_t& elapsed)
+{
+  // Warm up.
+  size_t res = 0;
+  for (size_t i = 0; i < number_inputs; i++) {
+    res += fn(i);
+  }
+
+  iterations = 0;
+  uint64_t start = now();
+
+  do {
+    for (size_t i = 0; i < number_inputs; i++) {
+      res += fn(i);
+    }
+
+    iterations += number_inputs;
+  } while ((elapsed = now() - start) < _M_min_time);
+
+  sink = res;
+}
+
+template<typename Function>
+void benchmarks::run(const char* name,
+                     size_t records,
+                     size_t bytes,
+                     Function fn)
+{
+  if (selected(name)) {
+    // Warm up.
+    size_t res = fn();
+
+    uint64_t iterations = 0;
+    uint64_t start = now();
+    uint64_t elapsed;
+
+    do {
+      res += fn();
+      iterations++;
+    } while ((elapsed = now() - start) < _M_min_time);
+
+    sink = res;
+
+    report(name, iterations * records, elapsed, records, bytes);
+  }
+}
+
+void benchmarks::report(const char* name,
+                        uint64_t iterations,
+                        uint64_t elapsed,
+                        size_t records,
+                        size_t bytes,
+                        double speedup)
+{
+  double ns = static_cast<double>(elapsed) / iterations;
+
+  // Throughput (end-to-end benchmarks).
+  double mbps = 0.0;
+  double rps = 0.0;
+
+  if (records > 0) {
+    double seconds = static_cast<double>(elapsed) / 1000000000.0;
+    double passes = static_cast<double>(iterations) / records;
+
+    mbps = (passes * bytes) / (seconds * 1000000.0);
+    rps = static_cast<double>(iterations) / seconds;
+  }
+
+  if (_M_json) {
+    printf("%s\n    {\n", (_M_count > 0) ? "," : "");
+    printf("      \"name\": \"%s\",\n", name);
+    printf("      \"iterations\": %llu,\n",
+           static_cast<unsigned long long>(iterations));
+
+    printf("      \"ns_per_op\": %.3f", ns);
+
+    if (records > 0) {
+      printf(",\n      \"mb_per_second\": %.3f,\n", mbps);
+      printf("      \"records_per_second\": %.3f\n", rps);
+    } else if (speedup != 0.0) {
+      printf(",\n      \"speedup\": %.3f\n", speedup);
+    } else {
+      printf("\n");
+    }
+
+    printf("    }");
+  } else {
+    if (records > 0) {
+      printf("%-32s %12.2f %12.2f %12.0f\n", name, ns, mbps, rps);
+    } else if (speedup != 0.0) {
+      printf("%-32s %12.2f %12s %12s %11.2fx\n",
+             name,
+             ns,
+             "-",
+             "-",
+             speedup);
+    } else {
+      printf("%-32s %12.2f %12s %12s\n", name, ns, "-", "-");
+    }
+  }
+
+  fflush(stdout);
+
+  _M_count++;
+}
+
+// Writer which discards the data.
+class null_writer {
+  public:
+    bool write(const void* buf, size_t len)
+    {
+      _M_count += len;
+      return true;
+    }
+
+    size_t count() const
+    {
+      return _M_count;
+    }
+
+  private:
+    size_t _M_count = 0;
+};
+
+// Record shapes.
+typedef encoder<> record_encoder;
+
+// Small record: a few explicitly tagged integers.
+static bool encode_small(record_encoder& e, uint64_t n)
+{
+  return ((e.start_sequence(tag_class::Application,
+                            tagging::Implicit,
+                            1)) &&
+          (e.add_integer(tag_class::ContextSpecific,
+                         tagging::Explicit,
+                         0,
+                         static_cast<int64_t>(n))) &&
+          (e.add_integer(tag_class::ContextSpecific,
+                         tagging::Explicit,
+                         1,
+                         static_cast<int64_t>(n * 1000))) &&
+          (e.add_enumerated(tag_class::ContextSpecific,
+                            tagging::Explicit,
+                            2,
+                            static_cast<int64_t>(n & 0x07))) &&
+          (e.add_boolean(tag_class::ContextSpecific,
+                         tagging::Implicit,
+                         3,
+                         (n & 0x01) != 0)) &&
+          (e.end_sequence()));
+}
+
+// Call detail record: implicitly tagged numbers, counters and timestamps and
+// a nested sequence.
+static bool encode_cdr(record_encoder& e, uint64_t n)
+{
+  static const char* const msisdn = "34600123456";
+  static const char* const imsi = "214011234567890";
+
+  struct timeval tv;
+  tv.tv_sec = 1600000000 + static_cast<time_t>(n);
+  tv.tv_usec = static_cast<suseconds_t>((n * 1000) % 1000000);
+
+  if ((!e.start_sequence(tag_class::Application,
+                         tagging::Implicit,
+                         20)) ||
+      (!e.add_integer(tag_class::ContextSpecific,
+                      tagging::Implicit,
+                      0,
+                      static_cast<int64_t>(n))) ||
+      (!e.add_octetstring(tag_class::ContextSpecific,
+                          tagging::Implicit,
+                          1,
+                          imsi,
+                          15,
+                          record_encoder::copy::Shallow)) ||
+      (!e.add_octetstring(tag_class::ContextSpecific,
+                          tagging::Implicit,
+                          2,
+                          msisdn,
+                          11,
+                          record_encoder::copy::Shallow)) ||
+      (!e.add_generalized_time(tag_class::ContextSpecific,
+                               tagging::Explicit,
+                               3,
+                               tv)) ||
+      (!e.add_integer(tag_class::ContextSpecific,
+                      tagging::Implicit,
+                      4,
+                      static_cast<int64_t>(n % 3600))) ||
+      (!e.start_sequence(tag_class::ContextSpecific,
+                         tagging::Implicit,
+                         5))) {
+    return false;
+  }
+
+  for (unsigned i = 0; i < 4; i++) {
+    if ((!e.start_sequence(tag_class::Universal,
+                           tagging::Implicit,
+                           not_specified)) ||
+        (!e.add_integer(tag_class::ContextSpecific,
+                        tagging::Implicit,
+                        0,
+                        static_cast<int64_t>(i))) ||
+        (!e.add_integer(tag_class::ContextSpecific,
+                        tagging::Implicit,
+                        1,
+                        static_cast<int64_t>((n + i) * 12345))) ||
+        (!e.add_integer(tag_class::ContextSpecific,
+                        tagging::Implicit,
+                        2,
+                        static_cast<int64_t>((n + i) * 67890))) ||
+        (!e.end_sequence())) {
+      return false;
+    }
+  }
+
+  return ((e.end_sequence()) &&
+          (e.add_utc_time(tag_class::ContextSpecific,
+                          tagging::Explicit,
+                          6,
+                          tv.tv_sec)) &&
+          (e.add_ia5_string(tag_class::ContextSpecific,
+                            tagging::Implicit,
+                            200,
+                            "mediation-node-01",
+                            17,
+                            record_encoder::copy::Deep)) &&
+          (e.end_sequence()));
+}
+
+// Record with big strings.
+static bool encode_strings(record_encoder& e, uint64_t n)
+{
+  static uint8_t data[4096];
+
+  for (size_t i = 0; i < sizeof(data); i++) {
+    data[i] = static_cast<uint8_t>(i + n);
+  }
+
+  return ((e.start_sequence(tag_class::Universal,
+                            tagging::Implicit,
+                            not_specified)) &&
+          (e.add_octetstring(tag_class::ContextSpecific,
+                             tagging::Implicit,
+                             0,
+                             data,
+                             256,
+                             record_encoder::copy::Deep)) &&
+          (e.add_octetstring(tag_class::ContextSpecific,
+                             tagging::Implicit,
+                             1,
+                             data,
+                             sizeof(data),
+                             record_encoder::copy::Deep)) &&
+          (e.add_utf8_string(tag_class::ContextSpecific,
+                             tagging::Implicit,
+                             2,
+                             data,
+                             1024,
+                             record_encoder::copy::Deep)) &&
+          (e.end_sequence()));
+}
+
+struct record_shape {
+  const char* decoder_name;
+  const char* encoder_name;
+  bool (*encode)(record_encoder& e, uint64_t n);
+};
+
+static const record_shape shapes[] = {
+  {"decoder/small",   "encoder/small",   encode_small},
+  {"decoder/cdr",     "encoder/cdr",     encode_cdr},
+  {"decoder/strings", "encoder/strings", encode_strings}
+};
+
+// Build corpus of concatenated records.
+static uint8_t* build_corpus(const record_shape& shape,
+                             size_t& len,
+                             size_t& records)
+{
+  uint8_t* corpus;
+  if ((corpus = static_cast<uint8_t*>(malloc(corpus_size))) != nullptr) {
+    record_encoder e;
+
+    len = 0;
+    records = 0;
+
+    do {
+      e.clear();
+
+      if (shape.encode(e, records)) {
+        size_t n;
+        if ((n = e.encode_to(corpus + len, corpus_size - len)) > 0) {
+          len += n;
+          records++;
+
+          continue;
+        }
+      }
+
+      break;
+    } while (true);
+
+    if (records > 0) {
+      return corpus;
+    }
+
+    free(corpus);
+  }
+
+  return nullptr;
+}
+
+static void microbenchmarks(benchmarks& b)
+{
+  static uint64_t values[number_inputs];
+  static tag_number tags[number_inputs];
+  static int64_t integers[number_inputs];
+  static double reals[number_inputs];
+  static struct timeval times[number_inputs];
+
+  for (size_t i = 0; i < number_inputs; i++) {
+    values[i] = random_value();
+
+    tags[i] = random64() >> (29 + (random64() % 35));
+
+    integers[i] = (random64() & 0x01) ? static_cast<int64_t>(values[i]) :
+                                        -static_cast<int64_t>(values[i]);
+
+    reals[i] = ldexp(static_cast<double>(integers[i]),
+                     static_cast<int>(random64() % 64) - 32);
+
+    times[i].tv_sec = static_cast<time_t>(random64() % 2000000000ull);
+    times[i].tv_usec = static_cast<suseconds_t>(
+                         (random64() & 0x01) ? (random64() % 1000) * 1000 : 0
+                       );
+  }
+
+  // Encoded inputs of the decoding functions.
+  struct encoded {
+    uint8_t buf[32];
+    size_t len;
+  };
+
+  static encoded encoded_integers[number_inputs];
+  static encoded encoded_reals[number_inputs];
+  static encoded encoded_utc_times[number_inputs];
+  static encoded encoded_generalized_times[number_inputs];
+  static encoded encoded_oids[number_inputs];
+
+  for (size_t i = 0; i < number_inputs; i++) {
+    encoded_integers[i].len = encode_integer(integers[i],
+                                             encoded_integers[i].buf);
+
+    encoded_reals[i].len = encode_real(reals[i], encoded_reals[i].buf);
+
+    encoded_utc_times[i].len = encode_utc_time(times[i].tv_sec,
+                                               encoded_utc_times[i].buf);
+
+    encoded_generalized_times[i].len =
+      encode_generalized_time(times[i], encoded_generalized_times[i].buf);
+
+    // Object identifier: 1.3.6.1.4.1.<n>.<n>.
+    static const uint8_t prefix[] = {0x2b, 0x06, 0x01, 0x04, 0x01};
+
+    uint8_t* buf = encoded_oids[i].buf;
+    memcpy(buf, prefix, sizeof(prefix));
+
+    size_t len = sizeof(prefix);
+
+    for (unsigned j = 0; j < 2; j++) {
+      uint64_t component = values[i] & 0x1fffff;
+
+      if (component >= 0x4000) {
+        buf[len++] = 0x80 | static_cast<uint8_t>(component >> 14);
+      }
+
+      if (component >= 0x80) {
+        buf[len++] = 0x80 | static_cast<uint8_t>((component >> 7) & 0x7f);
+      }
+
+      buf[len++] = static_cast<uint8_t>(component & 0x7f);
+    }
+
+    encoded_oids[i].len = len;
+  }
+
+  uint8_t buf[32];
+
+  // The clz-based primitives against the previous if/else ladders.
+  b.compare("encode_tag_padded", "legacy::encode_tag", [&](size_t i) {
+    return legacy::encode_tag(tag_class::ContextSpecific,
+                              primitive_constructed::Primitive,
+                              tags[i],
+                              buf);
+  }, [&](size_t i) {
+    return encode_tag_padded(tag_class::ContextSpecific,
+                             primitive_constructed::Primitive,
+                             tags[i],
+                             buf);
+  });
+
+  b.run("encode_tag", [&](size_t i) {
+    return encode_tag(tag_class::ContextSpecific,
+                      primitive_constructed::Primitive,
+                      tags[i],
+                      buf);
+  });
+
+  b.compare("encode_length_padded", "legacy::encode_length", [&](size_t i) {
+    return legacy::encode_length(values[i], buf);
+  }, [&](size_t i) {
+    return encode_length_padded(values[i], buf);
+  });
+
+  b.run("encode_length", [&](size_t i) {
+    return encode_length(values[i], buf);
+  });
+
+  b.compare("encode_integer_padded", "legacy::encode_integer", [&](size_t i) {
+    return legacy::encode_integer(integers[i], buf);
+  }, [&](size_t i) {
+    return encode_integer_padded(integers[i], buf);
+  });
+
+  b.run("encode_integer", [&](size_t i) {
+    return encode_integer(integers[i], buf);
+  });
+
+  b.run("encode_real", [&](size_t i) {
+    return encode_real(reals[i], buf);
+  });
+
+  b.run("encode_utc_time", [&](size_t i) {
+    return encode_utc_time(times[i].tv_sec, buf);
+  });
+
+  b.run("encode_generalized_time", [&](size_t i) {
+    return encode_generalized_time(times[i], buf);
+  });
+
+  // The decoder can read past the contents octets when they are in the
+  // reader's memory (memory-backed readers) or in its buffer.
+  b.compare("decode_integer", "legacy::decode_integer", [&](size_t i) {
+    return static_cast<size_t>(legacy::decode_integer(encoded_integers[i].buf,
+                                                      encoded_integers[i].len));
+  }, [&](size_t i) {
+    return static_cast<size_t>(decode_integer(encoded_integers[i].buf,
+                                              encoded_integers[i].len,
+                                              sizeof(encoded_integers[i].buf)));
+  });
+
+  // Otherwise, only the contents octets can be read.
+  b.run("decode_integer (contents only)", [&](size_t i) {
+    return static_cast<size_t>(decode_integer(encoded_integers[i].buf,
+                                              encoded_integers[i].len,
+                                              encoded_integers[i].len));
+  });
+
+  b.run("decode_real", [&](size_t i) {
+    double d;
+    return decode_real(encoded_reals[i].buf, encoded_reals[i].len, d) ?
+             static_cast<size_t>(d) :
+             0;
+  });
+
+  b.run("decode_utc_time", [&](size_t i) {
+    time_t t;
+    return decode_utc_time(encoded_utc_times[i].buf,
+                           encoded_utc_times[i].len,
+                           t) ?
+             static_cast<size_t>(t) :
+             0;
+  });
+
+  b.run("decode_generalized_time", [&](size_t i) {
+    struct timeval tv;
+    return decode_generalized_time(encoded_generalized_times[i].buf,
+                                   encoded_generalized_times[i].len,
+                                   tv) ?
+             static_cast<size_t>(tv.tv_sec + tv.tv_usec) :
+             0;
+  });
+
+  b.run("decode_oid", [&](size_t i) {
+    uint64_t oid[max_oid_components];
+    size_t ncomponents;
+    return decode_oid(encoded_oids[i].buf,
+                      encoded_oids[i].len,
+                      oid,
+                      ncomponents) ?
+             static_cast<size_t>(oid[ncomponents - 1]) :
+             0;
+  });
+}
+
+static bool decoder_benchmarks(benchmarks& b)
+{
+  for (const record_shape& shape : shapes) {
+    size_t len, records;
+
+    uint8_t* corpus;
+    if ((corpus = build_corpus(shape, len, records)) != nullptr) {
+      b.run(shape.decoder_name, records, len, [&]() {
+        memory_reader reader(corpus, len);
+        null_object obj;
+
+        size_t count = 0;
+
+        while ((!reader.eof()) && (decoder::decode(reader, obj))) {
+          count++;
+        }
+
+        return count;
+      });
+
+      free(corpus);
+    } else {
+      fprintf(stderr, "Error building corpus for '%s'.\n", shape.decoder_name);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static bool encoder_benchmarks(benchmarks& b)
+{
+  static const size_t records = 1024;
+
+  for (const record_shape& shape : shapes) {
+    record_encoder e;
+
+    // Compute size of the records.
+    size_t len = 0;
+    for (size_t i = 0; i < records; i++) {
+      e.clear();
+
+      if (!shape.encode(e, i)) {
+        fprintf(stderr, "Error encoding '%s'.\n", shape.encoder_name);
+        return false;
+      }
+
+      len += e.size();
+    }
+
+    uint8_t* out;
+    if ((out = static_cast<uint8_t*>(malloc(len))) != nullptr) {
+      b.run(shape.encoder_name, records, len, [&]() {
+        size_t off = 0;
+
+        for (size_t i = 0; i < records; i++) {
+          e.clear();
+
+          shape.encode(e, i);
+
+          off += e.encode_to(out + off, len - off);
+        }
+
+        return off;
+      });
+
+      free(out);
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int main(int argc, const char** argv)
+{
+  benchmarks b(argc, argv);
+  if (b.valid()) {
+    microbenchmarks(b);
+
+    if ((decoder_benchmarks(b)) && (encoder_benchmarks(b))) {
+      return 0;
+    }
+  } else {
+    fprintf(stderr,
+            "Usage: %s [--json] [--filter <substring>] [--min-time <ms>]\n",
+            argv[0]);
+  }
+
+  return -1;
+}
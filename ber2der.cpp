@@ -0,0 +1,139 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/canonicalizer.h"
+
+// Transcode the records of 'data'.
+static bool canonicalize_records(const uint8_t* data,
+                                 size_t size,
+                                 asn1::ber::canonicalizer& canonicalizer)
+{
+  uint64_t nrecords = 0;
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if (!canonicalizer.canonicalize(data + off, size - off, len)) {
+      if (canonicalizer.io_error()) {
+        fprintf(stderr, "Error writing output.\n");
+      } else if (canonicalizer.error_message()) {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu, message: '%s'.\n",
+                to_string(canonicalizer.last_error()),
+                off + canonicalizer.error_offset(),
+                canonicalizer.error_message());
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu.\n",
+                to_string(canonicalizer.last_error()),
+                off + canonicalizer.error_offset());
+      }
+
+      canonicalizer.flush();
+
+      return false;
+    }
+
+    nrecords++;
+    off += len;
+  }
+
+  if (!canonicalizer.flush()) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  fprintf(stderr,
+          "Records: %llu, bytes spilled: %llu.\n",
+          static_cast<unsigned long long>(nrecords),
+          static_cast<unsigned long long>(canonicalizer.spilled()));
+
+  return true;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [--memory <bytes>] [--tmpdir <directory>] "
+          "[--output <file>] <filename>\n"
+          "\n"
+          "Transcodes the records from BER to DER: definite lengths in the\n"
+          "minimum number of octets, constructed strings flattened, BOOLEAN\n"
+          "TRUE as 0xff and the components of the SET values sorted.\n"
+          "\n"
+          "Options:\n"
+          "  --memory <bytes>        Memory of each buffer (lengths, SET\n"
+          "                          values) before spilling to a temporary\n"
+          "                          file (default: %zu).\n"
+          "  --tmpdir <directory>    Directory of the temporary files\n"
+          "                          (default: $TMPDIR or /tmp).\n"
+          "  --output <file>         Output file (default: standard output).\n",
+          program,
+          asn1::ber::spill_buffer::default_memory);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* outname = nullptr;
+  const char* tmpdir = nullptr;
+  size_t memory = asn1::ber::spill_buffer::default_memory;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--memory") == 0) && (i + 1 < argc)) {
+      char* end;
+      unsigned long long n = strtoull(argv[++i], &end, 10);
+      if ((*end) || (end == argv[i]) || (n < 4096)) {
+        fprintf(stderr, "Invalid memory '%s' (minimum: 4096).\n", argv[i]);
+        return -1;
+      }
+
+      memory = static_cast<size_t>(n);
+    } else if ((strcmp(argv[i], "--tmpdir") == 0) && (i + 1 < argc)) {
+      tmpdir = argv[++i];
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      outname = argv[++i];
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (!filename) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  int fd = STDOUT_FILENO;
+  if ((outname) &&
+      ((fd = open(outname, O_CREAT | O_TRUNC | O_WRONLY, 0644)) == -1)) {
+    fprintf(stderr, "Error opening file '%s'.\n", outname);
+    return -1;
+  }
+
+  bool ret;
+
+  {
+    asn1::ber::canonicalizer canonicalizer(fd, memory, tmpdir);
+    ret = canonicalize_records(file.data(), file.size(), canonicalizer);
+  }
+
+  if ((outname) && (close(fd) != 0)) {
+    fprintf(stderr, "Error writing file '%s'.\n", outname);
+    return -1;
+  }
+
+  return ret ? 0 : -1;
+}
@@ -0,0 +1,165 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "asn1/ber/common.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/output_file.h"
+#include "asn1/ber/buffered_writer.h"
+#include "asn1/ber/anonymizer.h"
+
+// Anonymize the records of 'data' in place.
+static bool anonymize_records(uint8_t* data,
+                              size_t size,
+                              asn1::ber::anonymizer& anonymizer)
+{
+  uint64_t nrecords = 0;
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    if (!anonymizer.anonymize(data + off, len)) {
+      if (anonymizer.error_message()) {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu, message: '%s'.\n",
+                to_string(anonymizer.last_error()),
+                off + anonymizer.error_offset(),
+                anonymizer.error_message());
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu.\n",
+                to_string(anonymizer.last_error()),
+                off + anonymizer.error_offset());
+      }
+
+      return false;
+    }
+
+    nrecords++;
+    off += len;
+  }
+
+  fprintf(stderr,
+          "Records: %llu, values anonymized: %llu.\n",
+          static_cast<unsigned long long>(nrecords),
+          static_cast<unsigned long long>(anonymizer.values()));
+
+  return true;
+}
+
+// Write the contents of 'file' to the file 'filename' (which might be the
+// same file).
+static bool write_file(const char* filename,
+                       const asn1::ber::mapped_file& file)
+{
+  asn1::ber::output_file output;
+  if (!output.open(filename, file)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return false;
+  }
+
+  bool ret;
+
+  {
+    // (The buffer is written directly when it is larger than the one of
+    // the writer.)
+    asn1::ber::buffered_writer<4096> out(output.fd());
+    ret = ((out.write(file.data(), file.size())) && (out.flush()));
+  }
+
+  if ((!ret) || (!output.close())) {
+    fprintf(stderr, "Error writing file '%s'.\n", filename);
+    return false;
+  }
+
+  return true;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s --rule <rule> ... [--key <key>] --output <file> "
+          "<filename>\n"
+          "\n"
+          "Overwrites the contents of the primitive values at the paths of\n"
+          "the rules with values of the same length (no length changes, no\n"
+          "re-encoding). The file is mapped copy-on-write, so only the pages\n"
+          "with anonymized values are copied.\n"
+          "\n"
+          "Rule: <path>=<action>\n"
+          "  <path>: \"[APPLICATION 1]/[3]\".\n"
+          "  <action>:\n"
+          "    zero      Fill with 0x00.\n"
+          "    mask:<c>  Fill with the character <c> (or the octet 0x<hh>).\n"
+          "    hash      Keyed hash of the contents.\n"
+          "    digits    Replace the ASCII digits (keyed hash).\n"
+          "    tbcd      Replace the digits of a TBCD string (keyed hash).\n"
+          "\n"
+          "Options:\n"
+          "  --rule <rule>    Add rule (the first rule which matches a value\n"
+          "                   is applied).\n"
+          "  --key <key>      Secret key of the hashes (required by hash,\n"
+          "                   digits and tbcd).\n"
+          "  --output <file>  Output file.\n",
+          program);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* outname = nullptr;
+  const char* key = nullptr;
+
+  asn1::ber::anonymizer anonymizer;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--rule") == 0) && (i + 1 < argc)) {
+      if (!anonymizer.add(argv[++i])) {
+        fprintf(stderr, "Invalid rule '%s'.\n", argv[i]);
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--key") == 0) && (i + 1 < argc)) {
+      key = argv[++i];
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      outname = argv[++i];
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if ((!filename) ||
+      (!outname) ||
+      (anonymizer.size() == 0) ||
+      ((anonymizer.hashes()) && (!key))) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  if (key) {
+    anonymizer.key(key, strlen(key));
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename, true)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  if (!anonymize_records(file.writable_data(), file.size(), anonymizer)) {
+    return -1;
+  }
+
+  return write_file(outname, file) ? 0 : -1;
+}
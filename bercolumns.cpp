@@ -0,0 +1,588 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <pthread.h>
+#include <new>
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/columns.h"
+
+// Maximum number of threads.
+static const long max_threads = 256;
+
+// Extractor of the columns: the records are split in chunks which are
+// decoded in parallel, the values of each chunk are written (in order) by
+// the calling thread.
+class extractor {
+  public:
+    // Constructor.
+    extractor(const uint8_t* data,
+              size_t size,
+              const asn1::ber::column* columns,
+              size_t ncolumns,
+              unsigned nthreads)
+      : _M_data(data),
+        _M_size(size),
+        _M_columns(columns),
+        _M_ncolumns(ncolumns),
+        _M_nthreads(nthreads)
+    {
+    }
+
+    // Destructor.
+    ~extractor();
+
+    // Extract the columns into the directory 'dir'.
+    bool extract(const char* dir);
+
+  private:
+    // Size of the chunks of records.
+    static const size_t chunk_size = 4 * 1024 * 1024;
+
+    struct chunk {
+      // Offsets of the first record and of the end of the last record.
+      size_t begin;
+      size_t end;
+
+      // Values of the columns.
+      asn1::ber::column_data* data;
+
+      // Has the chunk been processed?
+      bool done;
+
+      // Error (if 'data' is nullptr).
+      size_t error_offset;
+      enum asn1::ber::error e;
+      const char* msg;
+    };
+
+    const uint8_t* const _M_data;
+    const size_t _M_size;
+
+    const asn1::ber::column* const _M_columns;
+    const size_t _M_ncolumns;
+
+    const unsigned _M_nthreads;
+
+    chunk* _M_chunks = nullptr;
+    size_t _M_nchunks = 0;
+
+    pthread_mutex_t _M_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+    // Signaled when a chunk has been processed.
+    pthread_cond_t _M_processed = PTHREAD_COND_INITIALIZER;
+
+    // Signaled when a chunk has been written.
+    pthread_cond_t _M_written_cond = PTHREAD_COND_INITIALIZER;
+
+    // Next chunk to be processed.
+    size_t _M_next = 0;
+
+    // Number of chunks written.
+    size_t _M_written = 0;
+
+    // Stop processing chunks?
+    bool _M_stop = false;
+
+    // Split the records in chunks.
+    // Returns the offset of the end of the last complete record.
+    size_t split();
+
+    // Add chunk.
+    bool add_chunk(size_t begin, size_t end);
+
+    // Thread.
+    static void* run(void* arg);
+
+    // Process chunk.
+    void process(chunk& c);
+
+    // Write the files of the columns.
+    bool write(const char* dir, uint64_t& records);
+
+    // Write manifest.
+    bool write_manifest(const char* dir, uint64_t records) const;
+
+    // Disable copy constructor and assignment operator.
+    extractor(const extractor&) = delete;
+    extractor& operator=(const extractor&) = delete;
+};
+
+extractor::~extractor()
+{
+  if (_M_chunks) {
+    for (size_t i = 0; i < _M_nchunks; i++) {
+      delete [] _M_chunks[i].data;
+    }
+
+    free(_M_chunks);
+  }
+}
+
+bool extractor::extract(const char* dir)
+{
+  size_t end = split();
+
+  if (end < _M_size) {
+    fprintf(stderr,
+            "Error: invalid or incomplete record at offset: %zu.\n",
+            end);
+
+    return false;
+  }
+
+  // Start threads.
+  pthread_t threads[max_threads];
+  unsigned nthreads = 0;
+
+  while (nthreads < _M_nthreads) {
+    if (pthread_create(&threads[nthreads], nullptr, run, this) == 0) {
+      nthreads++;
+    } else {
+      break;
+    }
+  }
+
+  if (nthreads == 0) {
+    fprintf(stderr, "Error creating threads.\n");
+    return false;
+  }
+
+  uint64_t records;
+  bool ret = write(dir, records);
+
+  // Stop the threads.
+  pthread_mutex_lock(&_M_mutex);
+  _M_stop = true;
+  pthread_cond_broadcast(&_M_written_cond);
+  pthread_mutex_unlock(&_M_mutex);
+
+  for (unsigned i = 0; i < nthreads; i++) {
+    pthread_join(threads[i], nullptr);
+  }
+
+  if (ret) {
+    if (write_manifest(dir, records)) {
+      fprintf(stderr,
+              "Records: %llu.\n",
+              static_cast<unsigned long long>(records));
+      return true;
+    }
+
+    fprintf(stderr, "Error writing manifest.\n");
+  }
+
+  return false;
+}
+
+size_t extractor::split()
+{
+  size_t begin = 0;
+  size_t off = 0;
+
+  while (off < _M_size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(_M_data + off, _M_size - off)) == 0) {
+      break;
+    }
+
+    off += len;
+
+    if (off - begin >= chunk_size) {
+      if (!add_chunk(begin, off)) {
+        return begin;
+      }
+
+      begin = off;
+    }
+  }
+
+  if ((off > begin) && (!add_chunk(begin, off))) {
+    return begin;
+  }
+
+  return off;
+}
+
+bool extractor::add_chunk(size_t begin, size_t end)
+{
+  if ((_M_nchunks & (_M_nchunks - 1)) == 0) {
+    size_t size = (_M_nchunks > 0) ? _M_nchunks * 2 : 64;
+
+    chunk* chunks;
+    if ((chunks = static_cast<chunk*>(
+                    realloc(_M_chunks, size * sizeof(chunk))
+                  )) == nullptr) {
+      return false;
+    }
+
+    _M_chunks = chunks;
+  }
+
+  chunk& c = _M_chunks[_M_nchunks++];
+
+  c.begin = begin;
+  c.end = end;
+  c.data = nullptr;
+  c.done = false;
+
+  return true;
+}
+
+void* extractor::run(void* arg)
+{
+  extractor* ex = static_cast<extractor*>(arg);
+
+  // Maximum number of chunks processed and not written yet.
+  const size_t window = 2 * ex->_M_nthreads;
+
+  pthread_mutex_lock(&ex->_M_mutex);
+
+  do {
+    // Wait until the chunk can be processed.
+    while ((!ex->_M_stop) &&
+           (ex->_M_next < ex->_M_nchunks) &&
+           (ex->_M_next >= ex->_M_written + window)) {
+      pthread_cond_wait(&ex->_M_written_cond, &ex->_M_mutex);
+    }
+
+    if ((ex->_M_stop) || (ex->_M_next == ex->_M_nchunks)) {
+      break;
+    }
+
+    chunk& c = ex->_M_chunks[ex->_M_next++];
+
+    pthread_mutex_unlock(&ex->_M_mutex);
+
+    ex->process(c);
+
+    pthread_mutex_lock(&ex->_M_mutex);
+
+    c.done = true;
+    pthread_cond_broadcast(&ex->_M_processed);
+  } while (true);
+
+  pthread_mutex_unlock(&ex->_M_mutex);
+
+  return nullptr;
+}
+
+void extractor::process(chunk& c)
+{
+  asn1::ber::column_data* data;
+  if ((data = new (std::nothrow) asn1::ber::column_data[_M_ncolumns]) ==
+      nullptr) {
+    c.error_offset = c.begin;
+    c.e = asn1::ber::error::callback;
+    c.msg = "out of memory";
+
+    return;
+  }
+
+  asn1::ber::column_extractor obj(_M_columns, _M_ncolumns, data);
+
+  size_t off = c.begin;
+
+  while (off < c.end) {
+    // The records of the chunk have already been delimited.
+    uint64_t len = asn1::ber::tlv_length(_M_data + off, c.end - off);
+
+    asn1::ber::memory_reader reader(_M_data + off, len);
+
+    obj.begin_record();
+
+    if (!asn1::ber::decoder::decode(reader, obj)) {
+      c.error_offset = off + obj.error_offset();
+      c.e = obj.last_error();
+      c.msg = obj.error_message();
+
+      delete [] data;
+      return;
+    }
+
+    if (!obj.end_record()) {
+      c.error_offset = off;
+      c.e = asn1::ber::error::callback;
+      c.msg = "out of memory";
+
+      delete [] data;
+      return;
+    }
+
+    off += len;
+  }
+
+  c.data = data;
+}
+
+bool extractor::write(const char* dir, uint64_t& records)
+{
+  asn1::ber::column_writer* writers;
+  if ((writers = new (std::nothrow) asn1::ber::column_writer[_M_ncolumns]) ==
+      nullptr) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < _M_ncolumns; i++) {
+    if (!writers[i].open(dir, _M_columns[i])) {
+      fprintf(stderr,
+              "Error creating the files of the column '%s'.\n",
+              _M_columns[i].name);
+
+      delete [] writers;
+      return false;
+    }
+  }
+
+  records = 0;
+
+  for (size_t i = 0; i < _M_nchunks; i++) {
+    chunk& c = _M_chunks[i];
+
+    // Wait for the chunk to be processed.
+    pthread_mutex_lock(&_M_mutex);
+
+    while (!c.done) {
+      pthread_cond_wait(&_M_processed, &_M_mutex);
+    }
+
+    pthread_mutex_unlock(&_M_mutex);
+
+    if (!c.data) {
+      if (c.msg) {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu, message: '%s'.\n",
+                to_string(c.e),
+                c.error_offset,
+                c.msg);
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu.\n",
+                to_string(c.e),
+                c.error_offset);
+      }
+
+      delete [] writers;
+      return false;
+    }
+
+    for (size_t j = 0; j < _M_ncolumns; j++) {
+      if (!writers[j].write(c.data[j])) {
+        fprintf(stderr,
+                "Error writing the column '%s'.\n",
+                _M_columns[j].name);
+
+        delete [] writers;
+        return false;
+      }
+    }
+
+    records += c.data[0].records();
+
+    delete [] c.data;
+    c.data = nullptr;
+
+    pthread_mutex_lock(&_M_mutex);
+
+    _M_written++;
+    pthread_cond_broadcast(&_M_written_cond);
+
+    pthread_mutex_unlock(&_M_mutex);
+  }
+
+  for (size_t i = 0; i < _M_ncolumns; i++) {
+    if (!writers[i].close()) {
+      fprintf(stderr,
+              "Error writing the column '%s'.\n",
+              _M_columns[i].name);
+
+      delete [] writers;
+      return false;
+    }
+  }
+
+  delete [] writers;
+
+  return true;
+}
+
+bool extractor::write_manifest(const char* dir, uint64_t records) const
+{
+  char filename[PATH_MAX];
+  if (snprintf(filename,
+               sizeof(filename),
+               "%s/manifest",
+               dir) >= static_cast<int>(sizeof(filename))) {
+    return false;
+  }
+
+  FILE* file;
+  if ((file = fopen(filename, "w")) == nullptr) {
+    return false;
+  }
+
+  fprintf(file, "records %llu\n", static_cast<unsigned long long>(records));
+
+  for (size_t i = 0; i < _M_ncolumns; i++) {
+    char path[1024];
+    _M_columns[i].path.print(path, sizeof(path));
+
+    fprintf(file,
+            "column %s %s %s\n",
+            _M_columns[i].name,
+            to_string(_M_columns[i].type),
+            path);
+  }
+
+  return (fclose(file) == 0);
+}
+
+// Parse column ("<name>:<type>:<path>").
+static bool parse_column(char* s, asn1::ber::column& c)
+{
+  char* type;
+  char* path;
+  if (((type = strchr(s, ':')) == nullptr) ||
+      ((path = strchr(type + 1, ':')) == nullptr)) {
+    return false;
+  }
+
+  *type++ = 0;
+  *path++ = 0;
+
+  // Check name.
+  if (!*s) {
+    return false;
+  }
+
+  for (const char* ptr = s; *ptr; ptr++) {
+    if ((!isalnum(*ptr)) && (*ptr != '_') && (*ptr != '-')) {
+      return false;
+    }
+  }
+
+  c.name = s;
+
+  if (strcmp(type, "int64") == 0) {
+    c.type = asn1::ber::column_type::Int64;
+  } else if (strcmp(type, "string") == 0) {
+    c.type = asn1::ber::column_type::String;
+  } else if (strcmp(type, "time") == 0) {
+    c.type = asn1::ber::column_type::Time;
+  } else {
+    return false;
+  }
+
+  return c.path.parse(path);
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [OPTIONS] --output <directory> "
+          "--column <name>:<type>:<path> ... <filename>\n"
+          "\n"
+          "Extracts the values at the given paths of each record into one\n"
+          "file per column.\n"
+          "\n"
+          "Options:\n"
+          "  --output <directory>           Output directory.\n"
+          "  --column <name>:<type>:<path>  Column (up to %zu):\n"
+          "                                   <type>: int64, string or time.\n"
+          "                                   <path>: tags from the record,\n"
+          "                                   \"[APPLICATION 1]/[3]\".\n"
+          "  --threads <n>                  Number of threads (default:\n"
+          "                                 number of CPUs).\n",
+          program,
+          asn1::ber::column_extractor::max_columns);
+}
+
+int main(int argc, char** argv)
+{
+  static asn1::ber::column columns[asn1::ber::column_extractor::max_columns];
+  size_t ncolumns = 0;
+
+  const char* filename = nullptr;
+  const char* dir = nullptr;
+
+  long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      dir = argv[++i];
+    } else if ((strcmp(argv[i], "--column") == 0) && (i + 1 < argc)) {
+      if (ncolumns == asn1::ber::column_extractor::max_columns) {
+        fprintf(stderr, "Too many columns.\n");
+        return -1;
+      }
+
+      // The name of the column points to the copy.
+      char* column;
+      if ((column = strdup(argv[++i])) == nullptr) {
+        fprintf(stderr, "Error allocating memory.\n");
+        return -1;
+      }
+
+      if (!parse_column(column, columns[ncolumns])) {
+        fprintf(stderr, "Invalid column '%s'.\n", argv[i]);
+
+        free(column);
+        return -1;
+      }
+
+      for (size_t j = 0; j < ncolumns; j++) {
+        if (strcmp(columns[j].name, columns[ncolumns].name) == 0) {
+          fprintf(stderr, "Duplicated column '%s'.\n", columns[j].name);
+          return -1;
+        }
+      }
+
+      ncolumns++;
+    } else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc)) {
+      char* end;
+      nthreads = strtol(argv[++i], &end, 10);
+      if ((*end) || (nthreads < 1) || (nthreads > max_threads)) {
+        usage(argv[0]);
+        return -1;
+      }
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if ((!filename) || (!dir) || (ncolumns == 0)) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  if (nthreads < 1) {
+    nthreads = 1;
+  } else if (nthreads > max_threads) {
+    nthreads = max_threads;
+  }
+
+  // Create output directory.
+  if ((mkdir(dir, 0755) != 0) && (errno != EEXIST)) {
+    fprintf(stderr, "Error creating directory '%s'.\n", dir);
+    return -1;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  extractor ex(file.data(), file.size(), columns, ncolumns, nthreads);
+  return ex.extract(dir) ? 0 : -1;
+}
@@ -6,8 +6,20 @@
 #include <unistd.h>
 #include <sys/stat.h>
 #include <sys/mman.h>
+#include <pthread.h>
+#include <string.h>
+#include <time.h>
 #include <inttypes.h>
+#include <errno.h>
+#include <limits.h>
 #include "asn1/ber/decoder.h"
+#include "asn1/ber/buffered_writer.h"
+#include "asn1/ber/index.h"
+#include "asn1/ber/columns.h"
+#include "asn1/ber/sync.h"
+#include "asn1/ber/json.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/null_object.h"
 
 class reader {
   public:
@@ -92,6 +104,35 @@ class reader {
       return _M_ptr - static_cast<const uint8_t*>(_M_buf);
     }
 
+    // Set offset.
+    bool seek(size_t off)
+    {
+      if (off <= _M_filesize) {
+        _M_ptr = static_cast<const uint8_t*>(_M_buf) + off;
+        return true;
+      }
+
+      return false;
+    }
+
+    // Get pointer to the next character.
+    const uint8_t* current() const
+    {
+      return _M_ptr;
+    }
+
+    // Get data.
+    const uint8_t* data() const
+    {
+      return static_cast<const uint8_t*>(_M_buf);
+    }
+
+    // Get file size.
+    size_t size() const
+    {
+      return _M_filesize;
+    }
+
   private:
     int _M_fd = -1;
 
@@ -107,10 +148,16 @@ class reader {
     reader& operator=(const reader&) = delete;
 };
 
+// Output of the printed records.
+typedef asn1::ber::buffered_writer<1024 * 1024> output;
+
 class asn1_object {
   public:
     // Constructor.
-    asn1_object() = default;
+    asn1_object(output& out)
+      : _M_out(out)
+    {
+    }
 
     // Destructor.
     ~asn1_object() = default;
@@ -129,34 +176,20 @@ class asn1_object {
     {
       indent();
 
+      tag(tc, tn);
+
       if (valuelen != asn1::ber::decoder::indefinite_length) {
-        // Universal class?
-        if (tc == asn1::ber::tag_class::Universal) {
-          printf("%s: %s, header length (TL): %lu, total length (TLV): %lu\n",
-                 to_string(tc),
-                 to_string(static_cast<asn1::ber::universal_class>(tn)),
-                 totallen - valuelen,
-                 totallen);
-        } else {
-          printf("%s: %lu, header length (TL): %lu, total length (TLV): %lu\n",
-                 to_string(tc),
-                 tn,
-                 totallen - valuelen,
-                 totallen);
-        }
+        _M_out.write(", header length (TL): ");
+        _M_out.unsigned_integer(totallen - valuelen);
+        _M_out.write(", total length (TLV): ");
+        _M_out.unsigned_integer(totallen);
+        _M_out.put('\n');
       } else {
-        // Universal class?
-        if (tc == asn1::ber::tag_class::Universal) {
-          printf("%s: %s, indefinite length\n",
-                 to_string(tc),
-                 to_string(static_cast<asn1::ber::universal_class>(tn)));
-        } else {
-          printf("%s: %lu, indefinite length\n", to_string(tc), tn);
-        }
+        _M_out.write(", indefinite length\n");
       }
 
       indent();
-      printf("{\n");
+      _M_out.write("{\n");
 
       _M_depth++;
 
@@ -172,10 +205,14 @@ class asn1_object {
         _M_depth--;
 
         indent();
-        printf("} /* total length (TLV): %lu */\n", totallen);
+        _M_out.write("} /* total length (TLV): ");
+        _M_out.unsigned_integer(totallen);
+        _M_out.write(" */\n");
 
         return true;
       } else {
+        _M_out.flush();
+
         fprintf(stderr, "End-of-constructed while having depth 0.\n");
         return false;
       }
@@ -184,7 +221,9 @@ class asn1_object {
     // Boolean.
     bool boolean(const void* buf, uint64_t len, bool val)
     {
-      print("Boolean", buf, len, "%s", val ? "true" : "false");
+      begin_value("Boolean", len);
+      _M_out.write(val ? "true" : "false");
+      end_value(buf, len);
 
       return true;
     }
@@ -192,7 +231,9 @@ class asn1_object {
     // Integer.
     bool integer(const void* buf, uint64_t len, int64_t val)
     {
-      print("Integer", buf, len, "%ld", val);
+      begin_value("Integer", len);
+      _M_out.integer(val);
+      end_value(buf, len);
 
       return true;
     }
@@ -201,7 +242,7 @@ class asn1_object {
     bool null()
     {
       indent();
-      printf("[Null]\n");
+      _M_out.write("[Null]\n");
 
       return true;
     }
@@ -215,10 +256,14 @@ class asn1_object {
       indent();
 
       for (size_t i = 0; i < ncomponents; i++) {
-        printf("%s%" PRIu64, (i > 0) ? "." : "", oid[i]);
+        if (i > 0) {
+          _M_out.put('.');
+        }
+
+        _M_out.unsigned_integer(oid[i]);
       }
 
-      printf("\n");
+      _M_out.put('\n');
 
       return true;
     }
@@ -226,7 +271,20 @@ class asn1_object {
     // Real.
     bool real(const void* buf, uint64_t len, double val)
     {
-      print("Real", buf, len, "%e", val);
+      begin_value("Real", len);
+
+      // Reals are rare, format them with snprintf().
+      static const size_t max_real_len = 32;
+
+      char* ptr;
+      if ((ptr = _M_out.reserve(max_real_len)) != nullptr) {
+        int n = snprintf(ptr, max_real_len, "%e", val);
+        if ((n > 0) && (static_cast<size_t>(n) < max_real_len)) {
+          _M_out.commit(n);
+        }
+      }
+
+      end_value(buf, len);
 
       return true;
     }
@@ -234,7 +292,9 @@ class asn1_object {
     // Enumerated.
     bool enumerated(const void* buf, uint64_t len, int64_t val)
     {
-      print("Enumerated", buf, len, "%ld", val);
+      begin_value("Enumerated", len);
+      _M_out.integer(val);
+      end_value(buf, len);
 
       return true;
     }
@@ -245,16 +305,9 @@ class asn1_object {
       struct tm tm;
       gmtime_r(&val, &tm);
 
-      print("UTC time",
-            buf,
-            len,
-            "%04u/%02u/%02u %02u:%02u:%02u",
-            1900 + tm.tm_year,
-            1 + tm.tm_mon,
-            tm.tm_mday,
-            tm.tm_hour,
-            tm.tm_min,
-            tm.tm_sec);
+      begin_value("UTC time", len);
+      date_time(tm);
+      end_value(buf, len);
 
       return true;
     }
@@ -267,17 +320,11 @@ class asn1_object {
       struct tm tm;
       gmtime_r(&val.tv_sec, &tm);
 
-      print("Generalized time",
-            buf,
-            len,
-            "%04u/%02u/%02u %02u:%02u:%02u.%u",
-            1900 + tm.tm_year,
-            1 + tm.tm_mon,
-            tm.tm_mday,
-            tm.tm_hour,
-            tm.tm_min,
-            tm.tm_sec,
-            val.tv_usec);
+      begin_value("Generalized time", len);
+      date_time(tm);
+      _M_out.put('.');
+      _M_out.unsigned_integer(static_cast<unsigned>(val.tv_usec));
+      end_value(buf, len);
 
       return true;
     }
@@ -294,38 +341,42 @@ class asn1_object {
       if (valueoff == 0) {
         indent();
 
+        _M_out.write("[Primitive] Tag class: ");
+        _M_out.write(to_string(tc));
+
         // Universal class?
         if (tc == asn1::ber::tag_class::Universal) {
-          printf("[Primitive] Tag class: %s, tag: %s\n",
-                 to_string(tc),
-                 to_string(static_cast<asn1::ber::universal_class>(tn)));
+          _M_out.write(", tag: ");
+          _M_out.write(
+            to_string(static_cast<asn1::ber::universal_class>(tn))
+          );
         } else {
-          printf("[Primitive] Tag class: %s, tag number: %lu\n",
-                 to_string(tc),
-                 tn);
+          _M_out.write(", tag number: ");
+          _M_out.unsigned_integer(tn);
         }
+
+        _M_out.put('\n');
       } else {
         indent();
-        spaces(indent_size);
-        printf("=================================================\n");
+        _M_out.spaces(indent_size);
+        _M_out.write("=================================================\n");
       }
 
       indent();
-      spaces(indent_size);
+      _M_out.spaces(indent_size);
 
-      printf("Value %lu-%lu/%lu:\n", valueoff + 1, valueoff + len, valuelen);
+      _M_out.write("Value ");
+      range(valueoff, len, valuelen);
 
       ascii_dump(buf, len);
 
-      printf("\n");
+      _M_out.put('\n');
 
       indent();
-      spaces(indent_size);
+      _M_out.spaces(indent_size);
 
-      printf("Hexadecimal %lu-%lu/%lu:\n",
-             valueoff + 1,
-             valueoff + len,
-             valuelen);
+      _M_out.write("Hexadecimal ");
+      range(valueoff, len, valuelen);
 
       hexdump(buf, len);
 
@@ -335,6 +386,9 @@ class asn1_object {
     // Error.
     void error(asn1::ber::error e, uint64_t offset, const char* msg = nullptr)
     {
+      // Keep the order of the output and the errors.
+      _M_out.flush();
+
       if (msg) {
         fprintf(stderr,
                 "Error: %s, at offset: %lu, message: '%s'.\n",
@@ -356,135 +410,2074 @@ class asn1_object {
     static const size_t
            number_ascii_chars_per_line = (number_hex_chars_per_line * 3) - 1;
 
+    output& _M_out;
+
     size_t _M_depth = 0;
 
     size_t _M_initial_offset;
 
-    // Print.
-    void print(const char* type,
-               const void* buf,
-               uint64_t len,
-               const char* format,
-               ...) const
+    // Print tag.
+    void tag(asn1::ber::tag_class tc, asn1::ber::tag_number tn)
     {
-      indent();
-      printf("[%s] Length: %lu\n", type, len);
+      _M_out.write(to_string(tc));
+      _M_out.write(": ");
 
-      indent();
-      spaces(indent_size);
-      printf("Value:\n");
+      // Universal class?
+      if (tc == asn1::ber::tag_class::Universal) {
+        _M_out.write(to_string(static_cast<asn1::ber::universal_class>(tn)));
+      } else {
+        _M_out.unsigned_integer(tn);
+      }
+    }
 
+    // Print the beginning of a value (up to the value itself).
+    void begin_value(const char* type, uint64_t len)
+    {
       indent();
-      spaces(2 * indent_size);
-
-      va_list ap;
-      va_start(ap, format);
+      _M_out.put('[');
+      _M_out.write(type);
+      _M_out.write("] Length: ");
+      _M_out.unsigned_integer(len);
+      _M_out.put('\n');
 
-      vprintf(format, ap);
+      indent();
+      _M_out.spaces(indent_size);
+      _M_out.write("Value:\n");
 
-      va_end(ap);
+      indent();
+      _M_out.spaces(2 * indent_size);
+    }
 
-      printf("\n\n");
+    // Print the end of a value (after the value itself).
+    void end_value(const void* buf, uint64_t len)
+    {
+      _M_out.write("\n\n");
 
       indent();
-      spaces(indent_size);
-      printf("Hexadecimal:\n");
+      _M_out.spaces(indent_size);
+      _M_out.write("Hexadecimal:\n");
 
       hexdump(buf, len);
     }
 
+    // Print date and time ("YYYY/MM/DD hh:mm:ss").
+    void date_time(const struct tm& tm)
+    {
+      _M_out.unsigned_integer(static_cast<unsigned>(1900 + tm.tm_year), 4);
+      _M_out.put('/');
+      _M_out.unsigned_integer(static_cast<unsigned>(1 + tm.tm_mon), 2);
+      _M_out.put('/');
+      _M_out.unsigned_integer(static_cast<unsigned>(tm.tm_mday), 2);
+      _M_out.put(' ');
+      _M_out.unsigned_integer(static_cast<unsigned>(tm.tm_hour), 2);
+      _M_out.put(':');
+      _M_out.unsigned_integer(static_cast<unsigned>(tm.tm_min), 2);
+      _M_out.put(':');
+      _M_out.unsigned_integer(static_cast<unsigned>(tm.tm_sec), 2);
+    }
+
+    // Print range of a chunk of a primitive value ("first-last/total:").
+    void range(uint64_t valueoff, uint64_t len, uint64_t valuelen)
+    {
+      _M_out.unsigned_integer(valueoff + 1);
+      _M_out.put('-');
+      _M_out.unsigned_integer(valueoff + len);
+      _M_out.put('/');
+      _M_out.unsigned_integer(valuelen);
+      _M_out.write(":\n");
+    }
+
     // Hexadecimal dump.
-    void hexdump(const void* buf, size_t len) const
+    void hexdump(const void* buf, size_t len)
     {
       const uint8_t* const b = static_cast<const uint8_t*>(buf);
 
       for (size_t i = 0; i < len; i++) {
         if ((i % number_hex_chars_per_line) == 0) {
           if (i > 0) {
-            printf("\n");
+            _M_out.put('\n');
           }
 
           indent();
-          spaces(2 * indent_size);
-
-          printf("%02x", b[i]);
+          _M_out.spaces(2 * indent_size);
         } else {
-          printf(" %02x", b[i]);
+          _M_out.put(' ');
         }
+
+        _M_out.hex(b[i]);
       }
 
-      printf("\n");
+      _M_out.put('\n');
     }
 
     // ASCII dump.
-    void ascii_dump(const void* buf, size_t len) const
+    void ascii_dump(const void* buf, size_t len)
     {
-      const char* const b = static_cast<const char*>(buf);
+      const uint8_t* b = static_cast<const uint8_t*>(buf);
 
-      for (size_t i = 0; i < len; i++) {
-        if ((i % number_ascii_chars_per_line) == 0) {
-          if (i > 0) {
-            printf("\n");
-          }
+      while (len > 0) {
+        indent();
+        _M_out.spaces(2 * indent_size);
 
-          indent();
-          spaces(2 * indent_size);
+        size_t n = (len < number_ascii_chars_per_line) ?
+                     len :
+                     number_ascii_chars_per_line;
+
+        char* ptr;
+        if ((ptr = _M_out.reserve(n)) == nullptr) {
+          return;
         }
 
-        if (isprint(b[i])) {
-          printf("%c", b[i]);
-        } else {
-          printf(".");
+        // Replace the non-printable characters (isprint() in the "C"
+        // locale) with '.'.
+        for (size_t i = 0; i < n; i++) {
+          ptr[i] = ((b[i] >= 0x20) && (b[i] < 0x7f)) ?
+                     static_cast<char>(b[i]) :
+                     '.';
+        }
+
+        _M_out.commit(n);
+
+        b += n;
+        len -= n;
+
+        if (len > 0) {
+          _M_out.put('\n');
         }
       }
 
-      printf("\n");
+      _M_out.put('\n');
     }
 
     // Indent.
-    void indent() const
+    void indent()
+    {
+      _M_out.spaces(_M_depth * indent_size);
+    }
+};
+
+// Latency histogram with logarithmic buckets (each power of two is divided
+// in 'number_sub_buckets' linear sub-buckets, so the relative error is lower
+// than 1 / number_sub_buckets).
+class latency_histogram {
+  public:
+    // Constructor.
+    latency_histogram() = default;
+
+    // Destructor.
+    ~latency_histogram() = default;
+
+    // Record value.
+    void record(uint64_t value)
+    {
+      _M_counts[bucket(value)]++;
+
+      if (_M_count++ > 0) {
+        if (value < _M_min) {
+          _M_min = value;
+        } else if (value > _M_max) {
+          _M_max = value;
+        }
+      } else {
+        _M_min = value;
+        _M_max = value;
+      }
+
+      _M_sum += value;
+    }
+
+    // Get number of values.
+    uint64_t count() const
+    {
+      return _M_count;
+    }
+
+    // Get minimum value.
+    uint64_t min() const
+    {
+      return _M_min;
+    }
+
+    // Get maximum value.
+    uint64_t max() const
+    {
+      return _M_max;
+    }
+
+    // Get mean.
+    double mean() const
+    {
+      return (_M_count > 0) ? static_cast<double>(_M_sum) / _M_count : 0.0;
+    }
+
+    // Get the value at 'percentile' (highest value of the bucket).
+    uint64_t percentile(double percentile) const
+    {
+      if (_M_count > 0) {
+        uint64_t rank = static_cast<uint64_t>((percentile / 100.0) * _M_count);
+        if (rank >= _M_count) {
+          rank = _M_count - 1;
+        }
+
+        uint64_t count = 0;
+        for (size_t i = 0; i < number_buckets; i++) {
+          if ((count += _M_counts[i]) > rank) {
+            uint64_t value = highest_value(i);
+            return (value < _M_max) ? value : _M_max;
+          }
+        }
+      }
+
+      return _M_max;
+    }
+
+    // Print the histogram (one line per power of two).
+    void print(FILE* file) const
+    {
+      static const size_t bar_width = 40;
+
+      uint64_t counts[64 - sub_bucket_bits + 1];
+      uint64_t max = 0;
+
+      for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        counts[i] = 0;
+
+        for (size_t j = 0; j < number_sub_buckets; j++) {
+          counts[i] += _M_counts[(i << sub_bucket_bits) + j];
+        }
+
+        if (counts[i] > max) {
+          max = counts[i];
+        }
+      }
+
+      for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        if (counts[i] > 0) {
+          char bar[bar_width + 1];
+          size_t width = (counts[i] * bar_width + max - 1) / max;
+
+          memset(bar, '#', width);
+          bar[width] = 0;
+
+          fprintf(file,
+                  "  %12llu - %12llu ns: %12llu %s\n",
+                  static_cast<unsigned long long>(
+                    lowest_value(i << sub_bucket_bits)
+                  ),
+                  static_cast<unsigned long long>(
+                    highest_value((i << sub_bucket_bits) +
+                                  (number_sub_buckets - 1))
+                  ),
+                  static_cast<unsigned long long>(counts[i]),
+                  bar);
+        }
+      }
+    }
+
+  private:
+    static const unsigned sub_bucket_bits = 4;
+    static const uint64_t number_sub_buckets = 1 << sub_bucket_bits;
+
+    // Values lower than 'number_sub_buckets' have their own bucket, the
+    // values of each of the following powers of two share
+    // 'number_sub_buckets' buckets.
+    static const size_t number_buckets = (64 - sub_bucket_bits + 1) *
+                                         number_sub_buckets;
+
+    uint64_t _M_counts[number_buckets] = {0};
+
+    uint64_t _M_count = 0;
+    uint64_t _M_min = 0;
+    uint64_t _M_max = 0;
+    uint64_t _M_sum = 0;
+
+    // Get bucket of a value.
+    static size_t bucket(uint64_t value)
+    {
+      if (value < number_sub_buckets) {
+        return value;
+      }
+
+      unsigned shift = (63 - __builtin_clzll(value)) - sub_bucket_bits;
+
+      return ((shift + 1) << sub_bucket_bits) +
+             ((value >> shift) - number_sub_buckets);
+    }
+
+    // Get lowest value of a bucket.
+    static uint64_t lowest_value(size_t bucket)
     {
-      spaces(_M_depth * indent_size);
+      if (bucket < number_sub_buckets) {
+        return bucket;
+      }
+
+      unsigned shift = (bucket >> sub_bucket_bits) - 1;
+
+      return ((bucket & (number_sub_buckets - 1)) + number_sub_buckets) <<
+             shift;
     }
 
-    // Write spaces.
-    static void spaces(size_t count)
+    // Get highest value of a bucket.
+    static uint64_t highest_value(size_t bucket)
     {
-      for (size_t i = 0; i < count; i++) {
-        printf(" ");
+      if (bucket < number_sub_buckets) {
+        return bucket;
       }
+
+      unsigned shift = (bucket >> sub_bucket_bits) - 1;
+
+      return lowest_value(bucket) + ((static_cast<uint64_t>(1) << shift) - 1);
     }
 };
 
-int main(int argc, const char** argv)
+// ASN.1 object which counts the tags.
+class tag_counter : public asn1::ber::null_object {
+  public:
+    struct tag {
+      asn1::ber::tag_class tc;
+      asn1::ber::tag_number tn;
+
+      uint64_t count;
+    };
+
+    // Constructor.
+    tag_counter() = default;
+
+    // Destructor.
+    ~tag_counter()
+    {
+      if (_M_tags) {
+        free(_M_tags);
+      }
+    }
+
+    // Start constructed.
+    bool start_constructed(asn1::ber::tag_class tc,
+                           asn1::ber::tag_number tn,
+                           uint64_t valuelen,
+                           uint64_t totallen)
+    {
+      return count(tc, tn);
+    }
+
+    // Boolean.
+    bool boolean(const void* buf, uint64_t len, bool val)
+    {
+      return count(asn1::ber::universal_class::Boolean);
+    }
+
+    // Integer.
+    bool integer(const void* buf, uint64_t len, int64_t val)
+    {
+      return count(asn1::ber::universal_class::Integer);
+    }
+
+    // Null.
+    bool null()
+    {
+      return count(asn1::ber::universal_class::Null);
+    }
+
+    // Object identifier.
+    bool oid(const void* buf,
+             uint64_t len,
+             const uint64_t* oid,
+             size_t ncomponents)
+    {
+      return count(asn1::ber::universal_class::ObjectIdentifier);
+    }
+
+    // Real.
+    bool real(const void* buf, uint64_t len, double val)
+    {
+      return count(asn1::ber::universal_class::Real);
+    }
+
+    // Enumerated.
+    bool enumerated(const void* buf, uint64_t len, int64_t val)
+    {
+      return count(asn1::ber::universal_class::Enumerated);
+    }
+
+    // UTC time.
+    bool utc_time(const void* buf, uint64_t len, time_t val)
+    {
+      return count(asn1::ber::universal_class::UTCTime);
+    }
+
+    // Generalized time.
+    bool generalized_time(const void* buf,
+                          uint64_t len,
+                          const struct timeval& val)
+    {
+      return count(asn1::ber::universal_class::GeneralizedTime);
+    }
+
+    // Primitive.
+    bool primitive(asn1::ber::tag_class tc,
+                   asn1::ber::tag_number tn,
+                   const void* buf,
+                   uint64_t len,
+                   uint64_t valueoff,
+                   uint64_t valuelen)
+    {
+      return (valueoff == 0) ? count(tc, tn) : true;
+    }
+
+    // Print the tags sorted by number of values.
+    void print(FILE* file) const;
+
+  private:
+    static const size_t max_printed_tags = 32;
+
+    tag* _M_tags = nullptr;
+    size_t _M_size = 0;
+    size_t _M_used = 0;
+
+    // Hash.
+    static size_t hash(asn1::ber::tag_class tc, asn1::ber::tag_number tn)
+    {
+      uint64_t h = (tn << 2) | static_cast<uint8_t>(tc);
+      h *= 0x9e3779b97f4a7c15ull;
+
+      return h ^ (h >> 32);
+    }
+
+    // Count value.
+    bool count(asn1::ber::tag_class tc, asn1::ber::tag_number tn);
+
+    bool count(asn1::ber::universal_class uc)
+    {
+      return count(asn1::ber::tag_class::Universal,
+                   static_cast<asn1::ber::tag_number>(uc));
+    }
+};
+
+bool tag_counter::count(asn1::ber::tag_class tc, asn1::ber::tag_number tn)
 {
-  if (argc == 2) {
-    reader reader;
-    if (reader.open(argv[1])) {
-      do {
-        asn1_object obj;
-
-        // Set initial offset.
-        obj.initial_offset(reader.offset());
-
-        // Decode.
-        if (asn1::ber::decoder::decode(reader, obj)) {
-          // End of file?
-          if (reader.eof()) {
-            return 0;
-          } else {
-            printf("========================================\n");
-          }
-        } else {
-          fprintf(stderr, "Error decoding.\n");
-          break;
+  // Open addressing hash table (linear probing), kept at most half full.
+  if (_M_used >= _M_size / 2) {
+    size_t size = (_M_size > 0) ? _M_size * 2 : 256;
+
+    tag* tags;
+    if ((tags = static_cast<tag*>(calloc(size, sizeof(tag)))) == nullptr) {
+      return false;
+    }
+
+    for (size_t i = 0; i < _M_size; i++) {
+      if (_M_tags[i].count > 0) {
+        size_t pos = hash(_M_tags[i].tc, _M_tags[i].tn) & (size - 1);
+        while (tags[pos].count > 0) {
+          pos = (pos + 1) & (size - 1);
         }
-      } while (true);
+
+        tags[pos] = _M_tags[i];
+      }
+    }
+
+    if (_M_tags) {
+      free(_M_tags);
+    }
+
+    _M_tags = tags;
+    _M_size = size;
+  }
+
+  size_t pos = hash(tc, tn) & (_M_size - 1);
+  while (_M_tags[pos].count > 0) {
+    if ((_M_tags[pos].tc == tc) && (_M_tags[pos].tn == tn)) {
+      _M_tags[pos].count++;
+      return true;
+    }
+
+    pos = (pos + 1) & (_M_size - 1);
+  }
+
+  _M_tags[pos].tc = tc;
+  _M_tags[pos].tn = tn;
+  _M_tags[pos].count = 1;
+
+  _M_used++;
+
+  return true;
+}
+
+void tag_counter::print(FILE* file) const
+{
+  // Sort the tags by number of values.
+  tag* tags;
+  if ((tags = static_cast<tag*>(malloc(_M_used * sizeof(tag)))) == nullptr) {
+    return;
+  }
+
+  uint64_t total = 0;
+
+  for (size_t i = 0, j = 0; i < _M_size; i++) {
+    if (_M_tags[i].count > 0) {
+      tags[j++] = _M_tags[i];
+      total += _M_tags[i].count;
+    }
+  }
+
+  qsort(tags, _M_used, sizeof(tag), [](const void* a, const void* b) {
+    const tag* x = static_cast<const tag*>(a);
+    const tag* y = static_cast<const tag*>(b);
+
+    return (x->count > y->count) ? -1 : (x->count < y->count);
+  });
+
+  for (size_t i = 0; i < _M_used; i++) {
+    if (i == max_printed_tags) {
+      fprintf(file, "  (%zu more tags)\n", _M_used - i);
+      break;
+    }
+
+    char name[64];
+    if (tags[i].tc == asn1::ber::tag_class::Universal) {
+      snprintf(name,
+               sizeof(name),
+               "[UNIVERSAL %s]",
+               to_string(static_cast<asn1::ber::universal_class>(tags[i].tn)));
+    } else {
+      snprintf(name,
+               sizeof(name),
+               "[%s %llu]",
+               to_string(tags[i].tc),
+               static_cast<unsigned long long>(tags[i].tn));
+    }
+
+    fprintf(file,
+            "  %-36s %14llu %6.2f%%\n",
+            name,
+            static_cast<unsigned long long>(tags[i].count),
+            (100.0 * tags[i].count) / total);
+  }
+
+  free(tags);
+}
+
+// Slowest records.
+class slowest_records {
+  public:
+    struct record {
+      size_t offset;
+      size_t length;
+      uint64_t ns;
+    };
+
+    // Constructor.
+    slowest_records() = default;
+
+    // Destructor.
+    ~slowest_records() = default;
+
+    // Add record.
+    void add(size_t offset, size_t length, uint64_t ns)
+    {
+      // If the record is not slower than the slowest records...
+      if ((_M_count == max_records) && (ns <= _M_records[_M_count - 1].ns)) {
+        return;
+      }
+
+      // Insert the record keeping the records sorted.
+      size_t i = (_M_count < max_records) ? _M_count++ : _M_count - 1;
+      for (; (i > 0) && (_M_records[i - 1].ns < ns); i--) {
+        _M_records[i] = _M_records[i - 1];
+      }
+
+      _M_records[i].offset = offset;
+      _M_records[i].length = length;
+      _M_records[i].ns = ns;
+    }
+
+    // Print.
+    void print(FILE* file) const
+    {
+      for (size_t i = 0; i < _M_count; i++) {
+        fprintf(file,
+                "  offset: %12zu, length: %10zu, %12llu ns\n",
+                _M_records[i].offset,
+                _M_records[i].length,
+                static_cast<unsigned long long>(_M_records[i].ns));
+      }
+    }
+
+  private:
+    static const size_t max_records = 10;
+
+    record _M_records[max_records];
+    size_t _M_count = 0;
+};
+
+// Maximum number of threads.
+static const long max_threads = 256;
+
+// Selection of the records to print.
+enum class selector {
+  None,
+  Record,
+  Offset,
+  Key,
+  TimeRange
+};
+
+// Get monotonic time in nanoseconds.
+static uint64_t now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ull) + ts.tv_nsec;
+}
+
+// Decode and print the records.
+static bool print_records(reader& reader)
+{
+  output out;
+
+  // Flush the output after each record if it is a terminal.
+  const bool interactive = isatty(STDOUT_FILENO);
+
+  do {
+    asn1_object obj(out);
+
+    // Set initial offset.
+    obj.initial_offset(reader.offset());
+
+    // Decode.
+    if (asn1::ber::decoder::decode(reader, obj)) {
+      // End of file?
+      if (reader.eof()) {
+        if (!out.flush()) {
+          fprintf(stderr, "Error writing output.\n");
+          return false;
+        }
+
+#ifdef ASN1_BER_STATISTICS
+        asn1::ber::decoder::statistics().print(stderr);
+#endif
+
+        return true;
+      } else {
+        out.write("========================================\n");
+
+        if ((interactive) && (!out.flush())) {
+          fprintf(stderr, "Error writing output.\n");
+          return false;
+        }
+      }
+    } else {
+      out.flush();
+
+      fprintf(stderr, "Error decoding.\n");
+      return false;
+    }
+  } while (true);
+}
+
+// Decode the records and print them in JSON (one object per line).
+static bool print_json(reader& reader,
+                       asn1::ber::json_object<output>::binary_encoding enc)
+{
+  output out;
+
+  // Flush the output after each record if it is a terminal.
+  const bool interactive = isatty(STDOUT_FILENO);
+
+  do {
+    asn1::ber::json_object<output> obj(out, enc);
+
+    size_t offset = reader.offset();
+
+    // Decode.
+    if (asn1::ber::decoder::decode(reader, obj)) {
+      if ((out.error()) || ((interactive) && (!out.flush()))) {
+        fprintf(stderr, "Error writing output.\n");
+        return false;
+      }
+
+      // End of file?
+      if (reader.eof()) {
+        if (!out.flush()) {
+          fprintf(stderr, "Error writing output.\n");
+          return false;
+        }
+
+        return true;
+      }
+    } else {
+      // Terminate the incomplete record.
+      out.put('\n');
+      out.flush();
+
+      if (obj.error_message()) {
+        fprintf(stderr,
+                "Error: %s, at offset: %lu, message: '%s'.\n",
+                to_string(obj.last_error()),
+                offset + obj.error_offset(),
+                obj.error_message());
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %lu.\n",
+                to_string(obj.last_error()),
+                offset + obj.error_offset());
+      }
+
+      fprintf(stderr, "Error decoding.\n");
+      return false;
+    }
+  } while (true);
+}
+
+// Decode the records and print statistics (latency per record, throughput
+// and tag frequencies).
+static bool print_statistics(reader& reader)
+{
+  latency_histogram histogram;
+  slowest_records slowest;
+  tag_counter counter;
+
+  bool ret = true;
+
+  uint64_t start = now();
+
+  while (!reader.eof()) {
+    size_t offset = reader.offset();
+
+    uint64_t t = now();
+
+    if (!asn1::ber::decoder::decode(reader, counter)) {
+      if (counter.error_message()) {
+        fprintf(stderr,
+                "Error: %s, at offset: %lu, message: '%s'.\n",
+                to_string(counter.last_error()),
+                offset + counter.error_offset(),
+                counter.error_message());
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %lu.\n",
+                to_string(counter.last_error()),
+                offset + counter.error_offset());
+      }
+
+      ret = false;
+      break;
+    }
+
+    uint64_t ns = now() - t;
+
+    histogram.record(ns);
+    slowest.add(offset, reader.offset() - offset, ns);
+  }
+
+  double seconds = static_cast<double>(now() - start) / 1000000000.0;
+
+  printf("Records: %llu, bytes: %zu, elapsed: %.3f s\n",
+         static_cast<unsigned long long>(histogram.count()),
+         reader.offset(),
+         seconds);
+
+  if (seconds > 0.0) {
+    printf("Throughput: %.2f MB/s, %.0f records/s\n",
+           reader.offset() / (seconds * 1000000.0),
+           histogram.count() / seconds);
+  }
+
+  if (histogram.count() > 0) {
+    printf("\nDecode latency per record (ns):\n");
+    printf("  min: %llu, mean: %.0f, p50: %llu, p90: %llu, p99: %llu, "
+           "p99.9: %llu, max: %llu\n",
+           static_cast<unsigned long long>(histogram.min()),
+           histogram.mean(),
+           static_cast<unsigned long long>(histogram.percentile(50.0)),
+           static_cast<unsigned long long>(histogram.percentile(90.0)),
+           static_cast<unsigned long long>(histogram.percentile(99.0)),
+           static_cast<unsigned long long>(histogram.percentile(99.9)),
+           static_cast<unsigned long long>(histogram.max()));
+
+    printf("\nLatency histogram:\n");
+    histogram.print(stdout);
+
+    printf("\nSlowest records:\n");
+    slowest.print(stdout);
+
+    printf("\nTags:\n");
+    counter.print(stdout);
+  }
+
+  return ret;
+}
+
+// Delimit the record at 'off' of the 'size' bytes at 'data' (--validate and
+// --recover delimit the records the same way):
+//   - If its headers are invalid, returns 0: the bytes are skipped up to the
+//     next plausible record ('next').
+//   - If it isn't followed by a record (only the headers of the next record
+//     are checked, an invalid record is checked by the caller) but contains
+//     a plausible one (a truncated record whose length takes the beginning
+//     of the next record), returns 0 and sets 'overlap': the record is
+//     skipped up to the plausible record ('next').
+//   - Otherwise, returns the length of the record.
+static uint64_t delimit(const asn1::ber::synchronizer& sync,
+                        const uint8_t* data,
+                        size_t size,
+                        size_t off,
+                        size_t& next,
+                        bool& overlap)
+{
+  uint64_t len, l;
+  if ((len = asn1::ber::tlv_length(data + off, size - off)) != 0) {
+    if ((off + len == size) ||
+        (sync.starts(off + len, l)) ||
+        (!sync.next(off + 1, off + len, next, l))) {
+      return len;
+    }
+
+    overlap = true;
+  } else {
+    if (!sync.next(off + 1, size, next, l)) {
+      next = size;
+    }
+
+    overlap = false;
+  }
+
+  return 0;
+}
+
+// Validator: decodes the records (in parallel) without processing the
+// values.
+class validator {
+  public:
+    // Constructor.
+    validator(const uint8_t* data, size_t size, unsigned nthreads)
+      : _M_data(data),
+        _M_size(size),
+        _M_nthreads(nthreads),
+        _M_sync(data, size)
+    {
+    }
+
+    // Destructor.
+    ~validator();
+
+    // Validate the records.
+    // Returns false on error (the errors are printed).
+    bool validate();
+
+  private:
+    // Size of the chunks of records given to the threads.
+    static const size_t chunk_size = 16 * 1024 * 1024;
+
+    struct error {
+      size_t offset;
+      enum asn1::ber::error e;
+      const char* msg;
+
+      // Number of bytes skipped from 'offset' (0: the record has been
+      // decoded).
+      size_t skipped;
+      bool overlap;
+    };
+
+    struct chunk {
+      // Offsets of the first record and of the end of the last record.
+      size_t begin;
+      size_t end;
+
+      // Number of bytes skipped after the end of the chunk (the end of the
+      // record at 'end' couldn't be found or the record overlaps the next
+      // one).
+      size_t skipped;
+      bool overlap;
+
+      // Offset of the plausible record contained in a record of the chunk
+      // which failed to decode (0: none). The records from it are delimited
+      // again by resync().
+      size_t resync;
+
+      uint64_t records;
+
+      error* errors;
+      size_t nerrors;
+      size_t size;
+    };
+
+    const uint8_t* const _M_data;
+    const size_t _M_size;
+
+    const unsigned _M_nthreads;
+
+    // Finds the next plausible record after an invalid one.
+    const asn1::ber::synchronizer _M_sync;
+
+    chunk* _M_chunks = nullptr;
+    size_t _M_nchunks = 0;
+
+    // Next chunk to be validated.
+    size_t _M_next = 0;
+
+    // Split the records in chunks. The records are delimited with delimit()
+    // (the splitting resumes after the skipped bytes).
+    // Returns the offset up to which the records have been split (the size
+    // of the file unless there is not enough memory).
+    size_t split();
+
+    // Add chunk.
+    bool add_chunk(size_t begin, size_t end);
+
+    // Thread.
+    static void* run(void* arg);
+
+    // Validate the records of a chunk.
+    void validate(chunk& c) const;
+
+    // Validate the record at 'off', delimited and skipped as --recover does
+    // (the errors are added to the chunk).
+    // Returns the offset of the next record; 'skipped' is set if bytes have
+    // been skipped.
+    size_t validate_record(chunk& c, size_t off, bool& skipped) const;
+
+    // After the chunks have been validated, delimit and validate again the
+    // records from the plausible records found by the threads, up to the
+    // start of a chunk or up to 'end' (the chunks walked over are dropped).
+    void resync(size_t end);
+
+    // Add error.
+    static void add_error(chunk& c,
+                          size_t offset,
+                          enum asn1::ber::error e,
+                          const char* msg,
+                          size_t skipped = 0,
+                          bool overlap = false);
+
+    // Print skipped bytes.
+    static void print_skipped(size_t offset, size_t length, bool overlap);
+
+    // Disable copy constructor and assignment operator.
+    validator(const validator&) = delete;
+    validator& operator=(const validator&) = delete;
+};
+
+validator::~validator()
+{
+  if (_M_chunks) {
+    for (size_t i = 0; i < _M_nchunks; i++) {
+      if (_M_chunks[i].errors) {
+        free(_M_chunks[i].errors);
+      }
+    }
+
+    free(_M_chunks);
+  }
+}
+
+bool validator::validate()
+{
+  uint64_t start = now();
+
+  size_t end = split();
+
+  // Start threads (the calling thread also validates chunks).
+  pthread_t threads[max_threads];
+  unsigned nthreads = 0;
+
+  while (nthreads + 1 < _M_nthreads) {
+    if (pthread_create(&threads[nthreads], nullptr, run, this) == 0) {
+      nthreads++;
+    } else {
+      break;
+    }
+  }
+
+  run(this);
+
+  for (unsigned i = 0; i < nthreads; i++) {
+    pthread_join(threads[i], nullptr);
+  }
+
+  resync(end);
+
+  double seconds = static_cast<double>(now() - start) / 1000000000.0;
+
+  // Print the errors (in order).
+  // The records are counted whether they are valid or not; the errors are
+  // the invalid records and the ranges of skipped bytes (which don't belong
+  // to any record).
+  uint64_t records = 0;
+  uint64_t nerrors = 0;
+  uint64_t nranges = 0;
+  uint64_t skipped = 0;
+
+  for (size_t i = 0; i < _M_nchunks; i++) {
+    const chunk& c = _M_chunks[i];
+
+    for (size_t j = 0; j < c.nerrors; j++) {
+      if (c.errors[j].skipped > 0) {
+        print_skipped(c.errors[j].offset,
+                      c.errors[j].skipped,
+                      c.errors[j].overlap);
+
+        nranges++;
+        skipped += c.errors[j].skipped;
+      } else if (c.errors[j].msg) {
+        printf("Error: %s, at offset: %zu, message: '%s'.\n",
+               to_string(c.errors[j].e),
+               c.errors[j].offset,
+               c.errors[j].msg);
+      } else {
+        printf("Error: %s, at offset: %zu.\n",
+               to_string(c.errors[j].e),
+               c.errors[j].offset);
+      }
+    }
+
+    if (c.skipped > 0) {
+      print_skipped(c.end, c.skipped, c.overlap);
+
+      nerrors++;
+      nranges++;
+      skipped += c.skipped;
+    }
+
+    records += c.records;
+    nerrors += c.nerrors;
+  }
+
+  if (end < _M_size) {
+    printf("Error allocating memory (%zu bytes not validated).\n",
+           _M_size - end);
+
+    nerrors++;
+  }
+
+  printf("Records: %llu, errors: %llu, skipped ranges: %llu, "
+         "skipped bytes: %llu, bytes: %zu, elapsed: %.3f s",
+         static_cast<unsigned long long>(records),
+         static_cast<unsigned long long>(nerrors),
+         static_cast<unsigned long long>(nranges),
+         static_cast<unsigned long long>(skipped),
+         _M_size,
+         seconds);
+
+  if (seconds > 0.0) {
+    printf(", %.2f MB/s", _M_size / (seconds * 1000000.0));
+  }
+
+  printf("\n");
+
+  return (nerrors == 0);
+}
+
+size_t validator::split()
+{
+  size_t begin = 0;
+  size_t off = 0;
+
+  while (off < _M_size) {
+    uint64_t len;
+    size_t next;
+    bool overlap;
+    if ((len = delimit(_M_sync, _M_data, _M_size, off, next, overlap)) == 0) {
+      if (!add_chunk(begin, off)) {
+        return begin;
+      }
+
+      _M_chunks[_M_nchunks - 1].skipped = next - off;
+      _M_chunks[_M_nchunks - 1].overlap = overlap;
+
+      begin = next;
+      off = next;
+
+      continue;
+    }
+
+    off += len;
+
+    if (off - begin >= chunk_size) {
+      if (!add_chunk(begin, off)) {
+        return begin;
+      }
+
+      begin = off;
+    }
+  }
+
+  if ((off > begin) && (!add_chunk(begin, off))) {
+    return begin;
+  }
+
+  return off;
+}
+
+bool validator::add_chunk(size_t begin, size_t end)
+{
+  if ((_M_nchunks & (_M_nchunks - 1)) == 0) {
+    size_t size = (_M_nchunks > 0) ? _M_nchunks * 2 : 64;
+
+    chunk* chunks;
+    if ((chunks = static_cast<chunk*>(
+                    realloc(_M_chunks, size * sizeof(chunk))
+                  )) == nullptr) {
+      return false;
+    }
+
+    _M_chunks = chunks;
+  }
+
+  chunk& c = _M_chunks[_M_nchunks++];
+
+  c.begin = begin;
+  c.end = end;
+  c.skipped = 0;
+  c.overlap = false;
+  c.resync = 0;
+  c.records = 0;
+  c.errors = nullptr;
+  c.nerrors = 0;
+  c.size = 0;
+
+  return true;
+}
+
+void* validator::run(void* arg)
+{
+  validator* v = static_cast<validator*>(arg);
+
+  size_t i;
+  while ((i = __atomic_fetch_add(&v->_M_next, 1, __ATOMIC_RELAXED)) <
+         v->_M_nchunks) {
+    v->validate(v->_M_chunks[i]);
+  }
+
+  return nullptr;
+}
+
+void validator::validate(chunk& c) const
+{
+  size_t off = c.begin;
+
+  while (off < c.end) {
+    bool skipped;
+    off = validate_record(c, off, skipped);
+
+    // If the record contains a plausible record, the records are delimited
+    // again from it (they might end after the end of the chunk).
+    if (skipped) {
+      c.resync = off;
+      return;
+    }
+  }
+}
+
+size_t validator::validate_record(chunk& c, size_t off, bool& skipped) const
+{
+  uint64_t len;
+  size_t next;
+  bool overlap;
+  if ((len = delimit(_M_sync, _M_data, _M_size, off, next, overlap)) != 0) {
+    asn1::ber::memory_reader reader(_M_data + off, len);
+    asn1::ber::null_object obj;
+
+    if (asn1::ber::decoder::decode(reader, obj)) {
+      if (!reader.eof()) {
+        add_error(c,
+                  off + reader.offset(),
+                  asn1::ber::error::invalid_length,
+                  "the record is longer than its contents");
+      }
+    } else {
+      // If the record contains a plausible record (a truncated record whose
+      // length takes the beginning of the next records), it is skipped up
+      // to the plausible record.
+      uint64_t l;
+      if (_M_sync.next(off + 1, off + len, next, l)) {
+        add_error(c,
+                  off,
+                  asn1::ber::error::invalid_length,
+                  nullptr,
+                  next - off,
+                  true);
+
+        skipped = true;
+        return next;
+      }
+
+      add_error(c,
+                off + obj.error_offset(),
+                obj.last_error(),
+                obj.error_message());
+    }
+
+    c.records++;
+
+    skipped = false;
+    return off + len;
+  }
+
+  add_error(c,
+            off,
+            asn1::ber::error::invalid_length,
+            nullptr,
+            next - off,
+            overlap);
+
+  skipped = true;
+  return next;
+}
+
+void validator::resync(size_t end)
+{
+  for (size_t i = 0; i < _M_nchunks; i++) {
+    chunk& c = _M_chunks[i];
+
+    if (c.resync == 0) {
+      continue;
+    }
+
+    // The bytes skipped after the chunk are delimited again.
+    c.skipped = 0;
+
+    size_t off = c.resync;
+    size_t j = i + 1;
+
+    do {
+      // Drop the chunks which start before the offset (their records have
+      // been delimited from the end of the record which failed to decode).
+      while ((j < _M_nchunks) && (_M_chunks[j].begin < off)) {
+        _M_chunks[j].records = 0;
+        _M_chunks[j].nerrors = 0;
+        _M_chunks[j].skipped = 0;
+
+        j++;
+      }
+
+      // From the start of a chunk, the records have been delimited the same
+      // way.
+      if ((j < _M_nchunks) ? (off == _M_chunks[j].begin) : (off >= end)) {
+        break;
+      }
+
+      bool skipped;
+      off = validate_record(c, off, skipped);
+    } while (true);
+
+    i = j - 1;
+  }
+}
+
+void validator::add_error(chunk& c,
+                          size_t offset,
+                          enum asn1::ber::error e,
+                          const char* msg,
+                          size_t skipped,
+                          bool overlap)
+{
+  if (c.nerrors == c.size) {
+    size_t size = (c.size > 0) ? c.size * 2 : 16;
+
+    error* errors;
+    if ((errors = static_cast<error*>(
+                    realloc(c.errors, size * sizeof(error))
+                  )) == nullptr) {
+      return;
+    }
+
+    c.errors = errors;
+    c.size = size;
+  }
+
+  c.errors[c.nerrors].offset = offset;
+  c.errors[c.nerrors].e = e;
+  c.errors[c.nerrors].msg = msg;
+  c.errors[c.nerrors].skipped = skipped;
+  c.errors[c.nerrors].overlap = overlap;
+
+  c.nerrors++;
+}
+
+void validator::print_skipped(size_t offset, size_t length, bool overlap)
+{
+  if (overlap) {
+    printf("Error: record overlaps the next record, at offset: %zu.\n",
+           offset);
+  } else {
+    printf("Error: invalid or incomplete record at offset: %zu.\n", offset);
+  }
+
+  printf("Skipped: offset: %zu, length: %zu.\n", offset, length);
+}
+
+// Print the decoding error of the record at 'offset'.
+template<typename Object>
+static void print_decode_error(const Object& obj, uint64_t offset)
+{
+  if (obj.error_message()) {
+    fprintf(stderr,
+            "Error: %s, at offset: %lu, message: '%s'.\n",
+            to_string(obj.last_error()),
+            offset + obj.error_offset(),
+            obj.error_message());
+  } else {
+    fprintf(stderr,
+            "Error: %s, at offset: %lu.\n",
+            to_string(obj.last_error()),
+            offset + obj.error_offset());
+  }
+}
+
+// Check that the record at 'offset' of 'length' bytes can be decoded (the
+// decoding error is printed to stderr).
+static bool check_record(const reader& reader,
+                         uint64_t offset,
+                         uint64_t length)
+{
+  asn1::ber::memory_reader r(reader.data() + offset, length);
+  asn1::ber::null_object obj;
+
+  if (!asn1::ber::decoder::decode(r, obj)) {
+    print_decode_error(obj, offset);
+    return false;
+  }
+
+  return true;
+}
+
+// Print the record at 'offset' of 'length' bytes (the decoding errors are
+// printed to stderr).
+static bool print_record(const reader& reader,
+                         uint64_t offset,
+                         uint64_t length,
+                         output& out,
+                         bool json,
+                         asn1::ber::json_object<output>::binary_encoding enc)
+{
+  asn1::ber::memory_reader r(reader.data() + offset, length);
+
+  if (json) {
+    asn1::ber::json_object<output> obj(out, enc);
+
+    if (!asn1::ber::decoder::decode(r, obj)) {
+      // Terminate the incomplete record.
+      out.put('\n');
+      out.flush();
+
+      print_decode_error(obj, offset);
+
+      return false;
+    }
+  } else {
+    asn1_object obj(out);
+
+    // Set initial offset.
+    obj.initial_offset(offset);
+
+    if (!asn1::ber::decoder::decode(r, obj)) {
+      out.flush();
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Find the record 'n' (by_offset = false) or the record which contains the
+// byte at 'n' (by_offset = true) walking the records from the beginning of
+// the file (when there is no index).
+static bool find_record(const reader& reader,
+                        bool by_offset,
+                        uint64_t n,
+                        uint64_t& offset,
+                        uint64_t& length)
+{
+  const uint8_t* const data = reader.data();
+  const uint64_t size = reader.size();
+
+  uint64_t off = 0;
+
+  for (uint64_t record = 0; off < size; record++) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %lu.\n",
+              off);
+
+      return false;
+    }
+
+    if ((by_offset) ? (n - off < len) : (record == n)) {
+      offset = off;
+      length = len;
+
+      return true;
+    }
+
+    off += len;
+  }
+
+  fprintf(stderr, "Record not found.\n");
+  return false;
+}
+
+// Parse key: integer or, if the key of the index is a time, a
+// GeneralizedTime ("20240131235959.5Z").
+static bool parse_key(const char* s,
+                      asn1::ber::index_key_type type,
+                      int64_t& key)
+{
+  char* end;
+  errno = 0;
+  long long n = strtoll(s, &end, 10);
+  if ((end != s) && (!*end) && (errno == 0)) {
+    key = n;
+    return true;
+  }
+
+  if (type == asn1::ber::index_key_type::Time) {
+    struct timeval tv;
+    if (asn1::ber::decode_generalized_time(s, strlen(s), tv)) {
+      key = (static_cast<int64_t>(tv.tv_sec) * 1000000) + tv.tv_usec;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Print the records selected by record number, offset or key.
+static bool print_selected(const reader& reader,
+                           const char* filename,
+                           const char* indexname,
+                           selector sel,
+                           const char* value,
+                           bool json,
+                           asn1::ber::json_object<output>::binary_encoding enc)
+{
+  // Open the index: the one given or, if it exists, <filename>.idx.
+  asn1::ber::index idx;
+  bool indexed = false;
+
+  char name[PATH_MAX];
+  if (!indexname) {
+    if (snprintf(name,
+                 sizeof(name),
+                 "%s.idx",
+                 filename) < static_cast<int>(sizeof(name))) {
+      indexed = ((access(name, F_OK) == 0) && (idx.open(name)));
+      indexname = name;
+    }
+  } else if (!(indexed = idx.open(indexname))) {
+    fprintf(stderr, "Error opening index '%s'.\n", indexname);
+    return false;
+  }
+
+  // Has the file changed since it was indexed?
+  if (indexed) {
+    asn1::ber::file_identity id;
+    if (!id.get(filename, reader.data(), reader.size())) {
+      fprintf(stderr, "Error opening file '%s'.\n", filename);
+      return false;
+    }
+
+    if (idx.file().size != id.size) {
+      fprintf(stderr,
+              "Index '%s' is stale (indexed file size: %lu, file size: "
+              "%zu).\n",
+              indexname,
+              idx.file().size,
+              reader.size());
+
+      return false;
+    } else if (idx.file() != id) {
+      fprintf(stderr,
+              "Index '%s' is stale (the file has been modified since it "
+              "was indexed).\n",
+              indexname);
+
+      return false;
+    }
+  }
+
+  uint64_t offset, length;
+
+  if (sel == selector::Key) {
+    if (!indexed) {
+      fprintf(stderr, "--key requires an index.\n");
+      return false;
+    }
+
+    if (idx.key_type() == asn1::ber::index_key_type::None) {
+      fprintf(stderr, "Index '%s' has no key.\n", indexname);
+      return false;
+    }
+
+    int64_t key;
+    if (!parse_key(value, idx.key_type(), key)) {
+      fprintf(stderr, "Invalid key '%s'.\n", value);
+      return false;
+    }
+
+    uint64_t first;
+    uint64_t count = idx.find_key(key, first);
+
+    if (count == 0) {
+      fprintf(stderr, "Record not found.\n");
+      return false;
+    }
+
+    output out;
+
+    for (uint64_t i = 0; i < count; i++) {
+      if ((i > 0) && (!json)) {
+        out.write("========================================\n");
+      }
+
+      if ((!idx.record(idx.key_record(first + i), offset, length)) ||
+          (offset > reader.size()) ||
+          (length > reader.size() - offset)) {
+        out.flush();
+
+        fprintf(stderr, "Invalid index '%s'.\n", indexname);
+        return false;
+      }
+
+      if (!print_record(reader, offset, length, out, json, enc)) {
+        fprintf(stderr, "Error decoding.\n");
+        return false;
+      }
+    }
+
+    if (!out.flush()) {
+      fprintf(stderr, "Error writing output.\n");
+      return false;
+    }
+
+    return true;
+  }
+
+  char* end;
+  errno = 0;
+  unsigned long long n = strtoull(value, &end, 10);
+  if ((end == value) || (*end) || (*value == '-') || (errno != 0)) {
+    fprintf(stderr, "Invalid %s '%s'.\n",
+            (sel == selector::Record) ? "record number" : "offset",
+            value);
+
+    return false;
+  }
+
+  if (indexed) {
+    uint64_t record = n;
+    if (((sel == selector::Offset) && (!idx.find_offset(n, record))) ||
+        (!idx.record(record, offset, length))) {
+      fprintf(stderr, "Record not found.\n");
+      return false;
+    }
+
+    if ((offset > reader.size()) || (length > reader.size() - offset)) {
+      fprintf(stderr, "Invalid index '%s'.\n", indexname);
+      return false;
+    }
+  } else if (!find_record(reader,
+                          sel == selector::Offset,
+                          n,
+                          offset,
+                          length)) {
+    return false;
+  }
+
+  output out;
+
+  if (!print_record(reader, offset, length, out, json, enc)) {
+    fprintf(stderr, "Error decoding.\n");
+    return false;
+  }
+
+  if (!out.flush()) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  return true;
+}
+
+// Extractor of the time key of the records (--time-key).
+class time_key {
+  public:
+    // Constructor.
+    time_key(const asn1::ber::path& path)
+      : _M_extractor(&_M_column, 1, &_M_data)
+    {
+      _M_column.name = "key";
+      _M_column.type = asn1::ber::column_type::Time;
+      _M_column.path = path;
+    }
+
+    // Destructor.
+    ~time_key() = default;
+
+    // Get the key of the record at 'offset' ('found' is false if the record
+    // doesn't have the key).
+    bool get(const reader& reader,
+             uint64_t offset,
+             uint64_t length,
+             int64_t& key,
+             bool& found)
+    {
+      asn1::ber::memory_reader r(reader.data() + offset, length);
+
+      _M_data.clear();
+
+      _M_extractor.begin_record();
+
+      if (!asn1::ber::decoder::decode(r, _M_extractor)) {
+        if (_M_extractor.error_message()) {
+          fprintf(stderr,
+                  "Error: %s, at offset: %lu, message: '%s'.\n",
+                  to_string(_M_extractor.last_error()),
+                  offset + _M_extractor.error_offset(),
+                  _M_extractor.error_message());
+        } else {
+          fprintf(stderr,
+                  "Error: %s, at offset: %lu.\n",
+                  to_string(_M_extractor.last_error()),
+                  offset + _M_extractor.error_offset());
+        }
+
+        return false;
+      }
+
+      if (!_M_extractor.end_record()) {
+        fprintf(stderr, "Error allocating memory.\n");
+        return false;
+      }
+
+      if ((found = ((_M_data.validity()[0] & 0x01) != 0))) {
+        key = static_cast<int64_t>(le64toh(_M_data.values()[0]));
+      }
+
+      return true;
+    }
+
+  private:
+    asn1::ber::column _M_column;
+    asn1::ber::column_data _M_data;
+    asn1::ber::column_extractor _M_extractor;
+
+    // Disable copy constructor and assignment operator.
+    time_key(const time_key&) = delete;
+    time_key& operator=(const time_key&) = delete;
+};
+
+// Print the records whose time key is in [from, to) of a file whose records
+// are sorted by the key.
+// The first record is found with a binary search over the bytes of the file:
+// the record which follows the midpoint is found with the synchronizer and
+// only its key is extracted, so only a few pages of the file are read.
+// The records without key which follow a record in the range are printed.
+static bool print_time_range(const reader& reader,
+                             const asn1::ber::path& keypath,
+                             int64_t from,
+                             int64_t to,
+                             bool json,
+                             asn1::ber::json_object<output>::binary_encoding enc)
+{
+  // Below this size the records are walked.
+  static const size_t linear_search = 64 * 1024;
+
+  const uint8_t* const data = reader.data();
+  const size_t size = reader.size();
+
+  asn1::ber::synchronizer sync(data, size);
+  time_key keys(keypath);
+
+  int64_t key = 0;
+  bool found;
+
+  // The records which start before 'lo' have keys < 'from'.
+  size_t lo = 0;
+  size_t hi = size;
+
+  while ((lo < hi) && (hi - lo > linear_search)) {
+    const size_t mid = lo + ((hi - lo) / 2);
+
+    size_t off;
+    uint64_t len;
+    if (!sync.next(mid, hi, off, len)) {
+      hi = mid;
+      continue;
+    }
+
+    if (!keys.get(reader, off, len, key, found)) {
+      return false;
+    }
+
+    if ((found) && (key < from)) {
+      lo = off + len;
+    } else {
+      hi = off;
+    }
+  }
+
+  output out;
+
+  bool first = true;
+
+  // Without --from, the records without key at the beginning are printed.
+  bool inrange = (from == INT64_MIN);
+
+  for (size_t off = lo; off < size; ) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      out.flush();
+
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    if (!keys.get(reader, off, len, key, found)) {
+      out.flush();
+      return false;
+    }
+
+    if (found) {
+      if (key >= to) {
+        break;
+      }
+
+      inrange = (key >= from);
+    }
+
+    if (inrange) {
+      if ((!first) && (!json)) {
+        out.write("========================================\n");
+      }
+
+      if (!print_record(reader, off, len, out, json, enc)) {
+        fprintf(stderr, "Error decoding.\n");
+        return false;
+      }
+
+      first = false;
+    }
+
+    off += len;
+  }
+
+  if (!out.flush()) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  return true;
+}
+
+// Print the records, skipping the invalid ones: after an error, the decoding
+// resumes from the next plausible record (see asn1::ber::synchronizer) and
+// the skipped bytes are reported.
+static bool print_recovering(const reader& reader,
+                             bool json,
+                             asn1::ber::json_object<output>::binary_encoding enc)
+{
+  const uint8_t* const data = reader.data();
+  const size_t size = reader.size();
+
+  asn1::ber::synchronizer sync(data, size);
+
+  output out;
+
+  // Flush the output after each record if it is a terminal.
+  const bool interactive = isatty(STDOUT_FILENO);
+
+  // Records (valid or not), errors (invalid records and skipped ranges),
+  // ranges of skipped bytes (which don't belong to any record) and skipped
+  // bytes, as counted by --validate.
+  uint64_t nrecords = 0;
+  uint64_t nerrors = 0;
+  uint64_t nranges = 0;
+  uint64_t skipped = 0;
+
+  // Has a record (or part of it) been printed?
+  bool printed = false;
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len, l;
+    size_t next;
+    bool overlap;
+    if ((len = delimit(sync, data, size, off, next, overlap)) != 0) {
+      if ((printed) && (!json)) {
+        out.write("========================================\n");
+      }
+
+      printed = true;
+
+      // In JSON, the record is checked before being printed (an incomplete
+      // object would break the NDJSON output).
+      if (((!json) || (check_record(reader, off, len))) &&
+          (print_record(reader, off, len, out, json, enc))) {
+        if ((out.error()) || ((interactive) && (!out.flush()))) {
+          fprintf(stderr, "Error writing output.\n");
+          return false;
+        }
+
+        nrecords++;
+        off += len;
+
+        continue;
+      }
+
+      // If the invalid record contains a plausible record (a truncated
+      // record whose length takes the beginning of the next records), it is
+      // skipped up to the plausible record, otherwise the decoding resumes
+      // after it (as --validate does).
+      if (!sync.next(off + 1, off + len, next, l)) {
+        nrecords++;
+        nerrors++;
+        off += len;
+
+        continue;
+      }
+
+      overlap = true;
+    }
+
+    out.flush();
+
+    if (overlap) {
+      fprintf(stderr,
+              "Error: record overlaps the next record, at offset: %zu.\n",
+              off);
+    } else {
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+    }
+
+    nerrors++;
+    nranges++;
+
+    fprintf(stderr,
+            "Skipped: offset: %zu, length: %zu.\n",
+            off,
+            next - off);
+
+    skipped += next - off;
+    off = next;
+  }
+
+  if (!out.flush()) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  if (nerrors > 0) {
+    fprintf(stderr,
+            "Records: %llu, errors: %llu, skipped ranges: %llu, "
+            "skipped bytes: %llu.\n",
+            static_cast<unsigned long long>(nrecords),
+            static_cast<unsigned long long>(nerrors),
+            static_cast<unsigned long long>(nranges),
+            static_cast<unsigned long long>(skipped));
+
+    return false;
+  }
+
+  return true;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [--stats | --validate [--threads <n>] | [--json [--hex]] "
+          "[--recover]]\n"
+          "       [--index <index>]\n"
+          "       [--record <n> | --offset <offset> | --key <key> |\n"
+          "        --time-key <path> [--from <time>] [--to <time>]] "
+          "<filename>\n"
+          "\n"
+          "Options:\n"
+          "  --stats        Print decode statistics (latency per record,\n"
+          "                 throughput and tag frequencies) instead of the\n"
+          "                 values.\n"
+          "  --validate     Only check that the records are valid (the\n"
+          "                 errors and their offsets are printed).\n"
+          "  --threads <n>  Number of threads used by --validate (default:\n"
+          "                 number of CPUs).\n"
+          "  --json         Print the records in JSON (one object per line).\n"
+          "  --hex          Encode the binary values in hexadecimal instead\n"
+          "                 of in base64 (--json).\n"
+          "  --recover      After an invalid record, resume the decoding from\n"
+          "                 the next plausible record (the skipped bytes are\n"
+          "                 reported).\n"
+          "  --index <index>\n"
+          "                 Index created by berindex (default:\n"
+          "                 <filename>.idx, if it exists).\n"
+          "  --record <n>   Only print the record number <n> (starting at 0).\n"
+          "  --offset <offset>\n"
+          "                 Only print the record which contains the byte at\n"
+          "                 <offset>.\n"
+          "  --key <key>    Only print the records with the key <key> (an\n"
+          "                 integer or, for time keys, a GeneralizedTime);\n"
+          "                 requires an index with key.\n"
+          "  --time-key <path>\n"
+          "                 Path of the time key (\"[APPLICATION 1]/[3]\") of a\n"
+          "                 file whose records are sorted by it: only print\n"
+          "                 the records with keys in [--from, --to), found\n"
+          "                 with a binary search (no index is needed).\n"
+          "  --from <time>, --to <time>\n"
+          "                 GeneralizedTime (\"20240131235959Z\") or\n"
+          "                 microseconds since the epoch.\n",
+          program);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  bool stats = false;
+  bool validate = false;
+  bool json = false;
+  bool recover = false;
+
+  const char* indexname = nullptr;
+  selector sel = selector::None;
+  const char* value = nullptr;
+
+  asn1::ber::path keypath;
+  const char* from = nullptr;
+  const char* to = nullptr;
+
+  asn1::ber::json_object<output>::binary_encoding
+    enc = asn1::ber::json_object<output>::binary_encoding::Base64;
+
+  long nthreads = sysconf(_SC_NPROCESSORS_ONLN);
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--stats") == 0) {
+      stats = true;
+    } else if (strcmp(argv[i], "--validate") == 0) {
+      validate = true;
+    } else if (strcmp(argv[i], "--json") == 0) {
+      json = true;
+    } else if (strcmp(argv[i], "--recover") == 0) {
+      recover = true;
+    } else if (strcmp(argv[i], "--hex") == 0) {
+      enc = asn1::ber::json_object<output>::binary_encoding::Hex;
+    } else if ((strcmp(argv[i], "--index") == 0) && (i + 1 < argc)) {
+      indexname = argv[++i];
+    } else if ((strcmp(argv[i], "--record") == 0) &&
+               (i + 1 < argc) &&
+               (sel == selector::None)) {
+      sel = selector::Record;
+      value = argv[++i];
+    } else if ((strcmp(argv[i], "--offset") == 0) &&
+               (i + 1 < argc) &&
+               (sel == selector::None)) {
+      sel = selector::Offset;
+      value = argv[++i];
+    } else if ((strcmp(argv[i], "--key") == 0) &&
+               (i + 1 < argc) &&
+               (sel == selector::None)) {
+      sel = selector::Key;
+      value = argv[++i];
+    } else if ((strcmp(argv[i], "--time-key") == 0) &&
+               (i + 1 < argc) &&
+               (sel == selector::None)) {
+      if (!keypath.parse(argv[++i])) {
+        fprintf(stderr, "Invalid path '%s'.\n", argv[i]);
+        return -1;
+      }
+
+      sel = selector::TimeRange;
+    } else if ((strcmp(argv[i], "--from") == 0) && (i + 1 < argc)) {
+      from = argv[++i];
+    } else if ((strcmp(argv[i], "--to") == 0) && (i + 1 < argc)) {
+      to = argv[++i];
+    } else if ((strcmp(argv[i], "--threads") == 0) && (i + 1 < argc)) {
+      char* end;
+      nthreads = strtol(argv[++i], &end, 10);
+      if ((*end) || (nthreads < 1) || (nthreads > max_threads)) {
+        usage(argv[0]);
+        return -1;
+      }
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  // Time range.
+  int64_t begin = INT64_MIN;
+  int64_t end = INT64_MAX;
+
+  if ((from) || (to)) {
+    if (sel != selector::TimeRange) {
+      usage(argv[0]);
+      return -1;
+    }
+
+    if ((from) &&
+        (!parse_key(from, asn1::ber::index_key_type::Time, begin))) {
+      fprintf(stderr, "Invalid time '%s'.\n", from);
+      return -1;
+    }
+
+    if ((to) && (!parse_key(to, asn1::ber::index_key_type::Time, end))) {
+      fprintf(stderr, "Invalid time '%s'.\n", to);
+      return -1;
+    }
+  }
+
+  if ((filename) &&
+      (stats + validate + json <= 1) &&
+      ((sel == selector::None) || (!(stats || validate))) &&
+      ((!recover) || ((sel == selector::None) && (!(stats || validate))))) {
+    reader reader;
+    if (reader.open(filename)) {
+      if (sel == selector::TimeRange) {
+        return print_time_range(reader,
+                                keypath,
+                                begin,
+                                end,
+                                json,
+                                enc) ? 0 : -1;
+      } else if (sel != selector::None) {
+        return print_selected(reader,
+                              filename,
+                              indexname,
+                              sel,
+                              value,
+                              json,
+                              enc) ? 0 : -1;
+      } else if (validate) {
+        if (nthreads < 1) {
+          nthreads = 1;
+        } else if (nthreads > max_threads) {
+          nthreads = max_threads;
+        }
+
+        validator v(reader.data(), reader.size(), nthreads);
+        return v.validate() ? 0 : -1;
+      } else if (stats) {
+        return print_statistics(reader) ? 0 : -1;
+      } else if (recover) {
+        return print_recovering(reader, json, enc) ? 0 : -1;
+      } else if (json) {
+        return print_json(reader, enc) ? 0 : -1;
+      } else {
+        return print_records(reader) ? 0 : -1;
+      }
     } else {
-      fprintf(stderr, "Error opening file '%s'.\n", argv[1]);
+      fprintf(stderr, "Error opening file '%s'.\n", filename);
     }
   } else {
-    fprintf(stderr, "Usage: %s <filename>\n", argv[0]);
+    usage(argv[0]);
   }
 
   return -1;
@@ -0,0 +1,275 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/buffered_writer.h"
+#include "asn1/ber/matcher.h"
+
+typedef asn1::ber::buffered_writer<1024 * 1024> output;
+
+// Filter the records of 'data' with the queries of 'matcher':
+//   - If 'out' is not nullptr, the records which match any query are copied
+//     to 'out'.
+//   - Otherwise, if 'counts' is not nullptr, the number of records which
+//     match each query is counted.
+//   - Otherwise, the number, the offset and the length of the records which
+//     match any query are printed, followed by the queries.
+static bool filter(const uint8_t* data,
+                   size_t size,
+                   asn1::ber::matcher& matcher,
+                   output* out,
+                   uint64_t* counts)
+{
+  output list;
+
+  uint64_t nrecords = 0;
+  uint64_t nmatched = 0;
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      list.flush();
+
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    if (!matcher.begin_record()) {
+      list.flush();
+
+      fprintf(stderr, "Error allocating memory.\n");
+      return false;
+    }
+
+    asn1::ber::memory_reader reader(data + off, len);
+
+    if (!asn1::ber::decoder::decode(reader, matcher)) {
+      list.flush();
+
+      if (matcher.error_message()) {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu, message: '%s'.\n",
+                to_string(matcher.last_error()),
+                off + matcher.error_offset(),
+                matcher.error_message());
+      } else {
+        fprintf(stderr,
+                "Error: %s, at offset: %zu.\n",
+                to_string(matcher.last_error()),
+                off + matcher.error_offset());
+      }
+
+      return false;
+    }
+
+    const size_t nmatches = matcher.nmatches();
+
+    if (nmatches > 0) {
+      if (out) {
+        out->write(data + off, len);
+      } else if (counts) {
+        const uint32_t* matches = matcher.matches();
+
+        for (size_t i = 0; i < nmatches; i++) {
+          counts[matches[i]]++;
+        }
+      } else {
+        list.unsigned_integer(nrecords);
+        list.put(' ');
+        list.unsigned_integer(off);
+        list.put(' ');
+        list.unsigned_integer(len);
+
+        // Queries in ascending order.
+        const size_t nqueries = matcher.size();
+        size_t printed = 0;
+
+        for (size_t q = 0; (q < nqueries) && (printed < nmatches); q++) {
+          if (matcher.matched(q)) {
+            list.put((printed++ == 0) ? ' ' : ',');
+            list.unsigned_integer(q);
+          }
+        }
+
+        list.put('\n');
+      }
+
+      nmatched++;
+    }
+
+    nrecords++;
+    off += len;
+  }
+
+  if ((!list.flush()) || ((out) && (!out->flush()))) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  if (counts) {
+    for (size_t q = 0; q < matcher.size(); q++) {
+      printf("%zu %llu\n", q, static_cast<unsigned long long>(counts[q]));
+    }
+  }
+
+  fprintf(stderr,
+          "Records: %llu, matched: %llu, states: %zu.\n",
+          static_cast<unsigned long long>(nrecords),
+          static_cast<unsigned long long>(nmatched),
+          matcher.states());
+
+  return true;
+}
+
+// Add the queries of the file 'filename' (one per line, the empty lines and
+// the lines starting with '#' are skipped).
+static bool add_queries(asn1::ber::matcher& matcher, const char* filename)
+{
+  FILE* file;
+  if ((file = fopen(filename, "r")) == nullptr) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return false;
+  }
+
+  char* line = nullptr;
+  size_t size = 0;
+  ssize_t len;
+
+  bool ret = true;
+
+  while ((ret) && ((len = getline(&line, &size, file)) != -1)) {
+    // Remove the line terminator.
+    while ((len > 0) && ((line[len - 1] == '\n') || (line[len - 1] == '\r'))) {
+      line[--len] = 0;
+    }
+
+    if ((len > 0) && (*line != '#')) {
+      if (!matcher.add(line)) {
+        fprintf(stderr, "Invalid query '%s'.\n", line);
+        ret = false;
+      }
+    }
+  }
+
+  free(line);
+  fclose(file);
+
+  return ret;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s (--query <query> | --queries <file>) ... "
+          "[--output <file> | --count] <filename>\n"
+          "\n"
+          "Evaluates all the queries over the records in a single decoding\n"
+          "pass and prints the records which match any query (number,\n"
+          "offset, length and queries, numbered from 0).\n"
+          "\n"
+          "Query: <pattern> [<operator> <value>]\n"
+          "  <pattern>: tags separated by '/', '*' (any tag) or '**' (any\n"
+          "             number of tags): \"[APPLICATION 1]/[3]\",\n"
+          "             \"**/[UNIVERSAL 6]\".\n"
+          "  <operator>: ==, !=, <, <=, >, >=.\n"
+          "  <value>: integer, \"string\", 0x<hexadecimal> or object\n"
+          "           identifier (1.2.840.113549).\n"
+          "\n"
+          "Options:\n"
+          "  --query <query>   Add query.\n"
+          "  --queries <file>  Add the queries of the file (one per line).\n"
+          "  --output <file>   Copy the records which match any query to\n"
+          "                    the file.\n"
+          "  --count           Print the number of records which match each\n"
+          "                    query.\n",
+          program);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* outname = nullptr;
+  bool count = false;
+
+  asn1::ber::matcher matcher;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--query") == 0) && (i + 1 < argc)) {
+      if (!matcher.add(argv[++i])) {
+        fprintf(stderr, "Invalid query '%s'.\n", argv[i]);
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--queries") == 0) && (i + 1 < argc)) {
+      if (!add_queries(matcher, argv[++i])) {
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      outname = argv[++i];
+    } else if (strcmp(argv[i], "--count") == 0) {
+      count = true;
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if ((!filename) || (matcher.size() == 0) || ((outname) && (count))) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  if (outname) {
+    int fd;
+    if ((fd = open(outname, O_CREAT | O_TRUNC | O_WRONLY, 0644)) == -1) {
+      fprintf(stderr, "Error opening file '%s'.\n", outname);
+      return -1;
+    }
+
+    bool ret;
+
+    {
+      output out(fd);
+      ret = filter(file.data(), file.size(), matcher, &out, nullptr);
+    }
+
+    if (close(fd) != 0) {
+      fprintf(stderr, "Error writing file '%s'.\n", outname);
+      return -1;
+    }
+
+    return ret ? 0 : -1;
+  } else if (count) {
+    uint64_t* counts;
+    if ((counts = static_cast<uint64_t*>(
+                    calloc(matcher.size(), sizeof(uint64_t))
+                  )) == nullptr) {
+      fprintf(stderr, "Error allocating memory.\n");
+      return -1;
+    }
+
+    bool ret = filter(file.data(), file.size(), matcher, nullptr, counts);
+
+    free(counts);
+
+    return ret ? 0 : -1;
+  }
+
+  return filter(file.data(), file.size(), matcher, nullptr, nullptr) ? 0 : -1;
+}
@@ -0,0 +1,550 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include "asn1/ber/encoder.h"
+
+using namespace asn1::ber;
+
+// Maximum depth of the records (explicit tags add one level each in the
+// decoder, which supports up to 64 levels).
+static const unsigned max_depth = 16;
+
+// Maximum number of components of the generated object identifiers.
+static const size_t max_components = 12;
+
+// Pseudo-random number generator (splitmix64): the output only depends on
+// the seed.
+class random_generator {
+  public:
+    // Constructor.
+    random_generator(uint64_t seed)
+      : _M_state(seed)
+    {
+    }
+
+    // Destructor.
+    ~random_generator() = default;
+
+    // Next 64-bit value.
+    uint64_t next()
+    {
+      uint64_t z = (_M_state += 0x9e3779b97f4a7c15ull);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+      return z ^ (z >> 31);
+    }
+
+    // Value in the range [min, max].
+    uint64_t range(uint64_t min, uint64_t max)
+    {
+      return (max > min) ? min + (next() % (max - min + 1)) : min;
+    }
+
+    // Return true with a probability of 'percent' %.
+    bool percent(unsigned percent)
+    {
+      return ((next() % 100) < percent);
+    }
+
+    // Value in the range [0, 1).
+    double uniform()
+    {
+      return static_cast<double>(next() >> 11) / 9007199254740992.0;
+    }
+
+  private:
+    uint64_t _M_state;
+};
+
+class generator {
+  public:
+    enum class field {
+      Integer,
+      OctetString,
+      Time,
+      Oid,
+      Constructed
+    };
+
+    static const size_t number_fields = 5;
+
+    enum class distribution {
+      Uniform,
+      Exponential
+    };
+
+    // Constructor.
+    generator() = default;
+
+    // Destructor.
+    ~generator()
+    {
+      if (_M_strings) {
+        free(_M_strings);
+      }
+
+      if (_M_out) {
+        free(_M_out);
+      }
+    }
+
+    // Parse arguments.
+    bool parse(int argc, const char** argv);
+
+    // Generate records.
+    bool generate();
+
+  private:
+    uint64_t _M_seed = 1;
+    uint64_t _M_records = 1000;
+
+    unsigned _M_depth = 4;
+    unsigned _M_fanout = 8;
+
+    unsigned _M_mix[number_fields] = {30, 25, 15, 10, 20};
+    unsigned _M_total_weight = 100;
+
+    size_t _M_min_string_size = 0;
+    size_t _M_max_string_size = 32;
+    distribution _M_distribution = distribution::Uniform;
+
+    unsigned _M_indefinite = 0;
+    unsigned _M_explicit = 0;
+
+    tag_number _M_min_tag = 0;
+    tag_number _M_max_tag = 30;
+
+    const char* _M_output = nullptr;
+
+    random_generator _M_random{1};
+
+    // Random bytes from which the octet strings are taken.
+    uint8_t* _M_strings = nullptr;
+    size_t _M_strings_size;
+
+    // Output buffer.
+    uint8_t* _M_out = nullptr;
+    size_t _M_out_size = 0;
+
+    // Add the fields of a constructed value.
+    bool add_fields(encoder<>& e, unsigned depth);
+
+    // Add field.
+    bool add_field(encoder<>& e, unsigned depth);
+
+    // Choose field type.
+    field choose_field(unsigned depth);
+
+    // Choose string size.
+    size_t string_size();
+
+    // Choose tagging.
+    tagging choose_tagging()
+    {
+      return _M_random.percent(_M_explicit) ? tagging::Explicit :
+                                              tagging::Implicit;
+    }
+
+    // Choose length form.
+    encoder<>::length_form choose_length_form()
+    {
+      return _M_random.percent(_M_indefinite) ?
+               encoder<>::length_form::Indefinite :
+               encoder<>::length_form::Definite;
+    }
+
+    // Parse range "<min>-<max>".
+    static bool parse_range(const char* s, uint64_t& min, uint64_t& max);
+
+    // Parse percentage.
+    static bool parse_percent(const char* s, unsigned& n);
+};
+
+bool generator::parse(int argc, const char** argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (i + 1 == argc) {
+      return false;
+    }
+
+    const char* arg = argv[++i];
+    char* end;
+
+    if (strcmp(argv[i - 1], "--seed") == 0) {
+      _M_seed = strtoull(arg, &end, 10);
+      if (*end) {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--records") == 0) {
+      _M_records = strtoull(arg, &end, 10);
+      if (*end) {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--depth") == 0) {
+      unsigned long depth = strtoul(arg, &end, 10);
+      if ((*end) || (depth < 1) || (depth > max_depth)) {
+        return false;
+      }
+
+      _M_depth = depth;
+    } else if (strcmp(argv[i - 1], "--fanout") == 0) {
+      unsigned long fanout = strtoul(arg, &end, 10);
+      if ((*end) || (fanout < 1) || (fanout > 1024)) {
+        return false;
+      }
+
+      _M_fanout = fanout;
+    } else if (strcmp(argv[i - 1], "--mix") == 0) {
+      unsigned mix[number_fields];
+      int n;
+      if ((sscanf(arg,
+                  "%u,%u,%u,%u,%u%n",
+                  &mix[0],
+                  &mix[1],
+                  &mix[2],
+                  &mix[3],
+                  &mix[4],
+                  &n) != 5) ||
+          (arg[n])) {
+        return false;
+      }
+
+      _M_total_weight = 0;
+      for (size_t j = 0; j < number_fields; j++) {
+        if (mix[j] > 1000) {
+          return false;
+        }
+
+        _M_mix[j] = mix[j];
+        _M_total_weight += mix[j];
+      }
+
+      // At least one primitive type is required.
+      if (_M_total_weight == mix[number_fields - 1]) {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--string-size") == 0) {
+      uint64_t min, max;
+      if ((parse_range(arg, min, max)) && (max <= 16 * 1024 * 1024)) {
+        _M_min_string_size = min;
+        _M_max_string_size = max;
+      } else {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--string-distribution") == 0) {
+      if (strcmp(arg, "uniform") == 0) {
+        _M_distribution = distribution::Uniform;
+      } else if (strcmp(arg, "exponential") == 0) {
+        _M_distribution = distribution::Exponential;
+      } else {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--indefinite") == 0) {
+      if (!parse_percent(arg, _M_indefinite)) {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--explicit") == 0) {
+      if (!parse_percent(arg, _M_explicit)) {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--tags") == 0) {
+      uint64_t min, max;
+      if (parse_range(arg, min, max)) {
+        _M_min_tag = min;
+        _M_max_tag = max;
+      } else {
+        return false;
+      }
+    } else if (strcmp(argv[i - 1], "--output") == 0) {
+      _M_output = arg;
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool generator::generate()
+{
+  _M_random = random_generator(_M_seed);
+
+  // Fill the buffer of random bytes (twice the maximum string size, so that
+  // the strings start at different offsets).
+  _M_strings_size = 2 * _M_max_string_size + 4096;
+  if ((_M_strings = static_cast<uint8_t*>(malloc(_M_strings_size))) ==
+      nullptr) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < _M_strings_size; i++) {
+    _M_strings[i] = static_cast<uint8_t>(_M_random.next());
+  }
+
+  FILE* file;
+  if (_M_output) {
+    if ((file = fopen(_M_output, "w")) == nullptr) {
+      fprintf(stderr, "Error opening '%s' for writing.\n", _M_output);
+      return false;
+    }
+  } else {
+    file = stdout;
+  }
+
+  encoder<> e;
+
+  for (uint64_t i = 0; i < _M_records; i++) {
+    e.clear();
+
+    if ((!e.start_sequence(tag_class::Application,
+                           tagging::Implicit,
+                           1,
+                           choose_length_form())) ||
+        (!add_fields(e, 1)) ||
+        (!e.end_sequence())) {
+      fprintf(stderr, "Error encoding record %llu.\n", i);
+
+      if (file != stdout) {
+        fclose(file);
+      }
+
+      return false;
+    }
+
+    size_t len = e.size();
+
+    // If the output buffer is too small...
+    if (len > _M_out_size) {
+      size_t size = (len + 4095) & ~static_cast<size_t>(4095);
+
+      uint8_t* out;
+      if ((out = static_cast<uint8_t*>(realloc(_M_out, size))) != nullptr) {
+        _M_out = out;
+        _M_out_size = size;
+      } else {
+        fprintf(stderr, "Error allocating memory.\n");
+
+        if (file != stdout) {
+          fclose(file);
+        }
+
+        return false;
+      }
+    }
+
+    if (fwrite(_M_out, 1, e.encode_to(_M_out, _M_out_size), file) != len) {
+      fprintf(stderr, "Error writing record %llu.\n", i);
+
+      if (file != stdout) {
+        fclose(file);
+      }
+
+      return false;
+    }
+  }
+
+  if (file != stdout) {
+    if (fclose(file) != 0) {
+      fprintf(stderr, "Error writing '%s'.\n", _M_output);
+      return false;
+    }
+  } else if (fflush(file) != 0) {
+    return false;
+  }
+
+  return true;
+}
+
+bool generator::add_fields(encoder<>& e, unsigned depth)
+{
+  for (uint64_t i = _M_random.range(1, _M_fanout); i > 0; i--) {
+    if (!add_field(e, depth)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool generator::add_field(encoder<>& e, unsigned depth)
+{
+  tag_number tn = _M_random.range(_M_min_tag, _M_max_tag);
+
+  switch (choose_field(depth)) {
+    case field::Integer:
+      {
+        // Integers whose number of significant bits is uniformly
+        // distributed.
+        int64_t n = static_cast<int64_t>(_M_random.next()) >>
+                    (_M_random.next() & 0x3f);
+
+        return e.add_integer(tag_class::ContextSpecific,
+                             choose_tagging(),
+                             tn,
+                             n);
+      }
+    case field::OctetString:
+      {
+        size_t len = string_size();
+        size_t off = _M_random.range(0, _M_strings_size - len);
+
+        return e.add_octetstring(tag_class::ContextSpecific,
+                                 choose_tagging(),
+                                 tn,
+                                 _M_strings + off,
+                                 len,
+                                 encoder<>::copy::Shallow);
+      }
+    case field::Time:
+      {
+        // Timestamp between 2000 and 2037.
+        struct timeval tv;
+        tv.tv_sec = _M_random.range(946684800, 2114380799);
+        tv.tv_usec = _M_random.range(0, 999999);
+
+        if (_M_random.percent(50)) {
+          return e.add_generalized_time(tag_class::ContextSpecific,
+                                        choose_tagging(),
+                                        tn,
+                                        tv);
+        } else {
+          return e.add_utc_time(tag_class::ContextSpecific,
+                                choose_tagging(),
+                                tn,
+                                tv.tv_sec);
+        }
+      }
+    case field::Oid:
+      {
+        uint64_t oid[max_components];
+        size_t ncomponents = _M_random.range(3, max_components);
+
+        oid[0] = _M_random.range(0, 2);
+        oid[1] = _M_random.range(0, 39);
+
+        for (size_t i = 2; i < ncomponents; i++) {
+          oid[i] = _M_random.next() >> (_M_random.range(32, 63));
+        }
+
+        return e.add_oid(tag_class::ContextSpecific,
+                         choose_tagging(),
+                         tn,
+                         oid,
+                         ncomponents);
+      }
+    case field::Constructed:
+    default:
+      return ((e.start_sequence(tag_class::ContextSpecific,
+                                choose_tagging(),
+                                tn,
+                                choose_length_form())) &&
+              (add_fields(e, depth + 1)) &&
+              (e.end_sequence()));
+  }
+}
+
+generator::field generator::choose_field(unsigned depth)
+{
+  // Constructed values are only possible above the maximum depth.
+  unsigned total = (depth < _M_depth) ?
+                     _M_total_weight :
+                     _M_total_weight - _M_mix[number_fields - 1];
+
+  unsigned n = _M_random.next() % total;
+
+  for (size_t i = 0; i < number_fields - 1; i++) {
+    if (n < _M_mix[i]) {
+      return static_cast<field>(i);
+    }
+
+    n -= _M_mix[i];
+  }
+
+  return field::Constructed;
+}
+
+size_t generator::string_size()
+{
+  if (_M_distribution == distribution::Uniform) {
+    return _M_random.range(_M_min_string_size, _M_max_string_size);
+  } else {
+    // Exponential distribution (mean: an eighth of the range) truncated to
+    // the maximum size.
+    double mean = (_M_max_string_size - _M_min_string_size) / 8.0;
+    double size = -log(1.0 - _M_random.uniform()) * mean;
+
+    return (size < _M_max_string_size - _M_min_string_size) ?
+             _M_min_string_size + static_cast<size_t>(size) :
+             _M_max_string_size;
+  }
+}
+
+bool generator::parse_range(const char* s, uint64_t& min, uint64_t& max)
+{
+  int n;
+  return ((sscanf(s, "%llu-%llu%n", &min, &max, &n) == 2) &&
+          (!s[n]) &&
+          (min <= max));
+}
+
+bool generator::parse_percent(const char* s, unsigned& n)
+{
+  char* end;
+  unsigned long percent = strtoul(s, &end, 10);
+  if ((!*end) && (percent <= 100)) {
+    n = percent;
+    return true;
+  }
+
+  return false;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [OPTIONS]\n"
+          "\n"
+          "Generates deterministic BER records ([APPLICATION 1] SEQUENCE).\n"
+          "\n"
+          "Options:\n"
+          "  --seed <n>                   Seed (default: 1).\n"
+          "  --records <n>                Number of records (default: 1000).\n"
+          "  --depth <n>                  Maximum depth (1 - %u, default: 4).\n"
+          "  --fanout <n>                 Maximum number of fields per\n"
+          "                               constructed value (default: 8).\n"
+          "  --mix <i>,<s>,<t>,<o>,<c>    Weights of INTEGER, OCTET STRING,\n"
+          "                               time, OID and constructed fields\n"
+          "                               (default: 30,25,15,10,20).\n"
+          "  --string-size <min>-<max>    Size of the octet strings\n"
+          "                               (default: 0-32).\n"
+          "  --string-distribution uniform|exponential\n"
+          "                               Distribution of the string sizes\n"
+          "                               (default: uniform).\n"
+          "  --indefinite <percent>       Constructed values with indefinite\n"
+          "                               length (default: 0).\n"
+          "  --explicit <percent>         Explicitly tagged fields\n"
+          "                               (default: 0).\n"
+          "  --tags <min>-<max>           Tag numbers of the fields\n"
+          "                               (default: 0-30).\n"
+          "  --output <file>              Output file (default: stdout).\n",
+          program,
+          max_depth);
+}
+
+int main(int argc, const char** argv)
+{
+  generator g;
+  if (g.parse(argc, argv)) {
+    return g.generate() ? 0 : -1;
+  }
+
+  usage(argv[0]);
+
+  return -1;
+}
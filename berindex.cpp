@@ -0,0 +1,209 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <endian.h>
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/columns.h"
+#include "asn1/ber/index.h"
+
+// Index the records of 'data' (the contents of the file 'file') into
+// 'filename'.
+static bool index_records(const uint8_t* data,
+                          size_t size,
+                          const asn1::ber::file_identity& file,
+                          const char* filename,
+                          const asn1::ber::column* key)
+{
+  char keypath[asn1::ber::index::max_path_length + 1];
+  asn1::ber::index_key_type keytype = asn1::ber::index_key_type::None;
+
+  if (key) {
+    key->path.print(keypath, sizeof(keypath));
+
+    keytype = (key->type == asn1::ber::column_type::Int64) ?
+                asn1::ber::index_key_type::Int64 :
+                asn1::ber::index_key_type::Time;
+  } else {
+    *keypath = 0;
+  }
+
+  asn1::ber::index_writer writer;
+  if (!writer.open(filename, file, keytype, keypath)) {
+    fprintf(stderr, "Error creating index '%s'.\n", filename);
+    return false;
+  }
+
+  // The key is extracted as a column (of one record).
+  asn1::ber::column_data keydata;
+  asn1::ber::column_extractor obj(key, key ? 1 : 0, &keydata);
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    bool ret;
+
+    if (key) {
+      asn1::ber::memory_reader reader(data + off, len);
+
+      keydata.clear();
+
+      obj.begin_record();
+
+      if (!asn1::ber::decoder::decode(reader, obj)) {
+        if (obj.error_message()) {
+          fprintf(stderr,
+                  "Error: %s, at offset: %zu, message: '%s'.\n",
+                  to_string(obj.last_error()),
+                  off + obj.error_offset(),
+                  obj.error_message());
+        } else {
+          fprintf(stderr,
+                  "Error: %s, at offset: %zu.\n",
+                  to_string(obj.last_error()),
+                  off + obj.error_offset());
+        }
+
+        return false;
+      }
+
+      if (!obj.end_record()) {
+        fprintf(stderr, "Error allocating memory.\n");
+        return false;
+      }
+
+      // Has the record key?
+      if (keydata.validity()[0] & 0x01) {
+        ret = writer.add(off,
+                         len,
+                         static_cast<int64_t>(le64toh(keydata.values()[0])));
+      } else {
+        ret = writer.add(off, len);
+      }
+    } else {
+      ret = writer.add(off, len);
+    }
+
+    if (!ret) {
+      fprintf(stderr, "Error writing index '%s'.\n", filename);
+      return false;
+    }
+
+    off += len;
+  }
+
+  if (!writer.close()) {
+    fprintf(stderr, "Error writing index '%s'.\n", filename);
+    return false;
+  }
+
+  return true;
+}
+
+// Parse key ("<type>:<path>").
+static bool parse_key(const char* s, asn1::ber::column& key)
+{
+  key.name = "key";
+
+  if (strncmp(s, "int64:", 6) == 0) {
+    key.type = asn1::ber::column_type::Int64;
+    return key.path.parse(s + 6);
+  } else if (strncmp(s, "time:", 5) == 0) {
+    key.type = asn1::ber::column_type::Time;
+    return key.path.parse(s + 5);
+  }
+
+  return false;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [--key <type>:<path>] [--output <index>] <filename>\n"
+          "\n"
+          "Creates an index with the offset and the length of the records\n"
+          "(and optionally a key) for random access.\n"
+          "\n"
+          "Options:\n"
+          "  --key <type>:<path>  Key of the records:\n"
+          "                         <type>: int64 or time (microseconds since\n"
+          "                         the epoch).\n"
+          "                         <path>: tags from the record,\n"
+          "                         \"[APPLICATION 1]/[3]\".\n"
+          "  --output <index>     Index file (default: <filename>.idx).\n",
+          program);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* output = nullptr;
+
+  asn1::ber::column key;
+  bool haskey = false;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--key") == 0) && (i + 1 < argc)) {
+      if (!parse_key(argv[++i], key)) {
+        fprintf(stderr, "Invalid key '%s'.\n", argv[i]);
+        return -1;
+      }
+
+      haskey = true;
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      output = argv[++i];
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if (!filename) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  char idx[PATH_MAX];
+  if (!output) {
+    if (snprintf(idx,
+                 sizeof(idx),
+                 "%s.idx",
+                 filename) >= static_cast<int>(sizeof(idx))) {
+      fprintf(stderr, "Filename too long.\n");
+      return -1;
+    }
+
+    output = idx;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  asn1::ber::file_identity id;
+  if (!id.get(filename, file.data(), file.size())) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  return index_records(file.data(),
+                       file.size(),
+                       id,
+                       output,
+                       haskey ? &key : nullptr) ? 0 : -1;
+}
@@ -0,0 +1,263 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "asn1/ber/common.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/output_file.h"
+#include "asn1/ber/buffered_writer.h"
+#include "asn1/ber/patch.h"
+
+#define IS_DIGIT(x) (((x) >= '0') && ((x) <= '9'))
+
+typedef asn1::ber::buffered_writer<1024 * 1024> output;
+
+// Apply the edits of 'patch' to the records of 'data' and write them to
+// 'out'.
+static bool patch_records(const uint8_t* data,
+                          size_t size,
+                          const asn1::ber::patch& patch,
+                          output& out)
+{
+  const size_t growth = patch.max_growth();
+
+  uint8_t* buf = nullptr;
+  size_t bufsize = 0;
+
+  uint64_t nrecords = 0;
+  uint64_t nedits = 0;
+
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      free(buf);
+
+      out.flush();
+
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    // The record is edited in a copy with space for the growth.
+    if (len + growth > bufsize) {
+      uint8_t* b;
+      if ((b = static_cast<uint8_t*>(realloc(buf, len + growth))) == nullptr) {
+        free(buf);
+
+        out.flush();
+
+        fprintf(stderr, "Error allocating memory.\n");
+        return false;
+      }
+
+      buf = b;
+      bufsize = len + growth;
+    }
+
+    memcpy(buf, data + off, len);
+
+    size_t newlen, napplied;
+    if (!patch.apply(buf, len, bufsize, newlen, napplied)) {
+      free(buf);
+
+      out.flush();
+
+      fprintf(stderr, "Error: record too big, at offset: %zu.\n", off);
+      return false;
+    }
+
+    out.write(buf, newlen);
+
+    nrecords++;
+    nedits += napplied;
+
+    off += len;
+  }
+
+  free(buf);
+
+  if (!out.flush()) {
+    fprintf(stderr, "Error writing output.\n");
+    return false;
+  }
+
+  fprintf(stderr,
+          "Records: %llu, edits applied: %llu.\n",
+          static_cast<unsigned long long>(nrecords),
+          static_cast<unsigned long long>(nedits));
+
+  return true;
+}
+
+// Parse value: integer (encoded as the contents of an INTEGER), "string" or
+// 0x<hexadecimal>.
+static bool parse_value(const char* s, uint8_t* buf, size_t size, size_t& len)
+{
+  if (*s == '"') {
+    len = 0;
+
+    for (s++; *s != '"'; s++) {
+      if (*s == 0) {
+        return false;
+      }
+
+      if ((*s == '\\') && ((s[1] == '"') || (s[1] == '\\'))) {
+        s++;
+      }
+
+      if (len == size) {
+        return false;
+      }
+
+      buf[len++] = *s;
+    }
+
+    return (s[1] == 0);
+  } else if ((s[0] == '0') && ((s[1] == 'x') || (s[1] == 'X'))) {
+    len = 0;
+
+    for (s += 2; *s; s += 2) {
+      char hex[3] = {s[0], s[1], 0};
+      char* end;
+
+      unsigned long n = strtoul(hex, &end, 16);
+      if ((*end) || (end != hex + 2) || (len == size)) {
+        return false;
+      }
+
+      buf[len++] = static_cast<uint8_t>(n);
+    }
+
+    return (len > 0);
+  } else if ((IS_DIGIT(*s)) || ((*s == '-') && (IS_DIGIT(s[1])))) {
+    char* end;
+    errno = 0;
+    long long n = strtoll(s, &end, 10);
+    if ((*end) || (errno != 0) || (size < 8)) {
+      return false;
+    }
+
+    len = asn1::ber::encode_integer(n, buf);
+
+    return true;
+  }
+
+  return false;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s (--replace <path> <value> | --delete <path> | "
+          "--insert <path> <value>) ... --output <file> <filename>\n"
+          "\n"
+          "Edits the records without decoding and re-encoding them: only the\n"
+          "edited values and the lengths of the values which contain them\n"
+          "are rewritten. The edits are applied to each record in order; the\n"
+          "ones whose value is not found are skipped.\n"
+          "\n"
+          "Options:\n"
+          "  --replace <path> <value>  Replace the contents of the primitive\n"
+          "                            value at <path>.\n"
+          "  --delete <path>           Remove the value at <path>.\n"
+          "  --insert <path> <value>   Insert the encoded value <value>\n"
+          "                            (hexadecimal) as the last value of\n"
+          "                            the constructed value at <path>.\n"
+          "  --output <file>           Output file.\n"
+          "\n"
+          "<path>: \"[APPLICATION 1]/[3]/[UNIVERSAL 2]\".\n"
+          "<value>: integer, \"string\" or 0x<hexadecimal>.\n",
+          program);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* outname = nullptr;
+
+  asn1::ber::patch patch;
+
+  for (int i = 1; i < argc; i++) {
+    if (((strcmp(argv[i], "--replace") == 0) ||
+         (strcmp(argv[i], "--insert") == 0)) &&
+        (i + 2 < argc)) {
+      bool insert = (argv[i][2] == 'i');
+
+      asn1::ber::path p;
+      if (!p.parse(argv[++i])) {
+        fprintf(stderr, "Invalid path '%s'.\n", argv[i]);
+        return -1;
+      }
+
+      uint8_t value[4096];
+      size_t len;
+      if (!parse_value(argv[++i], value, sizeof(value), len)) {
+        fprintf(stderr, "Invalid value '%s'.\n", argv[i]);
+        return -1;
+      }
+
+      if (!(insert ?
+              patch.insert(p, value, len) :
+              patch.replace(p, value, len))) {
+        fprintf(stderr, "Invalid value '%s'.\n", argv[i]);
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--delete") == 0) && (i + 1 < argc)) {
+      asn1::ber::path p;
+      if ((!p.parse(argv[++i])) || (!patch.remove(p))) {
+        fprintf(stderr, "Invalid path '%s'.\n", argv[i]);
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      outname = argv[++i];
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if ((!filename) || (!outname) || (patch.size() == 0)) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  // (The output might be the input file.)
+  asn1::ber::output_file outfile;
+  if (!outfile.open(outname, file)) {
+    fprintf(stderr, "Error opening file '%s'.\n", outname);
+    return -1;
+  }
+
+  bool ret;
+
+  {
+    output out(outfile.fd());
+    ret = patch_records(file.data(), file.size(), patch, out);
+  }
+
+  if (!ret) {
+    return -1;
+  }
+
+  if (!outfile.close()) {
+    fprintf(stderr, "Error writing file '%s'.\n", outname);
+    return -1;
+  }
+
+  return 0;
+}
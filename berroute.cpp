@@ -0,0 +1,324 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <new>
+#include "asn1/ber/common.h"
+#include "asn1/ber/path.h"
+#include "asn1/ber/mapped_file.h"
+#include "asn1/ber/buffered_writer.h"
+
+// Maximum number of shards.
+static const unsigned long max_shards = 256;
+
+// Output of a shard.
+typedef asn1::ber::buffered_writer<256 * 1024> shard_writer;
+
+// Router of the records to the shards by the hash of the contents of the key.
+class router {
+  public:
+    // Constructor.
+    router(const asn1::ber::path& key, size_t nshards)
+      : _M_key(key),
+        _M_nshards(nshards)
+    {
+    }
+
+    // Destructor.
+    ~router();
+
+    // Create the shards ("<directory>/shard-<n>.ber").
+    bool open(const char* directory);
+
+    // Route the records of 'data'.
+    bool route(const uint8_t* data, size_t size);
+
+    // Flush and close the shards.
+    bool close();
+
+  private:
+    const asn1::ber::path& _M_key;
+
+    const size_t _M_nshards;
+
+    const char* _M_directory = nullptr;
+
+    int* _M_fds = nullptr;
+    shard_writer** _M_shards = nullptr;
+
+    // File for the records without key (created when needed).
+    int _M_unroutedfd = -1;
+    shard_writer* _M_unrouted = nullptr;
+
+    uint64_t _M_nrecords = 0;
+    uint64_t _M_nunrouted = 0;
+
+    // Create file.
+    bool create(const char* name, int& fd, shard_writer*& writer);
+
+    // Close file.
+    bool close(const char* name, int& fd, shard_writer*& writer);
+
+    // Hash (FNV-1a).
+    static uint64_t hash(const uint8_t* buf, uint64_t len)
+    {
+      uint64_t h = 0xcbf29ce484222325ull;
+
+      for (uint64_t i = 0; i < len; i++) {
+        h = (h ^ buf[i]) * 0x100000001b3ull;
+      }
+
+      return h;
+    }
+
+    // Disable copy constructor and assignment operator.
+    router(const router&) = delete;
+    router& operator=(const router&) = delete;
+};
+
+router::~router()
+{
+  if (_M_shards) {
+    for (size_t i = 0; i < _M_nshards; i++) {
+      delete _M_shards[i];
+
+      if (_M_fds[i] != -1) {
+        ::close(_M_fds[i]);
+      }
+    }
+
+    free(_M_shards);
+    free(_M_fds);
+  }
+
+  delete _M_unrouted;
+
+  if (_M_unroutedfd != -1) {
+    ::close(_M_unroutedfd);
+  }
+}
+
+bool router::open(const char* directory)
+{
+  _M_directory = directory;
+
+  if (((_M_fds = static_cast<int*>(
+                   malloc(_M_nshards * sizeof(int))
+                 )) == nullptr) ||
+      ((_M_shards = static_cast<shard_writer**>(
+                      calloc(_M_nshards, sizeof(shard_writer*))
+                    )) == nullptr)) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  for (size_t i = 0; i < _M_nshards; i++) {
+    _M_fds[i] = -1;
+  }
+
+  for (size_t i = 0; i < _M_nshards; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "shard-%04zu.ber", i);
+
+    if (!create(name, _M_fds[i], _M_shards[i])) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool router::route(const uint8_t* data, size_t size)
+{
+  size_t off = 0;
+
+  while (off < size) {
+    uint64_t len;
+    if ((len = asn1::ber::tlv_length(data + off, size - off)) == 0) {
+      fprintf(stderr,
+              "Error: invalid or incomplete record at offset: %zu.\n",
+              off);
+
+      return false;
+    }
+
+    // Only the headers of the values in the path of the key are decoded.
+    const uint8_t* value;
+    uint64_t valuelen;
+    shard_writer* shard;
+
+    if (asn1::ber::find(data + off, len, _M_key, value, valuelen)) {
+      shard = _M_shards[hash(value, valuelen) % _M_nshards];
+    } else {
+      if ((!_M_unrouted) &&
+          (!create("unrouted.ber", _M_unroutedfd, _M_unrouted))) {
+        return false;
+      }
+
+      shard = _M_unrouted;
+
+      _M_nunrouted++;
+    }
+
+    // The record is copied unchanged.
+    if (!shard->write(data + off, len)) {
+      fprintf(stderr, "Error writing shard.\n");
+      return false;
+    }
+
+    _M_nrecords++;
+
+    off += len;
+  }
+
+  return true;
+}
+
+bool router::close()
+{
+  bool ret = true;
+
+  for (size_t i = 0; i < _M_nshards; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "shard-%04zu.ber", i);
+
+    ret = ((close(name, _M_fds[i], _M_shards[i])) && (ret));
+  }
+
+  if (_M_unrouted) {
+    ret = ((close("unrouted.ber", _M_unroutedfd, _M_unrouted)) && (ret));
+  }
+
+  if (ret) {
+    fprintf(stderr,
+            "Records: %llu, unrouted: %llu.\n",
+            static_cast<unsigned long long>(_M_nrecords),
+            static_cast<unsigned long long>(_M_nunrouted));
+  }
+
+  return ret;
+}
+
+bool router::create(const char* name, int& fd, shard_writer*& writer)
+{
+  char filename[PATH_MAX];
+  if (snprintf(filename,
+               sizeof(filename),
+               "%s/%s",
+               _M_directory,
+               name) >= static_cast<int>(sizeof(filename))) {
+    fprintf(stderr, "Filename too long.\n");
+    return false;
+  }
+
+  if ((fd = ::open(filename, O_CREAT | O_TRUNC | O_WRONLY, 0644)) == -1) {
+    fprintf(stderr, "Error creating file '%s'.\n", filename);
+    return false;
+  }
+
+  if ((writer = new (std::nothrow) shard_writer(fd)) == nullptr) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  return true;
+}
+
+bool router::close(const char* name, int& fd, shard_writer*& writer)
+{
+  bool ret = writer->flush();
+
+  delete writer;
+  writer = nullptr;
+
+  ret = ((::close(fd) == 0) && (ret));
+  fd = -1;
+
+  if (!ret) {
+    fprintf(stderr, "Error writing file '%s/%s'.\n", _M_directory, name);
+  }
+
+  return ret;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s --key <path> --shards <n> --output <directory> "
+          "<filename>\n"
+          "\n"
+          "Copies each record unchanged to the shard given by the hash of the\n"
+          "contents of its key (<directory>/shard-<n>.ber). The records\n"
+          "without key are copied to <directory>/unrouted.ber.\n"
+          "\n"
+          "Options:\n"
+          "  --key <path>          Path of the key (\"[APPLICATION 1]/[3]\").\n"
+          "  --shards <n>          Number of shards (1 - %lu).\n"
+          "  --output <directory>  Output directory.\n",
+          program,
+          max_shards);
+}
+
+int main(int argc, const char** argv)
+{
+  const char* filename = nullptr;
+  const char* output = nullptr;
+  unsigned long nshards = 0;
+
+  asn1::ber::path key;
+  bool haskey = false;
+
+  for (int i = 1; i < argc; i++) {
+    if ((strcmp(argv[i], "--key") == 0) && (i + 1 < argc)) {
+      if (!key.parse(argv[++i])) {
+        fprintf(stderr, "Invalid path '%s'.\n", argv[i]);
+        return -1;
+      }
+
+      haskey = true;
+    } else if ((strcmp(argv[i], "--shards") == 0) && (i + 1 < argc)) {
+      char* end;
+      nshards = strtoul(argv[++i], &end, 10);
+      if ((*end) || (nshards < 1) || (nshards > max_shards)) {
+        usage(argv[0]);
+        return -1;
+      }
+    } else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc)) {
+      output = argv[++i];
+    } else if ((!filename) && (*argv[i] != '-')) {
+      filename = argv[i];
+    } else {
+      usage(argv[0]);
+      return -1;
+    }
+  }
+
+  if ((!filename) || (!output) || (!haskey) || (nshards == 0)) {
+    usage(argv[0]);
+    return -1;
+  }
+
+  asn1::ber::mapped_file file;
+  if (!file.open(filename)) {
+    fprintf(stderr, "Error opening file '%s'.\n", filename);
+    return -1;
+  }
+
+  // The file is read sequentially.
+  if (file.size() > 0) {
+    madvise(const_cast<uint8_t*>(file.data()), file.size(), MADV_SEQUENTIAL);
+  }
+
+  router r(key, nshards);
+
+  if ((!r.open(output)) ||
+      (!r.route(file.data(), file.size())) ||
+      (!r.close())) {
+    return -1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,1258 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "asn1/ber/decoder.h"
+#include "asn1/ber/encoder.h"
+#include "asn1/ber/memory_reader.h"
+#include "asn1/ber/null_object.h"
+
+using namespace asn1::ber;
+
+// glibc's allocator.
+extern "C" {
+  void* __libc_malloc(size_t size);
+  void* __libc_calloc(size_t nmemb, size_t size);
+  void* __libc_realloc(void* ptr, size_t size);
+  void __libc_free(void* ptr);
+}
+
+// Allocation counters (only updated while 'counting' is true).
+static bool counting = false;
+static uint64_t allocations = 0;
+static uint64_t allocated_bytes = 0;
+
+extern "C" void* malloc(size_t size)
+{
+  if (counting) {
+    allocations++;
+    allocated_bytes += size;
+  }
+
+  return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t nmemb, size_t size)
+{
+  if (counting) {
+    allocations++;
+    allocated_bytes += nmemb * size;
+  }
+
+  return __libc_calloc(nmemb, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+  if (counting) {
+    allocations++;
+    allocated_bytes += size;
+  }
+
+  return __libc_realloc(ptr, size);
+}
+
+extern "C" void free(void* ptr)
+{
+  __libc_free(ptr);
+}
+
+// Default baseline file.
+static const char* const default_baseline = "perf/baseline.txt";
+
+// Default number of runs per benchmark.
+static const unsigned default_runs = 15;
+
+// Default regression threshold (%).
+static const double default_threshold = 10.0;
+
+// Minimum duration of a run (nanoseconds).
+static const uint64_t min_run_time = 50000000ull;
+
+// Maximum number of benchmarks.
+static const size_t max_benchmarks = 32;
+
+// Size of the buffer of the calibration loop.
+static const size_t calibration_size = 1024 * 1024;
+
+static volatile size_t sink;
+
+// Corpora (generated by 'bergen', the output only depends on the
+// arguments).
+struct corpus {
+  const char* name;
+  const char* arguments;
+};
+
+static const corpus corpora[] = {
+  {
+    "small",
+    "--seed 1 --records 100000 --depth 2 --fanout 8 --string-size 0-16"
+  },
+  {
+    "nested",
+    "--seed 2 --records 20000 --depth 8 --fanout 4 --indefinite 30 "
+    "--explicit 30 --tags 0-1000"
+  },
+  {
+    "strings",
+    "--seed 3 --records 5000 --depth 2 --mix 5,80,5,5,5 "
+    "--string-size 0-4096 --string-distribution exponential"
+  }
+};
+
+// Get monotonic time in nanoseconds.
+static uint64_t now()
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (static_cast<uint64_t>(ts.tv_sec) * 1000000000ull) + ts.tv_nsec;
+}
+
+// Calibration loop: byte loads, a data-dependent branch and a multiply
+// chain (FNV-1a). The throughputs are saved relative to it so that a
+// baseline can be compared on other machines.
+static uint64_t calibration_loop(const uint8_t* data, size_t len)
+{
+  uint64_t hash = 14695981039346656037ull;
+  uint64_t count = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 1099511628211ull;
+
+    if (data[i] & 0x80) {
+      count++;
+    }
+  }
+
+  return hash + count;
+}
+
+// Reset the peak RSS of the process (if supported).
+static void reset_peak_rss()
+{
+  FILE* file;
+  if ((file = fopen("/proc/self/clear_refs", "w")) != nullptr) {
+    fputs("5", file);
+    fclose(file);
+  }
+}
+
+// Get the peak RSS of the process (KB).
+static uint64_t peak_rss()
+{
+  FILE* file;
+  if ((file = fopen("/proc/self/status", "r")) != nullptr) {
+    char line[256];
+    while (fgets(line, sizeof(line), file)) {
+      unsigned long long kb;
+      if (sscanf(line, "VmHWM: %llu kB", &kb) == 1) {
+        fclose(file);
+        return kb;
+      }
+    }
+
+    fclose(file);
+  }
+
+  struct rusage usage;
+  return (getrusage(RUSAGE_SELF, &usage) == 0) ? usage.ru_maxrss : 0;
+}
+
+// Array which grows by doubling.
+template<typename T>
+class array {
+  public:
+    // Constructor.
+    array() = default;
+
+    // Destructor.
+    ~array()
+    {
+      if (_M_data) {
+        free(_M_data);
+      }
+    }
+
+    // Append elements.
+    bool append(const T* elements, size_t count)
+    {
+      if (_M_used + count > _M_size) {
+        size_t size = (_M_size > 0) ? _M_size : 1024;
+        while (size < _M_used + count) {
+          size *= 2;
+        }
+
+        T* data;
+        if ((data = static_cast<T*>(realloc(_M_data, size * sizeof(T)))) ==
+            nullptr) {
+          return false;
+        }
+
+        _M_data = data;
+        _M_size = size;
+      }
+
+      memcpy(_M_data + _M_used, elements, count * sizeof(T));
+      _M_used += count;
+
+      return true;
+    }
+
+    // Get elements.
+    const T* data() const
+    {
+      return _M_data;
+    }
+
+    T* data()
+    {
+      return _M_data;
+    }
+
+    // Get number of elements.
+    size_t count() const
+    {
+      return _M_used;
+    }
+
+  private:
+    T* _M_data = nullptr;
+    size_t _M_size = 0;
+    size_t _M_used = 0;
+};
+
+// Operation of the encoder (recorded while decoding a corpus, replayed by
+// the encoder benchmarks).
+struct operation {
+  enum class type : uint8_t {
+    EndOfRecord,
+    StartConstructed,
+    EndConstructed,
+    Primitive,
+    Boolean,
+    Integer,
+    Null,
+    Oid,
+    Real,
+    Enumerated,
+    UtcTime,
+    GeneralizedTime
+  };
+
+  type t;
+  tag_class tc;
+  tag_number tn;
+
+  union {
+    int64_t n;
+    double d;
+  };
+
+  // Offset and length of the data (bytes for primitives, components for
+  // object identifiers).
+  size_t off;
+  size_t len;
+};
+
+// ASN.1 object which records the operations needed to encode the decoded
+// values.
+class recorder : public null_object {
+  public:
+    // Constructor.
+    recorder(array<operation>& operations,
+             array<uint8_t>& bytes,
+             array<uint64_t>& components)
+      : _M_operations(operations),
+        _M_bytes(bytes),
+        _M_components(components)
+    {
+    }
+
+    // Start constructed.
+    bool start_constructed(tag_class tc,
+                           tag_number tn,
+                           uint64_t valuelen,
+                           uint64_t totallen)
+    {
+      return add(operation::type::StartConstructed, tc, tn);
+    }
+
+    // End constructed.
+    bool end_constructed(tag_class tc, tag_number tn, uint64_t totallen)
+    {
+      return add(operation::type::EndConstructed, tc, tn);
+    }
+
+    // Boolean.
+    bool boolean(const void* buf, uint64_t len, bool val)
+    {
+      return add(operation::type::Boolean, val);
+    }
+
+    // Integer.
+    bool integer(const void* buf, uint64_t len, int64_t val)
+    {
+      return add(operation::type::Integer, val);
+    }
+
+    // Null.
+    bool null()
+    {
+      return add(operation::type::Null, 0);
+    }
+
+    // Object identifier.
+    bool oid(const void* buf,
+             uint64_t len,
+             const uint64_t* oid,
+             size_t ncomponents)
+    {
+      operation op;
+      op.t = operation::type::Oid;
+      op.off = _M_components.count();
+      op.len = ncomponents;
+
+      return ((_M_components.append(oid, ncomponents)) &&
+              (_M_operations.append(&op, 1)));
+    }
+
+    // Real.
+    bool real(const void* buf, uint64_t len, double val)
+    {
+      operation op;
+      op.t = operation::type::Real;
+      op.d = val;
+
+      return _M_operations.append(&op, 1);
+    }
+
+    // Enumerated.
+    bool enumerated(const void* buf, uint64_t len, int64_t val)
+    {
+      return add(operation::type::Enumerated, val);
+    }
+
+    // UTC time.
+    bool utc_time(const void* buf, uint64_t len, time_t val)
+    {
+      return add(operation::type::UtcTime, val);
+    }
+
+    // Generalized time.
+    bool generalized_time(const void* buf,
+                          uint64_t len,
+                          const struct timeval& val)
+    {
+      operation op;
+      op.t = operation::type::GeneralizedTime;
+      op.n = val.tv_sec;
+      op.off = val.tv_usec;
+
+      return _M_operations.append(&op, 1);
+    }
+
+    // Primitive.
+    bool primitive(tag_class tc,
+                   tag_number tn,
+                   const void* buf,
+                   uint64_t len,
+                   uint64_t valueoff,
+                   uint64_t valuelen)
+    {
+      // First fragment?
+      if (valueoff == 0) {
+        operation op;
+        op.t = operation::type::Primitive;
+        op.tc = tc;
+        op.tn = tn;
+        op.off = _M_bytes.count();
+        op.len = 0;
+
+        if (!_M_operations.append(&op, 1)) {
+          return false;
+        }
+      }
+
+      // The data might be in the decoder's buffer, copy it.
+      _M_operations.data()[_M_operations.count() - 1].len += len;
+
+      return _M_bytes.append(static_cast<const uint8_t*>(buf), len);
+    }
+
+    // End of record.
+    bool end_of_record()
+    {
+      return add(operation::type::EndOfRecord, 0);
+    }
+
+  private:
+    array<operation>& _M_operations;
+    array<uint8_t>& _M_bytes;
+    array<uint64_t>& _M_components;
+
+    // Add operation.
+    bool add(operation::type t, tag_class tc, tag_number tn)
+    {
+      operation op;
+      op.t = t;
+      op.tc = tc;
+      op.tn = tn;
+
+      return _M_operations.append(&op, 1);
+    }
+
+    bool add(operation::type t, int64_t n)
+    {
+      operation op;
+      op.t = t;
+      op.n = n;
+
+      return _M_operations.append(&op, 1);
+    }
+};
+
+// Corpus data.
+struct corpus_data {
+  // Encoded records.
+  array<uint8_t> encoded;
+  size_t records = 0;
+
+  // Recorded encoder operations.
+  array<operation> operations;
+  array<uint8_t> bytes;
+  array<uint64_t> components;
+};
+
+// Benchmark result.
+struct result {
+  char name[64];
+
+  // Throughput (MB/s): median and 95% confidence interval of the median.
+  double median;
+  double low;
+  double high;
+
+  // Median throughput relative to the calibration loop.
+  double relative;
+
+  // Records per second (median).
+  double records_per_second;
+
+  double allocations_per_record;
+  uint64_t peak_rss;
+};
+
+// Baseline entry.
+struct baseline_entry {
+  char name[64];
+
+  // Throughput relative to the calibration loop.
+  double relative;
+
+  double allocations_per_record;
+  uint64_t peak_rss;
+};
+
+class harness {
+  public:
+    // Constructor.
+    harness() = default;
+
+    // Destructor.
+    ~harness() = default;
+
+    // Parse arguments.
+    bool parse(int argc, const char** argv);
+
+    // Run benchmarks and compare the results with the baseline.
+    // Returns 0 if there are no regressions, 1 if there are regressions and
+    // -1 on error.
+    int run();
+
+  private:
+    const char* _M_baseline = default_baseline;
+    const char* _M_bergen = "./bergen";
+    const char* _M_filter = nullptr;
+
+    unsigned _M_runs = default_runs;
+    double _M_threshold = default_threshold;
+
+    bool _M_update = false;
+
+    // Throughput of the calibration loop (MB/s).
+    double _M_calibration = 0.0;
+
+    result _M_results[max_benchmarks];
+    size_t _M_nresults = 0;
+
+    baseline_entry _M_entries[max_benchmarks];
+    size_t _M_nentries = 0;
+
+    // Run benchmark?
+    bool selected(const char* name) const
+    {
+      return ((!_M_filter) || (strstr(name, _M_filter)));
+    }
+
+    // Measure the throughput of the calibration loop.
+    bool calibrate();
+
+    // Generate corpus.
+    bool generate(const corpus& c, corpus_data& data) const;
+
+    // Decoder benchmark.
+    bool decoder_benchmark(const char* name, const corpus_data& data);
+
+    // Encoder benchmark.
+    bool encoder_benchmark(const char* name, const corpus_data& data);
+
+    // Run benchmark: 'fn()' processes the corpus once and returns false on
+    // error.
+    template<typename Function>
+    bool measure(const char* name,
+                 size_t records,
+                 size_t bytes,
+                 Function fn);
+
+    // Run 'fn()' (which processes 'bytes' bytes) '_M_runs' times and sort
+    // the throughputs of the runs (MB/s).
+    template<typename Function>
+    bool sample(const char* name,
+                size_t bytes,
+                Function fn,
+                double* throughputs) const;
+
+    // Load baseline ('required' = false: a missing file is an empty
+    // baseline).
+    bool load_baseline(bool required);
+
+    // Merge the results into the baseline and save it.
+    bool save_baseline();
+
+    // Compare results with the baseline.
+    int compare() const;
+};
+
+bool harness::parse(int argc, const char** argv)
+{
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--update") == 0) {
+      _M_update = true;
+    } else if (i + 1 < argc) {
+      const char* arg = argv[++i];
+
+      if (strcmp(argv[i - 1], "--baseline") == 0) {
+        _M_baseline = arg;
+      } else if (strcmp(argv[i - 1], "--bergen") == 0) {
+        _M_bergen = arg;
+      } else if (strcmp(argv[i - 1], "--filter") == 0) {
+        _M_filter = arg;
+      } else if (strcmp(argv[i - 1], "--runs") == 0) {
+        char* end;
+        unsigned long runs = strtoul(arg, &end, 10);
+        if ((*end) || (runs < 3) || (runs > 1000)) {
+          return false;
+        }
+
+        _M_runs = runs;
+      } else if (strcmp(argv[i - 1], "--threshold") == 0) {
+        char* end;
+        double threshold = strtod(arg, &end);
+        if ((*end) || (threshold < 0.0) || (threshold >= 100.0)) {
+          return false;
+        }
+
+        _M_threshold = threshold;
+      } else {
+        return false;
+      }
+    } else {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+int harness::run()
+{
+  // (The entries of the baseline which are not run are kept by --update.)
+  if (!load_baseline(!_M_update)) {
+    return -1;
+  }
+
+  if (!calibrate()) {
+    return -1;
+  }
+
+  printf("%-20s %10s %21s %12s %10s %10s\n",
+         "benchmark",
+         "MB/s",
+         "95% CI",
+         "records/s",
+         "allocs/rec",
+         "peak RSS");
+
+  for (const corpus& c : corpora) {
+    char decoder_name[64];
+    char encoder_name[64];
+    snprintf(decoder_name, sizeof(decoder_name), "decoder/%s", c.name);
+    snprintf(encoder_name, sizeof(encoder_name), "encoder/%s", c.name);
+
+    if ((!selected(decoder_name)) && (!selected(encoder_name))) {
+      continue;
+    }
+
+    corpus_data data;
+    if (!generate(c, data)) {
+      return -1;
+    }
+
+    if ((selected(decoder_name)) &&
+        (!decoder_benchmark(decoder_name, data))) {
+      return -1;
+    }
+
+    if ((selected(encoder_name)) &&
+        (!encoder_benchmark(encoder_name, data))) {
+      return -1;
+    }
+  }
+
+  if (_M_update) {
+    return save_baseline() ? 0 : -1;
+  }
+
+  return compare();
+}
+
+bool harness::calibrate()
+{
+  uint8_t* data;
+  if ((data = static_cast<uint8_t*>(malloc(calibration_size))) == nullptr) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  // Fixed pseudo-random contents (xorshift64).
+  uint64_t x = 88172645463325252ull;
+  for (size_t i = 0; i < calibration_size; i++) {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    data[i] = static_cast<uint8_t>(x);
+  }
+
+  double throughputs[1000];
+
+  bool ret = sample("calibration", calibration_size, [&]() {
+    sink = calibration_loop(data, calibration_size);
+    return true;
+  }, throughputs);
+
+  free(data);
+
+  if (!ret) {
+    return false;
+  }
+
+  _M_calibration = (_M_runs % 2) ?
+                     throughputs[_M_runs / 2] :
+                     (throughputs[_M_runs / 2 - 1] +
+                      throughputs[_M_runs / 2]) / 2.0;
+
+  printf("%-20s %10.2f\n", "calibration", _M_calibration);
+
+  fflush(stdout);
+
+  return true;
+}
+
+bool harness::generate(const corpus& c, corpus_data& data) const
+{
+  char cmd[1024];
+  snprintf(cmd, sizeof(cmd), "%s %s", _M_bergen, c.arguments);
+
+  FILE* pipe;
+  if ((pipe = popen(cmd, "r")) == nullptr) {
+    fprintf(stderr, "Error running '%s'.\n", cmd);
+    return false;
+  }
+
+  uint8_t buf[64 * 1024];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), pipe)) > 0) {
+    if (!data.encoded.append(buf, n)) {
+      pclose(pipe);
+
+      fprintf(stderr, "Error allocating memory.\n");
+      return false;
+    }
+  }
+
+  if ((pclose(pipe) != 0) || (data.encoded.count() == 0)) {
+    fprintf(stderr,
+            "Error generating corpus '%s' ('%s'), build bergen with "
+            "'make -f Makefile.bergen'.\n",
+            c.name,
+            cmd);
+
+    return false;
+  }
+
+  // Decode the corpus once to count the records and to record the
+  // operations for the encoder benchmarks.
+  memory_reader reader(data.encoded.data(), data.encoded.count());
+  recorder obj(data.operations, data.bytes, data.components);
+
+  while (!reader.eof()) {
+    if ((decoder::decode(reader, obj)) && (obj.end_of_record())) {
+      data.records++;
+    } else {
+      fprintf(stderr,
+              "Error decoding corpus '%s' (offset: %llu).\n",
+              c.name,
+              static_cast<unsigned long long>(obj.error_offset()));
+
+      return false;
+    }
+  }
+
+  return true;
+}
+
+bool harness::decoder_benchmark(const char* name, const corpus_data& data)
+{
+  return measure(name, data.records, data.encoded.count(), [&]() {
+    memory_reader reader(data.encoded.data(), data.encoded.count());
+    null_object obj;
+
+    size_t count = 0;
+
+    while (!reader.eof()) {
+      if (decoder::decode(reader, obj)) {
+        count++;
+      } else {
+        return false;
+      }
+    }
+
+    sink = count;
+
+    return true;
+  });
+}
+
+bool harness::encoder_benchmark(const char* name, const corpus_data& data)
+{
+  // The re-encoded records use definite lengths, which might be longer than
+  // the indefinite lengths of the original records.
+  size_t size = 2 * data.encoded.count();
+
+  uint8_t* out;
+  if ((out = static_cast<uint8_t*>(malloc(size))) == nullptr) {
+    fprintf(stderr, "Error allocating memory.\n");
+    return false;
+  }
+
+  encoder<> e;
+
+  bool ret = measure(name, data.records, data.encoded.count(), [&]() {
+    const operation* op = data.operations.data();
+    const operation* end = op + data.operations.count();
+
+    size_t off = 0;
+
+    for (; op < end; op++) {
+      bool res;
+
+      switch (op->t) {
+        case operation::type::EndOfRecord:
+          off += e.encode_to(out + off, size - off);
+
+          e.clear();
+
+          res = true;
+          break;
+        case operation::type::StartConstructed:
+          if ((op->tc == tag_class::Universal) &&
+              (static_cast<universal_class>(op->tn) == universal_class::Set)) {
+            res = e.start_set(op->tc, tagging::Implicit, op->tn);
+          } else {
+            res = e.start_sequence(op->tc, tagging::Implicit, op->tn);
+          }
+
+          break;
+        case operation::type::EndConstructed:
+          if ((op->tc == tag_class::Universal) &&
+              (static_cast<universal_class>(op->tn) == universal_class::Set)) {
+            res = e.end_set();
+          } else {
+            res = e.end_sequence();
+          }
+
+          break;
+        case operation::type::Primitive:
+          // (Universal primitives without a typed callback are re-encoded
+          // as octet strings).
+          res = e.add_octetstring(op->tc,
+                                  tagging::Implicit,
+                                  op->tn,
+                                  data.bytes.data() + op->off,
+                                  op->len,
+                                  encoder<>::copy::Deep);
+
+          break;
+        case operation::type::Boolean:
+          res = e.add_boolean(tag_class::Universal,
+                              tagging::Implicit,
+                              0,
+                              op->n != 0);
+
+          break;
+        case operation::type::Integer:
+          res = e.add_integer(tag_class::Universal,
+                              tagging::Implicit,
+                              0,
+                              op->n);
+
+          break;
+        case operation::type::Null:
+          res = e.add_null(tag_class::Universal, tagging::Implicit, 0);
+          break;
+        case operation::type::Oid:
+          res = e.add_oid(tag_class::Universal,
+                          tagging::Implicit,
+                          0,
+                          data.components.data() + op->off,
+                          op->len);
+
+          break;
+        case operation::type::Real:
+          res = e.add_real(tag_class::Universal,
+                           tagging::Implicit,
+                           0,
+                           op->d);
+
+          break;
+        case operation::type::Enumerated:
+          res = e.add_enumerated(tag_class::Universal,
+                                 tagging::Implicit,
+                                 0,
+                                 op->n);
+
+          break;
+        case operation::type::UtcTime:
+          res = e.add_utc_time(tag_class::Universal,
+                               tagging::Implicit,
+                               0,
+                               static_cast<time_t>(op->n));
+
+          break;
+        case operation::type::GeneralizedTime:
+          {
+            struct timeval tv;
+            tv.tv_sec = op->n;
+            tv.tv_usec = op->off;
+
+            res = e.add_generalized_time(tag_class::Universal,
+                                         tagging::Implicit,
+                                         0,
+                                         tv);
+          }
+
+          break;
+        default:
+          res = false;
+      }
+
+      if (!res) {
+        return false;
+      }
+    }
+
+    sink = off;
+
+    return true;
+  });
+
+  free(out);
+
+  return ret;
+}
+
+template<typename Function>
+bool harness::measure(const char* name,
+                      size_t records,
+                      size_t bytes,
+                      Function fn)
+{
+  if (_M_nresults == max_benchmarks) {
+    fprintf(stderr, "Too many benchmarks.\n");
+    return false;
+  }
+
+  result& r = _M_results[_M_nresults];
+  snprintf(r.name, sizeof(r.name), "%s", name);
+
+  reset_peak_rss();
+
+  // Warm up (and count the allocations).
+  allocations = 0;
+  allocated_bytes = 0;
+
+  counting = true;
+  bool ok = fn();
+  counting = false;
+
+  if (!ok) {
+    fprintf(stderr, "Error running '%s'.\n", name);
+    return false;
+  }
+
+  r.allocations_per_record = (records > 0) ?
+                               static_cast<double>(allocations) / records :
+                               0.0;
+
+  double throughputs[1000];
+
+  if (!sample(name, bytes, fn, throughputs)) {
+    return false;
+  }
+
+  r.peak_rss = peak_rss();
+
+  // Median and distribution-free 95% confidence interval of the median
+  // (order statistics, normal approximation of the binomial distribution).
+  double n = _M_runs;
+  double half = 1.96 * sqrt(n) / 2.0;
+
+  long low = static_cast<long>(floor(n / 2.0 - half));
+  long high = static_cast<long>(ceil(n / 2.0 + half)) - 1;
+
+  if (low < 0) {
+    low = 0;
+  }
+
+  if (high > static_cast<long>(_M_runs) - 1) {
+    high = _M_runs - 1;
+  }
+
+  r.median = (_M_runs % 2) ?
+               throughputs[_M_runs / 2] :
+               (throughputs[_M_runs / 2 - 1] + throughputs[_M_runs / 2]) / 2.0;
+
+  r.low = throughputs[low];
+  r.high = throughputs[high];
+
+  r.relative = r.median / _M_calibration;
+
+  r.records_per_second = (r.median * 1000000.0 * records) / bytes;
+
+  char ci[32];
+  snprintf(ci, sizeof(ci), "[%.2f, %.2f]", r.low, r.high);
+
+  printf("%-20s %10.2f %21s %12.0f %10.2f %7llu KB\n",
+         r.name,
+         r.median,
+         ci,
+         r.records_per_second,
+         r.allocations_per_record,
+         static_cast<unsigned long long>(r.peak_rss));
+
+  fflush(stdout);
+
+  _M_nresults++;
+
+  return true;
+}
+
+template<typename Function>
+bool harness::sample(const char* name,
+                     size_t bytes,
+                     Function fn,
+                     double* throughputs) const
+{
+  for (unsigned i = 0; i < _M_runs; i++) {
+    uint64_t passes = 0;
+    uint64_t start = now();
+    uint64_t elapsed;
+
+    do {
+      if (!fn()) {
+        fprintf(stderr, "Error running '%s'.\n", name);
+        return false;
+      }
+
+      passes++;
+    } while ((elapsed = now() - start) < min_run_time);
+
+    throughputs[i] = (static_cast<double>(passes) * bytes * 1000.0) /
+                     static_cast<double>(elapsed);
+  }
+
+  qsort(throughputs, _M_runs, sizeof(double), [](const void* a,
+                                                 const void* b) {
+    double x = *static_cast<const double*>(a);
+    double y = *static_cast<const double*>(b);
+
+    return (x < y) ? -1 : (x > y);
+  });
+
+  return true;
+}
+
+bool harness::load_baseline(bool required)
+{
+  FILE* file;
+  if ((file = fopen(_M_baseline, "r")) == nullptr) {
+    if (!required) {
+      return true;
+    }
+
+    fprintf(stderr,
+            "Error opening baseline '%s' (use --update to create it).\n",
+            _M_baseline);
+
+    return false;
+  }
+
+  char line[256];
+  while (fgets(line, sizeof(line), file)) {
+    // Skip comments and empty lines.
+    if ((*line == '#') || (*line == '\n')) {
+      continue;
+    }
+
+    if (_M_nentries == max_benchmarks) {
+      fprintf(stderr, "Too many entries in '%s'.\n", _M_baseline);
+
+      fclose(file);
+      return false;
+    }
+
+    baseline_entry& entry = _M_entries[_M_nentries];
+    unsigned long long rss;
+
+    if (sscanf(line,
+               "%63s %lf %lf %llu",
+               entry.name,
+               &entry.relative,
+               &entry.allocations_per_record,
+               &rss) != 4) {
+      fprintf(stderr, "Invalid line in '%s': %s", _M_baseline, line);
+
+      fclose(file);
+      return false;
+    }
+
+    entry.peak_rss = rss;
+
+    _M_nentries++;
+  }
+
+  fclose(file);
+
+  return true;
+}
+
+bool harness::save_baseline()
+{
+  // Replace the entries which have been run and append the new ones.
+  for (size_t i = 0; i < _M_nresults; i++) {
+    const result& r = _M_results[i];
+
+    size_t j;
+    for (j = 0; j < _M_nentries; j++) {
+      if (strcmp(_M_entries[j].name, r.name) == 0) {
+        break;
+      }
+    }
+
+    if (j == _M_nentries) {
+      if (_M_nentries == max_benchmarks) {
+        fprintf(stderr, "Too many entries in '%s'.\n", _M_baseline);
+        return false;
+      }
+
+      _M_nentries++;
+    }
+
+    baseline_entry& entry = _M_entries[j];
+
+    snprintf(entry.name, sizeof(entry.name), "%s", r.name);
+    entry.relative = r.relative;
+    entry.allocations_per_record = r.allocations_per_record;
+    entry.peak_rss = r.peak_rss;
+  }
+
+  FILE* file;
+  if ((file = fopen(_M_baseline, "w")) == nullptr) {
+    fprintf(stderr, "Error opening '%s' for writing.\n", _M_baseline);
+    return false;
+  }
+
+  fprintf(file, "# Generated by 'perfcheck --update'.\n");
+  fprintf(file,
+          "# The throughputs are relative to the calibration loop.\n");
+  fprintf(file,
+          "# name relative_throughput allocations_per_record "
+          "peak_rss_kb\n");
+
+  for (size_t i = 0; i < _M_nentries; i++) {
+    const baseline_entry& entry = _M_entries[i];
+
+    fprintf(file,
+            "%s %.4f %.3f %llu\n",
+            entry.name,
+            entry.relative,
+            entry.allocations_per_record,
+            static_cast<unsigned long long>(entry.peak_rss));
+  }
+
+  if (fclose(file) != 0) {
+    fprintf(stderr, "Error writing '%s'.\n", _M_baseline);
+    return false;
+  }
+
+  printf("Baseline saved to '%s'.\n", _M_baseline);
+
+  return true;
+}
+
+int harness::compare() const
+{
+  double factor = _M_threshold / 100.0;
+  unsigned regressions = 0;
+
+  // (The throughputs are relative to the calibration loop.)
+  printf("\n%-20s %12s %12s %8s  %s\n",
+         "benchmark",
+         "baseline",
+         "current",
+         "change",
+         "status");
+
+  for (size_t i = 0; i < _M_nresults; i++) {
+    const result& r = _M_results[i];
+
+    const baseline_entry* entry = nullptr;
+    for (size_t j = 0; j < _M_nentries; j++) {
+      if (strcmp(_M_entries[j].name, r.name) == 0) {
+        entry = &_M_entries[j];
+        break;
+      }
+    }
+
+    if (!entry) {
+      printf("%-20s %12s %12.4f %8s  not in baseline\n",
+             r.name,
+             "-",
+             r.relative,
+             "-");
+
+      continue;
+    }
+
+    double change = (entry->relative > 0.0) ?
+                      ((r.relative / entry->relative) - 1.0) * 100.0 :
+                      0.0;
+
+    // The throughput has regressed if even the upper bound of the
+    // confidence interval is below the threshold.
+    const char* status = "ok";
+
+    if (r.high / _M_calibration < entry->relative * (1.0 - factor)) {
+      status = "THROUGHPUT REGRESSION";
+    } else if (r.allocations_per_record >
+               entry->allocations_per_record + 0.0005) {
+      // The allocations are deterministic.
+      status = "ALLOCATION REGRESSION";
+    } else if (static_cast<double>(r.peak_rss) >
+               static_cast<double>(entry->peak_rss) * (1.0 + factor)) {
+      status = "PEAK RSS REGRESSION";
+    }
+
+    printf("%-20s %12.4f %12.4f %+7.1f%%  %s\n",
+           r.name,
+           entry->relative,
+           r.relative,
+           change,
+           status);
+
+    if (strcmp(status, "ok") != 0) {
+      regressions++;
+
+      if (r.allocations_per_record >
+          entry->allocations_per_record + 0.0005) {
+        printf("%20s allocations/record: %.3f (baseline: %.3f)\n",
+               "",
+               r.allocations_per_record,
+               entry->allocations_per_record);
+      }
+
+      if (static_cast<double>(r.peak_rss) >
+          static_cast<double>(entry->peak_rss) * (1.0 + factor)) {
+        printf("%20s peak RSS: %llu KB (baseline: %llu KB)\n",
+               "",
+               static_cast<unsigned long long>(r.peak_rss),
+               static_cast<unsigned long long>(entry->peak_rss));
+      }
+    }
+  }
+
+  if (regressions > 0) {
+    printf("\n%u regression(s) (threshold: %.1f%%).\n",
+           regressions,
+           _M_threshold);
+
+    return 1;
+  }
+
+  printf("\nNo regressions (threshold: %.1f%%).\n", _M_threshold);
+
+  return 0;
+}
+
+static void usage(const char* program)
+{
+  fprintf(stderr,
+          "Usage: %s [OPTIONS]\n"
+          "\n"
+          "Runs the decoder and encoder benchmarks on generated corpora and\n"
+          "compares the results with a baseline (the throughputs relative to\n"
+          "a calibration loop).\n"
+          "\n"
+          "Options:\n"
+          "  --baseline <file>     Baseline file (default: %s).\n"
+          "  --update              Merge the results into the baseline.\n"
+          "  --threshold <percent> Regression threshold (default: %.0f).\n"
+          "  --runs <n>            Runs per benchmark (default: %u).\n"
+          "  --filter <substring>  Only run the matching benchmarks.\n"
+          "  --bergen <path>       Path of bergen (default: ./bergen).\n"
+          "\n"
+          "Exit status: 0 (no regressions), 1 (regressions), 255 (error).\n",
+          program,
+          default_baseline,
+          default_threshold,
+          default_runs);
+}
+
+int main(int argc, const char** argv)
+{
+  harness h;
+  if (h.parse(argc, argv)) {
+    return h.run();
+  }
+
+  usage(argv[0]);
+
+  return -1;
+}